@@ -11,3 +11,4 @@ set(WITH_CYCLES_BLENDER      OFF  CACHE BOOL "" FORCE)
 # build Cycles
 set(WITH_CYCLES_STANDALONE        ON CACHE BOOL "" FORCE)
 set(WITH_CYCLES_STANDALONE_GUI    ON CACHE BOOL "" FORCE)
+set(WITH_CYCLES_BENCHMARK         ON CACHE BOOL "" FORCE)
@@ -335,7 +335,7 @@ endif()
 
 if(WITH_OPENIMAGEIO)
   find_package_wrapper(OpenImageIO)
-  if(NOT OPENIMAGEIO_PUGIXML_FOUND AND WITH_CYCLES_STANDALONE)
+  if(NOT OPENIMAGEIO_PUGIXML_FOUND AND (WITH_CYCLES_STANDALONE OR WITH_CYCLES_BENCHMARK))
     find_package_wrapper(PugiXML)
   else()
     set(PUGIXML_INCLUDE_DIR "${OPENIMAGEIO_INCLUDE_DIR/OpenImageIO}")
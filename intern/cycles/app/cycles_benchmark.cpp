@@ -0,0 +1,667 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Headless benchmark of the Cycles CPU device.
+ *
+ * Renders a fixed suite of procedurally generated scenes, and optionally XML
+ * scene files, for a fixed number of samples and reports timing and memory
+ * statistics as JSON. The procedural scenes are deterministic so results can
+ * be compared between versions and machines. */
+
+#include <stdio.h>
+
+#include "device/device.h"
+#include "render/background.h"
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/graph.h"
+#include "render/hair.h"
+#include "render/light.h"
+#include "render/mesh.h"
+#include "render/nodes.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+#include "render/shader.h"
+
+#include "util/util_args.h"
+#include "util/util_foreach.h"
+#include "util/util_function.h"
+#include "util/util_guarded_allocator.h"
+#include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_math.h"
+#include "util/util_path.h"
+#include "util/util_string.h"
+#include "util/util_system.h"
+#include "util/util_time.h"
+#include "util/util_transform.h"
+#include "util/util_version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Resolution of the procedural scenes, when not passed on the command line. */
+#define BENCHMARK_DEFAULT_WIDTH 640
+#define BENCHMARK_DEFAULT_HEIGHT 360
+
+struct BenchmarkOptions {
+  /* Zero when not passed on the command line. */
+  int width, height;
+  int samples;
+  int threads;
+  int tile_size;
+  string scene_names;
+  string output_path;
+  vector<string> filepaths;
+} options;
+
+struct BenchmarkResult {
+  string name;
+  bool success;
+  string error;
+  int num_objects;
+  int num_lights;
+  double build_time;
+  double update_time;
+  double bvh_time;
+  double render_time;
+  size_t mem_peak;
+};
+
+/* Scene Building Utilities */
+
+static float benchmark_random(uint i, uint seed)
+{
+  return hash_uint2_to_float(i, seed);
+}
+
+static Shader *benchmark_add_shader(Scene *scene, const char *name, ShaderGraph *graph)
+{
+  Shader *shader = new Shader();
+  shader->name = name;
+  shader->set_graph(graph);
+  shader->tag_update(scene);
+  scene->shaders.push_back(shader);
+  return shader;
+}
+
+static Shader *benchmark_add_diffuse_shader(Scene *scene, float3 color)
+{
+  ShaderGraph *graph = new ShaderGraph();
+  DiffuseBsdfNode *diffuse = (DiffuseBsdfNode *)graph->add(new DiffuseBsdfNode());
+  diffuse->color = color;
+  graph->connect(diffuse->output("BSDF"), graph->output()->input("Surface"));
+  return benchmark_add_shader(scene, "diffuse", graph);
+}
+
+static Object *benchmark_add_object(Scene *scene, Geometry *geom, const Transform &tfm)
+{
+  Object *object = new Object();
+  object->geometry = geom;
+  object->tfm = tfm;
+  scene->objects.push_back(object);
+  return object;
+}
+
+/* Grid of resolution x resolution quads in the XY plane, covering [-1, 1]. */
+static Mesh *benchmark_add_grid_mesh(Scene *scene, Shader *shader, int resolution)
+{
+  Mesh *mesh = new Mesh();
+  mesh->used_shaders.push_back(shader);
+  scene->geometry.push_back(mesh);
+
+  const int num_verts = (resolution + 1) * (resolution + 1);
+  mesh->reserve_mesh(num_verts, resolution * resolution * 2);
+
+  for (int y = 0; y <= resolution; y++) {
+    for (int x = 0; x <= resolution; x++) {
+      mesh->add_vertex(
+          make_float3(2.0f * x / resolution - 1.0f, 2.0f * y / resolution - 1.0f, 0.0f));
+    }
+  }
+
+  for (int y = 0; y < resolution; y++) {
+    for (int x = 0; x < resolution; x++) {
+      const int v0 = y * (resolution + 1) + x;
+      const int v1 = v0 + 1;
+      const int v2 = v0 + resolution + 2;
+      const int v3 = v0 + resolution + 1;
+      mesh->add_triangle(v0, v1, v2, 0, true);
+      mesh->add_triangle(v0, v2, v3, 0, true);
+    }
+  }
+
+  return mesh;
+}
+
+/* Axis aligned cube covering [-1, 1]. */
+static Mesh *benchmark_add_cube_mesh(Scene *scene, Shader *shader)
+{
+  static const int faces[6][4] = {
+      {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+
+  Mesh *mesh = new Mesh();
+  mesh->used_shaders.push_back(shader);
+  scene->geometry.push_back(mesh);
+
+  mesh->reserve_mesh(8, 12);
+
+  for (int i = 0; i < 8; i++) {
+    mesh->add_vertex(make_float3((i & 1) ? 1.0f : -1.0f,
+                                 (i & 2) ? 1.0f : -1.0f,
+                                 (i & 4) ? 1.0f : -1.0f));
+  }
+
+  for (int i = 0; i < 6; i++) {
+    mesh->add_triangle(faces[i][0], faces[i][1], faces[i][2], 0, false);
+    mesh->add_triangle(faces[i][0], faces[i][2], faces[i][3], 0, false);
+  }
+
+  return mesh;
+}
+
+static void benchmark_add_ground(Scene *scene)
+{
+  Shader *shader = benchmark_add_diffuse_shader(scene, make_float3(0.8f, 0.8f, 0.8f));
+  Mesh *mesh = benchmark_add_grid_mesh(scene, shader, 1);
+  benchmark_add_object(
+      scene, mesh, transform_translate(0.0f, 0.0f, 1.0f) * transform_scale(20.0f, 20.0f, 1.0f));
+}
+
+/* Common camera and world setup. The camera looks down the positive Z axis,
+ * scenes are built around the origin in front of the ground plane at Z = 1. */
+static void benchmark_scene_init(Scene *scene)
+{
+  Camera *cam = scene->camera;
+  cam->matrix = transform_translate(0.0f, 0.0f, -8.0f);
+  cam->width = (options.width != 0) ? options.width : BENCHMARK_DEFAULT_WIDTH;
+  cam->height = (options.height != 0) ? options.height : BENCHMARK_DEFAULT_HEIGHT;
+  cam->compute_auto_viewplane();
+
+  ShaderGraph *graph = new ShaderGraph();
+  BackgroundNode *bg = (BackgroundNode *)graph->add(new BackgroundNode());
+  bg->color = make_float3(0.6f, 0.7f, 0.8f);
+  bg->strength = 1.0f;
+  graph->connect(bg->output("Background"), graph->output()->input("Surface"));
+
+  Shader *shader = scene->default_background;
+  shader->set_graph(graph);
+  shader->tag_update(scene);
+}
+
+/* Procedural Scenes */
+
+/* Many instances of a single mesh, stressing the top level BVH and instancing. */
+static void benchmark_scene_instances(Scene *scene)
+{
+  Shader *shader = benchmark_add_diffuse_shader(scene, make_float3(0.8f, 0.5f, 0.3f));
+  Mesh *mesh = benchmark_add_grid_mesh(scene, shader, 16);
+
+  const int num_side = 100;
+  for (int i = 0; i < num_side * num_side; i++) {
+    const float x = (float)(i % num_side) / (num_side - 1) * 8.0f - 4.0f;
+    const float y = (float)(i / num_side) / (num_side - 1) * 8.0f - 4.0f;
+    const float angle = benchmark_random(i, 0) * M_2PI_F;
+    const float scale = 0.02f + 0.04f * benchmark_random(i, 1);
+
+    Transform tfm = transform_translate(x, y, 0.5f * benchmark_random(i, 2)) *
+                    transform_rotate(angle, normalize(make_float3(1.0f, 1.0f, 0.5f))) *
+                    transform_scale(scale, scale, scale);
+    benchmark_add_object(scene, mesh, tfm);
+  }
+
+  benchmark_add_ground(scene);
+}
+
+/* Dense hair curves, stressing curve intersection and unaligned BVH nodes. */
+static void benchmark_scene_hair(Scene *scene)
+{
+  Shader *shader = benchmark_add_diffuse_shader(scene, make_float3(0.4f, 0.3f, 0.2f));
+
+  Hair *hair = new Hair();
+  hair->used_shaders.push_back(shader);
+  scene->geometry.push_back(hair);
+
+  const int num_curves = 200000;
+  const int num_keys = 8;
+  hair->reserve_curves(num_curves, num_curves * num_keys);
+
+  for (int i = 0; i < num_curves; i++) {
+    const float3 root = make_float3(benchmark_random(i, 0) * 6.0f - 3.0f,
+                                    benchmark_random(i, 1) * 6.0f - 3.0f,
+                                    0.9f);
+    const float3 bend = make_float3(
+        benchmark_random(i, 2) - 0.5f, benchmark_random(i, 3) - 0.5f, -1.0f);
+
+    const int first_key = hair->num_keys();
+    for (int k = 0; k < num_keys; k++) {
+      const float t = (float)k / (num_keys - 1);
+      const float3 co = root + bend * make_float3(t * t, t * t, t) * 0.6f;
+      hair->add_curve_key(co, 0.004f * (1.0f - 0.8f * t));
+    }
+    hair->add_curve(first_key, 0);
+  }
+
+  benchmark_add_object(scene, hair, transform_identity());
+  benchmark_add_ground(scene);
+}
+
+/* Many small point lights, stressing light sampling and the light distribution. */
+static void benchmark_scene_lights(Scene *scene)
+{
+  Shader *shader = benchmark_add_diffuse_shader(scene, make_float3(0.8f, 0.8f, 0.8f));
+  Mesh *mesh = benchmark_add_cube_mesh(scene, shader);
+
+  for (int i = 0; i < 64; i++) {
+    const float x = (float)(i % 8) - 3.5f;
+    const float y = (float)(i / 8) - 3.5f;
+    benchmark_add_object(
+        scene, mesh, transform_translate(x, y, 0.7f) * transform_scale(0.3f, 0.3f, 0.3f));
+  }
+
+  const int num_lights = 2000;
+  for (int i = 0; i < num_lights; i++) {
+    Light *light = new Light();
+    light->type = LIGHT_POINT;
+    light->co = make_float3(benchmark_random(i, 0) * 10.0f - 5.0f,
+                            benchmark_random(i, 1) * 10.0f - 5.0f,
+                            -benchmark_random(i, 2) * 2.0f);
+    light->size = 0.05f;
+    light->strength = make_float3(benchmark_random(i, 3),
+                                  benchmark_random(i, 4),
+                                  benchmark_random(i, 5)) *
+                      5.0f;
+    light->shader = scene->default_light;
+    light->tag_update(scene);
+    scene->lights.push_back(light);
+  }
+
+  benchmark_add_ground(scene);
+}
+
+/* Homogeneous and textured scattering volumes. */
+static void benchmark_scene_volume(Scene *scene)
+{
+  ShaderGraph *graph = new ShaderGraph();
+  NoiseTextureNode *noise = (NoiseTextureNode *)graph->add(new NoiseTextureNode());
+  noise->scale = 3.0f;
+  noise->detail = 4.0f;
+  PrincipledVolumeNode *volume = (PrincipledVolumeNode *)graph->add(new PrincipledVolumeNode());
+  volume->color = make_float3(0.8f, 0.8f, 0.9f);
+  graph->connect(noise->output("Fac"), volume->input("Density"));
+  graph->connect(volume->output("Volume"), graph->output()->input("Volume"));
+  Shader *shader = benchmark_add_shader(scene, "volume", graph);
+
+  Mesh *mesh = benchmark_add_cube_mesh(scene, shader);
+  Attribute *attr = mesh->attributes.add(ATTR_STD_GENERATED);
+  memcpy(attr->data_float3(), mesh->verts.data(), sizeof(float3) * mesh->verts.size());
+
+  benchmark_add_object(scene, mesh, transform_scale(2.0f, 2.0f, 0.8f));
+  benchmark_add_ground(scene);
+}
+
+/* True displacement of a dense grid, stressing displacement shader evaluation
+ * and building the BVH for many small triangles. */
+static void benchmark_scene_displacement(Scene *scene)
+{
+  ShaderGraph *graph = new ShaderGraph();
+  NoiseTextureNode *noise = (NoiseTextureNode *)graph->add(new NoiseTextureNode());
+  noise->scale = 4.0f;
+  noise->detail = 8.0f;
+  DisplacementNode *disp = (DisplacementNode *)graph->add(new DisplacementNode());
+  disp->scale = 0.5f;
+  DiffuseBsdfNode *diffuse = (DiffuseBsdfNode *)graph->add(new DiffuseBsdfNode());
+  graph->connect(noise->output("Fac"), disp->input("Height"));
+  graph->connect(disp->output("Displacement"), graph->output()->input("Displacement"));
+  graph->connect(diffuse->output("BSDF"), graph->output()->input("Surface"));
+  Shader *shader = benchmark_add_shader(scene, "displacement", graph);
+  shader->displacement_method = DISPLACE_TRUE;
+
+  Mesh *mesh = benchmark_add_grid_mesh(scene, shader, 1000);
+  Attribute *attr = mesh->attributes.add(ATTR_STD_GENERATED);
+  memcpy(attr->data_float3(), mesh->verts.data(), sizeof(float3) * mesh->verts.size());
+
+  benchmark_add_object(scene, mesh, transform_scale(4.0f, 4.0f, 1.0f));
+}
+
+struct BenchmarkScene {
+  const char *name;
+  void (*build)(Scene *scene);
+};
+
+static const BenchmarkScene benchmark_scenes[] = {
+    {"instances", benchmark_scene_instances},
+    {"hair", benchmark_scene_hair},
+    {"lights", benchmark_scene_lights},
+    {"volume", benchmark_scene_volume},
+    {"displacement", benchmark_scene_displacement},
+};
+
+static const int num_benchmark_scenes = sizeof(benchmark_scenes) / sizeof(*benchmark_scenes);
+
+static void benchmark_scene_xml(Scene *scene, const string &filepath)
+{
+  xml_read_file(scene, filepath.c_str());
+
+  /* Keep the resolution of the file, unless it was passed on the command line. */
+  if (options.width != 0) {
+    scene->camera->width = options.width;
+  }
+  if (options.height != 0) {
+    scene->camera->height = options.height;
+  }
+  scene->camera->compute_auto_viewplane();
+}
+
+/* Benchmark Run */
+
+static bool benchmark_run(const string &name,
+                          const function<void(Scene *)> &build,
+                          BenchmarkResult &result)
+{
+  result.name = name;
+  result.success = false;
+
+  SessionParams session_params;
+  session_params.background = true;
+  session_params.samples = options.samples;
+  session_params.threads = options.threads;
+  session_params.tile_size = make_int2(options.tile_size, options.tile_size);
+
+  vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK_CPU);
+  if (devices.empty()) {
+    result.error = "No CPU device available";
+    return false;
+  }
+  session_params.device = devices.front();
+
+  Session *session = new Session(session_params);
+
+  SceneParams scene_params;
+  scene_params.bvh_type = SceneParams::BVH_STATIC;
+  Scene *scene = new Scene(scene_params, session->device);
+
+  {
+    scoped_timer timer(&result.build_time);
+    benchmark_scene_init(scene);
+    build(scene);
+  }
+
+  result.num_objects = scene->objects.size();
+  result.num_lights = scene->lights.size();
+
+  session->scene = scene;
+
+  BufferParams buffer_params;
+  buffer_params.width = scene->camera->width;
+  buffer_params.height = scene->camera->height;
+  buffer_params.full_width = scene->camera->width;
+  buffer_params.full_height = scene->camera->height;
+
+  session->reset(buffer_params, options.samples);
+  session->start();
+  session->wait();
+
+  double total_time;
+  session->progress.get_time(total_time, result.render_time);
+
+  result.update_time = scene->update_times.total;
+  result.bvh_time = scene->update_times.bvh;
+  result.mem_peak = session->stats.mem_peak;
+
+  if (session->progress.get_error()) {
+    result.error = session->progress.get_error_message();
+  }
+  else {
+    result.success = true;
+  }
+
+  /* Session owns the scene. */
+  delete session;
+
+  return result.success;
+}
+
+/* Report */
+
+static string json_escape(const string &str)
+{
+  string result;
+  foreach (char c, str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += string_printf("\\u%04x", (int)c);
+    }
+    else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+static string benchmark_report_json(const vector<BenchmarkResult> &results)
+{
+  string json = "{\n";
+  json += string_printf("  \"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+  json += string_printf("  \"cpu\": \"%s\",\n", json_escape(system_cpu_brand_string()).c_str());
+  json += string_printf("  \"threads\": %d,\n",
+                        (options.threads) ? options.threads : system_cpu_thread_count());
+  json += string_printf("  \"samples\": %d,\n", options.samples);
+  json += string_printf("  \"host_mem_peak\": %zu,\n", util_guarded_get_mem_peak());
+  json += "  \"scenes\": [\n";
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchmarkResult &result = results[i];
+    json += "    {\n";
+    json += string_printf("      \"name\": \"%s\",\n", json_escape(result.name).c_str());
+    if (!result.success) {
+      json += string_printf("      \"error\": \"%s\"\n", json_escape(result.error).c_str());
+    }
+    else {
+      const double samples_per_second = (result.render_time > 0.0) ?
+                                            options.samples / result.render_time :
+                                            0.0;
+      json += string_printf("      \"objects\": %d,\n", result.num_objects);
+      json += string_printf("      \"lights\": %d,\n", result.num_lights);
+      json += string_printf("      \"build_time\": %f,\n", result.build_time);
+      json += string_printf("      \"scene_update_time\": %f,\n", result.update_time);
+      json += string_printf("      \"bvh_build_time\": %f,\n", result.bvh_time);
+      json += string_printf("      \"render_time\": %f,\n", result.render_time);
+      json += string_printf("      \"samples_per_second\": %f,\n", samples_per_second);
+      json += string_printf("      \"mem_peak\": %zu\n", result.mem_peak);
+    }
+    json += (i + 1 < results.size()) ? "    },\n" : "    }\n";
+  }
+
+  json += "  ]\n}\n";
+  return json;
+}
+
+/* Options */
+
+static int files_parse(int argc, const char *argv[])
+{
+  for (int i = 0; i < argc; i++) {
+    options.filepaths.push_back(argv[i]);
+  }
+
+  return 0;
+}
+
+static void options_parse(int argc, const char **argv)
+{
+  options.width = 0;
+  options.height = 0;
+  options.samples = 16;
+  options.threads = 0;
+  options.tile_size = 32;
+  options.scene_names = "all";
+
+  string scene_names_help = "Comma separated procedural scenes to render, or all or none: ";
+  for (int i = 0; i < num_benchmark_scenes; i++) {
+    scene_names_help += (i == 0) ? "" : ", ";
+    scene_names_help += benchmark_scenes[i].name;
+  }
+
+  ArgParse ap;
+  bool help = false, debug = false, version = false;
+  int verbosity = 1;
+
+  ap.options("Usage: cycles_benchmark [options] [file.xml ...]",
+             "%*",
+             files_parse,
+             "",
+             "--scenes %s",
+             &options.scene_names,
+             scene_names_help.c_str(),
+             "--samples %d",
+             &options.samples,
+             "Number of samples to render",
+             "--threads %d",
+             &options.threads,
+             "CPU Rendering Threads",
+             "--width %d",
+             &options.width,
+             "Image width in pixels, instead of 640 or the one of the scene file",
+             "--height %d",
+             &options.height,
+             "Image height in pixels, instead of 360 or the one of the scene file",
+             "--tile-size %d",
+             &options.tile_size,
+             "Tile size in pixels",
+             "--output %s",
+             &options.output_path,
+             "File path to write the JSON report to, instead of standard output",
+#ifdef WITH_CYCLES_LOGGING
+             "--debug",
+             &debug,
+             "Enable debug logging",
+             "--verbose %d",
+             &verbosity,
+             "Set verbosity of the logger",
+#endif
+             "--help",
+             &help,
+             "Print help message",
+             "--version",
+             &version,
+             "Print version number",
+             NULL);
+
+  if (ap.parse(argc, argv) < 0) {
+    fprintf(stderr, "%s\n", ap.geterror().c_str());
+    ap.usage();
+    exit(EXIT_FAILURE);
+  }
+
+  if (debug) {
+    util_logging_start();
+    util_logging_verbosity_set(verbosity);
+  }
+
+  if (version) {
+    printf("%s\n", CYCLES_VERSION_STRING);
+    exit(EXIT_SUCCESS);
+  }
+  else if (help) {
+    ap.usage();
+    exit(EXIT_SUCCESS);
+  }
+
+  if (options.samples <= 0) {
+    fprintf(stderr, "Invalid number of samples: %d\n", options.samples);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.width < 0 || options.height < 0) {
+    fprintf(stderr, "Invalid resolution: %dx%d\n", options.width, options.height);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.tile_size <= 0) {
+    fprintf(stderr, "Invalid tile size: %d\n", options.tile_size);
+    exit(EXIT_FAILURE);
+  }
+}
+
+static bool scene_name_enabled(const char *name)
+{
+  if (options.scene_names == "all") {
+    return true;
+  }
+
+  vector<string> names;
+  string_split(names, options.scene_names, ",");
+  foreach (const string &enabled_name, names) {
+    if (enabled_name == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+  util_logging_init(argv[0]);
+  path_init();
+  options_parse(argc, argv);
+
+  vector<BenchmarkResult> results;
+  bool success = true;
+
+  for (int i = 0; i < num_benchmark_scenes; i++) {
+    if (!scene_name_enabled(benchmark_scenes[i].name)) {
+      continue;
+    }
+
+    fprintf(stderr, "Rendering %s...\n", benchmark_scenes[i].name);
+    BenchmarkResult result;
+    success &= benchmark_run(benchmark_scenes[i].name, benchmark_scenes[i].build, result);
+    results.push_back(result);
+  }
+
+  foreach (const string &filepath, options.filepaths) {
+    fprintf(stderr, "Rendering %s...\n", filepath.c_str());
+    BenchmarkResult result;
+    success &= benchmark_run(
+        path_filename(filepath), function_bind(&benchmark_scene_xml, _1, filepath), result);
+    results.push_back(result);
+  }
+
+  const string report = benchmark_report_json(results);
+
+  if (options.output_path.empty()) {
+    fputs(report.c_str(), stdout);
+  }
+  else {
+    FILE *f = path_fopen(options.output_path, "wb");
+    if (!f) {
+      fprintf(stderr, "Failed to write report to %s\n", options.output_path.c_str());
+      return EXIT_FAILURE;
+    }
+    fputs(report.c_str(), f);
+    fclose(f);
+  }
+
+  return (success) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -665,6 +665,20 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         "but time can be saved by manually stopping the render when the noise is low enough)",
         default=False,
     )
+    progressive_round_time: FloatProperty(
+        name="Round Time",
+        description="With progressive refine, render as many samples per round over the whole image "
+        "as fit in this time, in seconds (0 renders a single sample per round)",
+        min=0.0, soft_max=60.0,
+        default=0.0,
+    )
+    checkpoint_directory: StringProperty(
+        name="Checkpoint Directory",
+        description="With progressive refine, write the render buffers to this directory after each round, "
+        "so an interrupted render of the same frame continues where it stopped",
+        default="",
+        subtype='DIR_PATH',
+    )
 
     bake_type: EnumProperty(
         name="Bake Type",
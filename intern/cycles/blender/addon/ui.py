@@ -676,6 +676,11 @@ class CYCLES_RENDER_PT_performance_tiles(CyclesButtonsPanel, Panel):
         sub.active = not rd.use_save_buffers
         sub.prop(cscene, "use_progressive_refine")
 
+        sub = col.column()
+        sub.active = not rd.use_save_buffers and cscene.use_progressive_refine
+        sub.prop(cscene, "progressive_round_time")
+        sub.prop(cscene, "checkpoint_directory")
+
 
 class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Panel):
     bl_label = "Acceleration Structure"
@@ -24,14 +24,82 @@
 #include "blender/blender_util.h"
 
 #include "util/util_foreach.h"
+#include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_murmurhash.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Geometry Sync Statistics */
+
+static const char *geometry_sync_type_name(GeometrySyncStats::Type type)
+{
+  switch (type) {
+    case GeometrySyncStats::MESH:
+      return "Mesh";
+    case GeometrySyncStats::HAIR:
+      return "Hair";
+    case GeometrySyncStats::VOLUME:
+      return "Volume";
+    case GeometrySyncStats::NUM_TYPES:
+      break;
+  }
+  return "Unknown";
+}
+
+GeometrySyncStats::GeometrySyncStats()
+{
+  reset();
+}
+
+void GeometrySyncStats::reset()
+{
+  thread_scoped_lock lock(mutex);
+  for (int i = 0; i < NUM_TYPES; i++) {
+    time[i] = 0.0;
+    count[i] = 0;
+  }
+}
+
+void GeometrySyncStats::add(Type type, double elapsed)
+{
+  thread_scoped_lock lock(mutex);
+  time[type] += elapsed;
+  count[type]++;
+}
+
+string GeometrySyncStats::full_report()
+{
+  thread_scoped_lock lock(mutex);
+  string report;
+  for (int i = 0; i < NUM_TYPES; i++) {
+    if (count[i] == 0) {
+      continue;
+    }
+    report += string_printf("  %-7s %6d geometries in %.4f seconds\n",
+                            geometry_sync_type_name((Type)i),
+                            count[i],
+                            time[i]);
+  }
+  return report;
+}
+
+/* Geometry Sync
+ *
+ * Finding out which geometry needs to be synced happens on the main thread while
+ * iterating over the depsgraph, the conversion of the Blender data itself is then
+ * deferred to a task pool. The conversion only reads RNA data, with the exception
+ * of mesh evaluation through object_to_mesh(), which is local to the object being
+ * converted. Instances are converted right away, see sync_object(). */
+
 Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
                                      BL::Object &b_ob,
                                      BL::Object &b_ob_instance,
                                      bool object_updated,
-                                     bool use_particle_hair)
+                                     bool use_particle_hair,
+                                     TaskPool *task_pool)
 {
   /* Test if we can instance or if the object is modified. */
   BL::ID b_ob_data = b_ob.data();
@@ -87,6 +155,12 @@ Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
     geometry_map.add(key, geom);
   }
   else {
+    /* Ensure we only sync instanced geometry once. This is checked before looking
+     * at the geometry itself, since it may be getting synced by a task already. */
+    if (geometry_synced.find(geom) != geometry_synced.end()) {
+      return geom;
+    }
+
     /* Test if we need to update existing geometry. */
     sync = geometry_map.update(geom, b_key_id);
   }
@@ -113,21 +187,65 @@ Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
       }
 
       if (!attribute_recalc) {
+        /* Remember how to sync deduplicated geometry, in case its source changes. This
+         * happens after object iteration, so an instance is synced from the evaluated object
+         * it instances rather than from the temporary object of the iterator. */
+        map<Geometry *, GeometryDedupProxy>::iterator it = geometry_dedup.find(geom);
+        if (it != geometry_dedup.end()) {
+          it->second.used = true;
+          it->second.b_ob = b_ob_instance;
+          it->second.used_shaders = used_shaders;
+        }
         return geom;
       }
     }
   }
 
-  /* Ensure we only sync instanced geometry once. */
-  if (geometry_synced.find(geom) != geometry_synced.end()) {
-    return geom;
+  geometry_synced.insert(geom);
+  geometry_dedup.erase(geom);
+  geometry_dedup_hash.erase(geom);
+
+  geom->name = ustring(b_ob_data.name().c_str());
+
+  /* Tag the geometry here already, the object sync reads the tag before the task that
+   * converts the geometry has finished. */
+  geom->need_update = true;
+
+  /* Fluid motion export sizes attributes by the motion steps that the object sync sets
+   * after this call, so keep it on the main thread in the same order as before. */
+  if (task_pool && !object_fluid_liquid_domain_find(b_ob)) {
+    if (use_particle_hair) {
+      /* Particle hair evaluates the mesh of the same object as the surface geometry,
+       * run it after the surface geometry tasks are done. */
+      deferred_geometry_sync.push_back(function_bind(
+          &BlenderSync::sync_geometry_task, this, b_depsgraph, b_ob, geom, used_shaders, true));
+    }
+    else {
+      task_pool->push(function_bind(
+          &BlenderSync::sync_geometry_task, this, b_depsgraph, b_ob, geom, used_shaders, false));
+    }
+  }
+  else {
+    sync_geometry_task(b_depsgraph, b_ob, geom, used_shaders, use_particle_hair);
   }
 
-  progress.set_sync_status("Synchronizing object", b_ob.name());
+  return geom;
+}
 
-  geometry_synced.insert(geom);
+void BlenderSync::sync_geometry_task(BL::Depsgraph b_depsgraph,
+                                     BL::Object b_ob,
+                                     Geometry *geom,
+                                     vector<Shader *> used_shaders,
+                                     bool use_particle_hair)
+{
+  if (progress.get_cancel()) {
+    return;
+  }
 
-  geom->name = ustring(b_ob_data.name().c_str());
+  progress.set_sync_status("Synchronizing object", b_ob.name());
+
+  scoped_timer timer;
+  GeometrySyncStats::Type stats_type;
 
 #ifdef WITH_NEW_OBJECT_TYPES
   if (b_ob.type() == BL::Object::type_HAIR || use_particle_hair) {
@@ -135,24 +253,40 @@ Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
   if (use_particle_hair) {
 #endif
     sync_hair(b_depsgraph, b_ob, geom, used_shaders);
+    stats_type = GeometrySyncStats::HAIR;
   }
   else if (b_ob.type() == BL::Object::type_VOLUME || object_fluid_gas_domain_find(b_ob)) {
     Mesh *mesh = static_cast<Mesh *>(geom);
     sync_volume(b_ob, mesh, used_shaders);
+    stats_type = GeometrySyncStats::VOLUME;
   }
   else {
     Mesh *mesh = static_cast<Mesh *>(geom);
     sync_mesh(b_depsgraph, b_ob, mesh, used_shaders);
+    stats_type = GeometrySyncStats::MESH;
   }
 
-  return geom;
+  geometry_sync_stats.add(stats_type, timer.get_time());
+}
+
+void BlenderSync::run_deferred_geometry_sync(TaskPool *task_pool)
+{
+  task_pool->wait_work();
+
+  foreach (TaskRunFunction &task, deferred_geometry_sync) {
+    task_pool->push(task);
+  }
+  deferred_geometry_sync.clear();
+
+  task_pool->wait_work();
 }
 
 void BlenderSync::sync_geometry_motion(BL::Depsgraph &b_depsgraph,
                                        BL::Object &b_ob,
                                        Object *object,
                                        float motion_time,
-                                       bool use_particle_hair)
+                                       bool use_particle_hair,
+                                       TaskPool *task_pool)
 {
   /* Ensure we only sync instanced geometry once. */
   Geometry *geom = object->geometry;
@@ -173,20 +307,315 @@ void BlenderSync::sync_geometry_motion(BL::Depsgraph &b_depsgraph,
     return;
   }
 
+  if (task_pool) {
+    TaskRunFunction task = function_bind(&BlenderSync::sync_geometry_motion_task,
+                                         this,
+                                         b_depsgraph,
+                                         b_ob,
+                                         geom,
+                                         motion_step,
+                                         use_particle_hair);
+    if (use_particle_hair) {
+      deferred_geometry_sync.push_back(task);
+    }
+    else {
+      task_pool->push(task);
+    }
+  }
+  else {
+    sync_geometry_motion_task(b_depsgraph, b_ob, geom, motion_step, use_particle_hair);
+  }
+}
+
+void BlenderSync::sync_geometry_motion_task(BL::Depsgraph b_depsgraph,
+                                            BL::Object b_ob,
+                                            Geometry *geom,
+                                            int motion_step,
+                                            bool use_particle_hair)
+{
+  if (progress.get_cancel()) {
+    return;
+  }
+
+  scoped_timer timer;
+  GeometrySyncStats::Type stats_type;
+
 #ifdef WITH_NEW_OBJECT_TYPES
   if (b_ob.type() == BL::Object::type_HAIR || use_particle_hair) {
 #else
   if (use_particle_hair) {
 #endif
     sync_hair_motion(b_depsgraph, b_ob, geom, motion_step);
+    stats_type = GeometrySyncStats::HAIR;
   }
   else if (b_ob.type() == BL::Object::type_VOLUME || object_fluid_gas_domain_find(b_ob)) {
     /* No volume motion blur support yet. */
+    return;
   }
   else {
     Mesh *mesh = static_cast<Mesh *>(geom);
     sync_mesh_motion(b_depsgraph, b_ob, mesh, motion_step);
+    stats_type = GeometrySyncStats::MESH;
   }
+
+  geometry_sync_stats.add(stats_type, timer.get_time());
+}
+
+/* Geometry Deduplication
+ *
+ * Separate Blender datablocks often contain identical meshes, for example linked
+ * duplicates that were made single user. After conversion such meshes are detected
+ * by hashing their data, and all but one are turned into a proxy without any data,
+ * so that their objects instance the remaining mesh. This saves memory and building
+ * a BVH for each copy.
+ *
+ * Only plain triangle meshes are deduplicated. Subdivision meshes are diced per
+ * object, and deformation motion can only be compared after the motion steps have
+ * been exported, so nothing is deduplicated when the scene needs motion. */
+
+static bool geometry_dedup_supported(Geometry *geom)
+{
+  if (geom->type != Geometry::MESH || geom->transform_applied || geom->use_motion_blur) {
+    return false;
+  }
+
+  Mesh *mesh = static_cast<Mesh *>(geom);
+  if (mesh->subdivision_type != Mesh::SUBDIVISION_NONE || mesh->triangles.size() == 0) {
+    return false;
+  }
+
+  foreach (const Attribute &attr, mesh->attributes.attributes) {
+    if (attr.element == ATTR_ELEMENT_VOXEL) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template<typename T> static uint geometry_dedup_hash_array(const array<T> &data, uint hash)
+{
+  return util_murmur_hash3(data.data(), data.size() * sizeof(T), hash);
+}
+
+static void geometry_dedup_hash_mesh(Mesh *mesh, uint *r_hash)
+{
+  uint hash = 0;
+  hash = geometry_dedup_hash_array(mesh->verts, hash);
+  hash = geometry_dedup_hash_array(mesh->triangles, hash);
+  hash = geometry_dedup_hash_array(mesh->shader, hash);
+  hash = geometry_dedup_hash_array(mesh->smooth, hash);
+  hash = util_murmur_hash3(
+      mesh->used_shaders.data(), mesh->used_shaders.size() * sizeof(Shader *), hash);
+
+  foreach (const Attribute &attr, mesh->attributes.attributes) {
+    hash = hash_uint3(hash, attr.std, hash_string(attr.name.c_str()));
+    hash = util_murmur_hash3(attr.data(), attr.buffer.size(), hash);
+  }
+
+  *r_hash = hash;
+}
+
+static bool geometry_dedup_equal(Mesh *a, Mesh *b)
+{
+  if (a->used_shaders != b->used_shaders || a->verts != b->verts ||
+      a->triangles != b->triangles || a->shader != b->shader || a->smooth != b->smooth) {
+    return false;
+  }
+
+  const list<Attribute> &attributes_a = a->attributes.attributes;
+  const list<Attribute> &attributes_b = b->attributes.attributes;
+  if (attributes_a.size() != attributes_b.size()) {
+    return false;
+  }
+
+  list<Attribute>::const_iterator it_a = attributes_a.begin();
+  list<Attribute>::const_iterator it_b = attributes_b.begin();
+  for (; it_a != attributes_a.end(); ++it_a, ++it_b) {
+    if (it_a->std != it_b->std || it_a->name != it_b->name || it_a->type != it_b->type ||
+        it_a->element != it_b->element || it_a->buffer != it_b->buffer) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Remove all data from the mesh except for its shaders, returns the memory freed. */
+static size_t geometry_dedup_clear_mesh(Scene *scene, Mesh *mesh)
+{
+  size_t size = mesh->verts.size() * sizeof(float3) + mesh->triangles.size() * sizeof(int) +
+                mesh->shader.size() * sizeof(int) + mesh->smooth.size() * sizeof(bool);
+  foreach (const Attribute &attr, mesh->attributes.attributes) {
+    size += attr.buffer.size();
+  }
+
+  vector<Shader *> used_shaders = mesh->used_shaders;
+  mesh->clear();
+  mesh->used_shaders = used_shaders;
+  mesh->tag_update(scene, true);
+
+  return size;
+}
+
+Geometry *BlenderSync::geometry_dedup_source(Geometry *geom, Object *object)
+{
+  map<Geometry *, GeometryDedupProxy>::iterator it = geometry_dedup.find(geom);
+  if (it == geometry_dedup.end()) {
+    return geom;
+  }
+
+  it->second.objects.push_back(object);
+  return it->second.source;
+}
+
+void BlenderSync::sync_geometry_dedup(BL::Depsgraph &b_depsgraph, TaskPool *task_pool)
+{
+  scoped_timer timer;
+  const bool use_dedup = scene->need_motion() == Scene::MOTION_NONE;
+
+  /* Restore proxies of which the source geometry changed or was removed. */
+  map<Geometry *, GeometryDedupProxy>::iterator it = geometry_dedup.begin();
+  while (it != geometry_dedup.end()) {
+    Geometry *proxy = it->first;
+    GeometryDedupProxy &dedup = it->second;
+
+    if (dedup.used) {
+      const bool source_valid = geometry_map.is_used(dedup.source) &&
+                                geometry_synced.find(dedup.source) == geometry_synced.end();
+      if (use_dedup && source_valid) {
+        ++it;
+        continue;
+      }
+
+      geometry_synced.insert(proxy);
+      proxy->need_update = true;
+      task_pool->push(function_bind(&BlenderSync::sync_geometry_task,
+                                    this,
+                                    b_depsgraph,
+                                    dedup.b_ob,
+                                    proxy,
+                                    dedup.used_shaders,
+                                    false));
+
+      foreach (Object *object, dedup.objects) {
+        object->geometry = proxy;
+        object->tag_update(scene);
+      }
+    }
+
+    /* Unused proxies are removed along with their geometry in post sync. */
+    geometry_dedup.erase(it++);
+  }
+
+  task_pool->wait_work();
+
+  if (!use_dedup) {
+    geometry_dedup_hash.clear();
+    return;
+  }
+
+  /* Hash newly synced geometry. */
+  vector<Geometry *> hash_geometry;
+  foreach (Geometry *geom, geometry_synced) {
+    if (geometry_dedup_supported(geom)) {
+      hash_geometry.push_back(geom);
+    }
+    else {
+      geometry_dedup_hash.erase(geom);
+    }
+  }
+
+  vector<uint> hashes(hash_geometry.size());
+  for (size_t i = 0; i < hash_geometry.size(); i++) {
+    task_pool->push(function_bind(
+        &geometry_dedup_hash_mesh, static_cast<Mesh *>(hash_geometry[i]), &hashes[i]));
+  }
+  task_pool->wait_work();
+
+  for (size_t i = 0; i < hash_geometry.size(); i++) {
+    geometry_dedup_hash[hash_geometry[i]] = hashes[i];
+  }
+
+  /* Group geometry by hash. Geometry that was not synced now comes first in each
+   * group, so that existing geometry is used as source rather than turned into a proxy. */
+  map<uint, vector<Geometry *>> groups;
+  for (int synced = 0; synced < 2; synced++) {
+    foreach (Geometry *geom, scene->geometry) {
+      if ((geometry_synced.find(geom) != geometry_synced.end()) != (synced == 1)) {
+        continue;
+      }
+
+      map<Geometry *, uint>::iterator hash_it = geometry_dedup_hash.find(geom);
+      if (hash_it == geometry_dedup_hash.end()) {
+        continue;
+      }
+      if (!geometry_map.is_used(geom)) {
+        /* Removed in post sync. */
+        geometry_dedup_hash.erase(hash_it);
+        continue;
+      }
+      groups[hash_it->second].push_back(geom);
+    }
+  }
+
+  /* Turn duplicates into proxies. */
+  map<Geometry *, Geometry *> new_proxies;
+  size_t num_triangles = 0;
+
+  for (map<uint, vector<Geometry *>>::iterator group = groups.begin(); group != groups.end();
+       ++group) {
+    if (group->second.size() < 2) {
+      continue;
+    }
+
+    vector<Mesh *> sources;
+    foreach (Geometry *geom, group->second) {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      Mesh *source = NULL;
+
+      foreach (Mesh *other, sources) {
+        if (geometry_dedup_equal(mesh, other)) {
+          source = other;
+          break;
+        }
+      }
+
+      if (source == NULL) {
+        sources.push_back(mesh);
+        continue;
+      }
+
+      num_triangles += mesh->num_triangles();
+
+      GeometryDedupProxy &dedup = geometry_dedup[mesh];
+      dedup.source = source;
+      dedup.saved_bytes = geometry_dedup_clear_mesh(scene, mesh);
+      geometry_dedup_hash.erase(mesh);
+      new_proxies[mesh] = source;
+    }
+  }
+
+  if (!new_proxies.empty()) {
+    foreach (Object *object, scene->objects) {
+      map<Geometry *, Geometry *>::iterator proxy = new_proxies.find(object->geometry);
+      if (proxy != new_proxies.end()) {
+        object->geometry = proxy->second;
+        object->tag_update(scene);
+      }
+    }
+  }
+
+  size_t saved_bytes = 0;
+  for (it = geometry_dedup.begin(); it != geometry_dedup.end(); ++it) {
+    saved_bytes += it->second.saved_bytes;
+  }
+
+  VLOG(1) << "Geometry deduplication: " << geometry_dedup.size() << " proxies ("
+          << new_proxies.size() << " new, " << num_triangles
+          << " triangles removed from BVH build), saving "
+          << string_human_readable_size(saved_bytes) << ", in " << timer.get_time()
+          << " seconds.";
 }
 
 CCL_NAMESPACE_END
@@ -133,6 +133,11 @@ template<typename K, typename T> class id_map {
     return (data) ? used_set.find(data) != used_set.end() : false;
   }
 
+  bool is_used(T *data)
+  {
+    return used_set.find(data) != used_set.end();
+  }
+
   void used(T *data)
   {
     /* tag data as still in use */
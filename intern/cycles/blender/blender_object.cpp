@@ -32,6 +32,8 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_logging.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -107,13 +109,17 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
                                  bool use_particle_hair,
                                  bool show_lights,
                                  BlenderObjectCulling &culling,
-                                 bool *use_portal)
+                                 bool *use_portal,
+                                 TaskPool *geom_task_pool)
 {
   const bool is_instance = b_instance.is_instance();
   BL::Object b_ob = b_instance.object();
   BL::Object b_parent = is_instance ? b_instance.parent() : b_instance.object();
   BL::Object b_ob_instance = is_instance ? b_instance.instance_object() : b_ob;
   const bool motion = motion_time != 0.0f;
+  /* An instance is the temporary object of the depsgraph iterator, which the next iteration
+   * step overwrites. Its geometry can't be converted by a task, so it is done right here. */
+  TaskPool *object_geom_task_pool = is_instance ? NULL : geom_task_pool;
   /*const*/ Transform tfm = get_transform(b_ob.matrix_world());
   int *persistent_id = NULL;
   BL::Array<int, OBJECT_PERSISTENT_ID_SIZE> persistent_id_array;
@@ -202,7 +208,8 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
 
       /* mesh deformation */
       if (object->geometry)
-        sync_geometry_motion(b_depsgraph, b_ob, object, motion_time, use_particle_hair);
+        sync_geometry_motion(
+            b_depsgraph, b_ob, object, motion_time, use_particle_hair, object_geom_task_pool);
     }
 
     return object;
@@ -215,8 +222,13 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
     object_updated = true;
 
   /* mesh sync */
-  object->geometry = sync_geometry(
-      b_depsgraph, b_ob, b_ob_instance, object_updated, use_particle_hair);
+  Geometry *geom = sync_geometry(b_depsgraph,
+                                 b_ob,
+                                 b_ob_instance,
+                                 object_updated,
+                                 use_particle_hair,
+                                 object_geom_task_pool);
+  object->geometry = geometry_dedup_source(geom, object);
 
   /* special case not tracked by object update flags */
 
@@ -339,11 +351,24 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
     object_map.pre_sync();
     particle_system_map.pre_sync();
     motion_times.clear();
+
+    for (map<Geometry *, GeometryDedupProxy>::iterator it = geometry_dedup.begin();
+         it != geometry_dedup.end();
+         ++it) {
+      it->second.used = false;
+      it->second.objects.clear();
+    }
   }
   else {
     geometry_motion_synced.clear();
   }
 
+  geometry_sync_stats.reset();
+  scoped_timer timer;
+
+  /* Geometry is converted in parallel, while objects are synced on this thread. */
+  TaskPool geom_task_pool;
+
   /* initialize culling */
   BlenderObjectCulling culling(scene, b_scene);
 
@@ -379,7 +404,8 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
                   false,
                   show_lights,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geom_task_pool);
     }
 
     /* Particle hair as separate object. */
@@ -391,14 +417,26 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
                   true,
                   show_lights,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geom_task_pool);
     }
 
     cancel = progress.get_cancel();
   }
 
+  run_deferred_geometry_sync(&geom_task_pool);
+
+  if (!cancel && !motion) {
+    /* Replace identical meshes by instances of a single mesh. */
+    sync_geometry_dedup(b_depsgraph, &geom_task_pool);
+  }
+
   progress.set_sync_status("");
 
+  VLOG(1) << "Synchronized objects" << (motion ? " motion" : "") << " in " << timer.get_time()
+          << " seconds, geometry conversion time per type:\n"
+          << geometry_sync_stats.full_report();
+
   if (!cancel && !motion) {
     sync_background_light(b_v3d, use_portal);
 
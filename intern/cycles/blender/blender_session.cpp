@@ -38,6 +38,7 @@
 #include "util/util_hash.h"
 #include "util/util_logging.h"
 #include "util/util_murmurhash.h"
+#include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_time.h"
 
@@ -548,6 +549,22 @@ void BlenderSession::render(BL::Depsgraph &b_depsgraph_)
     /* Update tile manager if we're doing resumable render. */
     update_resumable_tile_manager(effective_layer_samples);
 
+    /* Checkpoint file unique to the frame, view layer and view being rendered. */
+    if (!session_params.checkpoint_path.empty()) {
+      string filename = string_printf("%s_%s_%s_%04d.cyckpt",
+                                      b_scene.name().c_str(),
+                                      b_rlay_name.c_str(),
+                                      b_rview_name.c_str(),
+                                      b_scene.frame_current());
+      session->set_checkpoint(
+          path_join(blender_absolute_path(b_data, b_scene, session_params.checkpoint_path),
+                    filename),
+          b_data.filepath());
+    }
+    else {
+      session->set_checkpoint("", "");
+    }
+
     /* Update session itself. */
     session->reset(buffer_params, effective_layer_samples);
 
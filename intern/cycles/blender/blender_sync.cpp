@@ -887,6 +887,11 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine &b_engine,
     else
       params.progressive = false;
 
+    if (params.progressive_refine && !b_engine.is_preview()) {
+      params.progressive_round_time = (double)get_float(cscene, "progressive_round_time");
+      params.checkpoint_path = get_string(cscene, "checkpoint_directory");
+    }
+
     params.start_resolution = INT_MAX;
     params.pixel_size = 1;
   }
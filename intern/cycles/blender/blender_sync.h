@@ -30,6 +30,8 @@
 
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_task.h"
+#include "util/util_thread.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -51,6 +53,33 @@ class Shader;
 class ShaderGraph;
 class ShaderNode;
 
+/* Geometry Sync Statistics
+ *
+ * Time spent converting geometry, per geometry type. Accumulated from all the
+ * threads converting geometry, so it may exceed the wall clock time of the sync. */
+
+class GeometrySyncStats {
+ public:
+  enum Type {
+    MESH = 0,
+    HAIR,
+    VOLUME,
+
+    NUM_TYPES,
+  };
+
+  GeometrySyncStats();
+
+  void reset();
+  void add(Type type, double elapsed);
+  string full_report();
+
+ protected:
+  thread_mutex mutex;
+  double time[NUM_TYPES];
+  int count[NUM_TYPES];
+};
+
 class BlenderSync {
  public:
   BlenderSync(BL::RenderEngine &b_engine,
@@ -136,7 +165,8 @@ class BlenderSync {
                       bool use_particle_hair,
                       bool show_lights,
                       BlenderObjectCulling &culling,
-                      bool *use_portal);
+                      bool *use_portal,
+                      TaskPool *geom_task_pool);
 
   /* Volume */
   void sync_volume(BL::Object &b_ob, Mesh *mesh, const vector<Shader *> &used_shaders);
@@ -172,12 +202,29 @@ class BlenderSync {
                           BL::Object &b_ob,
                           BL::Object &b_ob_instance,
                           bool object_updated,
+                          bool use_particle_hair,
+                          TaskPool *task_pool);
+  void sync_geometry_task(BL::Depsgraph b_depsgraph,
+                          BL::Object b_ob,
+                          Geometry *geom,
+                          vector<Shader *> used_shaders,
                           bool use_particle_hair);
   void sync_geometry_motion(BL::Depsgraph &b_depsgraph,
                             BL::Object &b_ob,
                             Object *object,
                             float motion_time,
-                            bool use_particle_hair);
+                            bool use_particle_hair,
+                            TaskPool *task_pool);
+  void sync_geometry_motion_task(BL::Depsgraph b_depsgraph,
+                                 BL::Object b_ob,
+                                 Geometry *geom,
+                                 int motion_step,
+                                 bool use_particle_hair);
+  void run_deferred_geometry_sync(TaskPool *task_pool);
+
+  /* Geometry Deduplication */
+  Geometry *geometry_dedup_source(Geometry *geom, Object *object);
+  void sync_geometry_dedup(BL::Depsgraph &b_depsgraph, TaskPool *task_pool);
 
   /* Light */
   void sync_light(BL::Object &b_parent,
@@ -218,6 +265,28 @@ class BlenderSync {
   id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
   set<Geometry *> geometry_synced;
   set<Geometry *> geometry_motion_synced;
+  vector<TaskRunFunction> deferred_geometry_sync;
+  GeometrySyncStats geometry_sync_stats;
+
+  /* Geometry with the same content as other geometry is turned into a proxy, which
+   * has its data removed while its objects use the source geometry instead. */
+  struct GeometryDedupProxy {
+    GeometryDedupProxy() : source(NULL), saved_bytes(0), used(false), b_ob(PointerRNA_NULL)
+    {
+    }
+
+    Geometry *source;
+    size_t saved_bytes;
+
+    /* State of the current sync, to restore the proxy if the source changed. The object is
+     * owned by the depsgraph, never a temporary instance object. */
+    bool used;
+    BL::Object b_ob;
+    vector<Shader *> used_shaders;
+    vector<Object *> objects;
+  };
+  map<Geometry *, GeometryDedupProxy> geometry_dedup;
+  map<Geometry *, uint> geometry_dedup_hash;
   set<float> motion_times;
   void *world_map;
   bool world_recalc;
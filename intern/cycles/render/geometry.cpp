@@ -41,6 +41,7 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -1357,6 +1358,7 @@ void GeometryManager::device_update(Device *device,
       return;
   }
 
+  scoped_timer bvh_timer;
   TaskPool pool;
 
   size_t i = 0;
@@ -1373,6 +1375,7 @@ void GeometryManager::device_update(Device *device,
   TaskPool::Summary summary;
   pool.wait_work(&summary);
   VLOG(2) << "Objects BVH build pool statistics:\n" << summary.full_report();
+  scene->update_times.bvh += bvh_timer.get_time();
 
   foreach (Shader *shader, scene->shaders) {
     shader->need_update_geometry = false;
@@ -1390,7 +1393,11 @@ void GeometryManager::device_update(Device *device,
   if (progress.get_cancel())
     return;
 
-  device_update_bvh(device, dscene, scene, progress);
+  {
+    scoped_timer timer;
+    device_update_bvh(device, dscene, scene, progress);
+    scene->update_times.bvh += timer.get_time();
+  }
   if (progress.get_cancel())
     return;
 
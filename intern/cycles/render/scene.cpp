@@ -37,6 +37,7 @@
 #include "util/util_guarded_allocator.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -193,6 +194,9 @@ void Scene::device_update(Device *device_, Progress &progress)
 
   bool print_stats = need_data_update();
 
+  update_times.reset();
+  scoped_timer timer(&update_times.total);
+
   /* The order of updates is important, because there's dependencies between
    * the different managers, using data computed by previous managers.
    *
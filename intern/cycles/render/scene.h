@@ -197,6 +197,29 @@ class SceneParams {
   }
 };
 
+/* Scene Update Times
+ *
+ * Time spent in the most recent device update of the scene, used for benchmarking.
+ * The BVH time covers both the object and top level BVH builds, and is included in
+ * the total time. */
+
+class SceneUpdateTimes {
+ public:
+  SceneUpdateTimes()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    total = 0.0;
+    bvh = 0.0;
+  }
+
+  double total;
+  double bvh;
+};
+
 /* Scene */
 
 class Scene {
@@ -246,6 +269,9 @@ class Scene {
   /* mutex must be locked manually by callers */
   thread_mutex mutex;
 
+  /* timing of the last device update */
+  SceneUpdateTimes update_times;
+
   Scene(const SceneParams &params, Device *device);
   ~Scene();
 
@@ -15,12 +15,14 @@
  */
 
 #include <limits.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "device/device.h"
 #include "render/bake.h"
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/film.h"
 #include "render/graph.h"
 #include "render/integrator.h"
 #include "render/light.h"
@@ -33,12 +35,19 @@
 #include "util/util_function.h"
 #include "util/util_logging.h"
 #include "util/util_math.h"
+#include "util/util_md5.h"
 #include "util/util_opengl.h"
+#include "util/util_path.h"
 #include "util/util_task.h"
 #include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Minimum number of seconds between writing progressive refine checkpoints. A checkpoint holds
+ * the full render buffer, writing it after every round of a few samples would cost more render
+ * time than a resume can save. */
+#define CHECKPOINT_WRITE_INTERVAL 60.0
+
 /* Note about  preserve_tile_device option for tile manager:
  * progressive refine and viewport rendering does requires tiles to
  * always be allocated for the same device
@@ -443,6 +452,8 @@ bool Session::acquire_tile(RenderTile &rtile, Device *tile_device, uint tile_typ
     /* allocate buffers */
     tile->buffers = new RenderBuffers(tile_device);
     tile->buffers->reset(buffer_params);
+
+    load_checkpoint_tile(tile);
   }
 
   tile->buffers->map_neighbor_copied = false;
@@ -605,10 +616,16 @@ void Session::run_cpu()
     delayed_reset.do_reset = false;
   }
 
+  /* Final render of all tiles in rounds, see update_progressive_round_samples(). */
+  const bool use_rounds = params.background && params.progressive_refine;
+  bool converged = false;
+
   while (!progress.get_cancel()) {
     /* advance to next tile */
     bool no_tiles = !tile_manager.next();
     bool need_copy_to_display_buffer = false;
+    double round_start_time = 0.0;
+    vector<uint8_t> checkpoint_data;
 
     DeviceKernelStatus kernel_state = DEVICE_KERNEL_UNKNOWN;
     if (no_tiles) {
@@ -687,6 +704,12 @@ void Session::run_cpu()
        * reset and draw in between */
       thread_scoped_lock buffers_lock(buffers_mutex);
 
+      /* resume from a previous render of the same frame */
+      if (use_rounds && !checkpoint.path.empty() &&
+          tile_manager.state.sample == tile_manager.range_start_sample) {
+        read_checkpoint();
+      }
+
       /* avoid excessive denoising in viewport after reaching a certain amount of samples */
       bool need_denoise = tile_manager.schedule_denoising || tile_manager.state.sample < 20 ||
                           (time_dt() - last_display_time) >= params.progressive_update_timeout;
@@ -695,6 +718,7 @@ void Session::run_cpu()
       update_status_time();
 
       /* render */
+      round_start_time = time_dt();
       render(need_denoise);
 
       /* update status and timing */
@@ -728,10 +752,34 @@ void Session::run_cpu()
       if (!device->error_message().empty())
         progress.set_error(device->error_message());
 
-      tiles_written = update_progressive_refine(progress.get_cancel());
+      if (use_rounds && !no_tiles) {
+        update_progressive_round_samples(time_dt() - round_start_time);
+        converged = progressive_refine_converged();
+
+        if (!checkpoint.path.empty()) {
+          if (converged || tile_manager.done()) {
+            path_remove(checkpoint.path);
+          }
+          else if (time_dt() - checkpoint.write_time >= CHECKPOINT_WRITE_INTERVAL) {
+            copy_checkpoint(checkpoint_data);
+          }
+        }
+      }
+
+      tiles_written = update_progressive_refine(progress.get_cancel() || converged);
+    }
+
+    /* Write the checkpoint without holding up drawing and resets. */
+    if (!checkpoint_data.empty()) {
+      write_checkpoint(checkpoint_data);
     }
 
     progress.set_update();
+
+    if (converged) {
+      progress.set_status("Finished");
+      break;
+    }
   }
 
   if (!tiles_written)
@@ -874,6 +922,9 @@ void Session::reset_(BufferParams &buffer_params, int samples)
   }
 
   tile_manager.reset(buffer_params, samples);
+  tile_manager.progressive_round_samples = 1;
+  checkpoint.tiles.clear();
+  checkpoint.write_time = time_dt();
   progress.reset_sample();
 
   bool show_progress = params.background || tile_manager.get_num_effective_samples() != INT_MAX;
@@ -942,6 +993,12 @@ void Session::set_denoising_start_sample(int sample)
   }
 }
 
+void Session::set_checkpoint(const string &path, const string &source)
+{
+  checkpoint.path = path;
+  checkpoint.source = source;
+}
+
 void Session::wait()
 {
   if (session_thread) {
@@ -1206,7 +1263,7 @@ void Session::copy_to_display_buffer(int sample)
 
 bool Session::update_progressive_refine(bool cancel)
 {
-  int sample = tile_manager.state.sample + 1;
+  int sample = tile_manager.state.sample + max(tile_manager.state.num_samples, 1);
   bool write = sample == tile_manager.num_samples || cancel;
 
   double current_time = time_dt();
@@ -1247,6 +1304,292 @@ bool Session::update_progressive_refine(bool cancel)
   return write;
 }
 
+static bool use_adaptive_sampling(Scene *scene)
+{
+  return (scene->integrator->sampling_pattern == SAMPLING_PATTERN_PMJ) &&
+         scene->dscene.data.film.pass_adaptive_aux_buffer;
+}
+
+/* Adjust the number of samples of the next progressive refine round, so that a round takes
+ * about the requested time. This keeps the image updating and checkpoints being written at a
+ * steady pace, while avoiding the overhead of rendering a single sample per round. */
+void Session::update_progressive_round_samples(double round_time)
+{
+  if (params.progressive_round_time <= 0.0) {
+    return;
+  }
+
+  const int num_samples = max(tile_manager.state.num_samples, 1);
+  const double sample_time = round_time / num_samples;
+
+  /* Grow at most twice per round, the first samples are not a reliable estimate. */
+  int samples = 2 * num_samples;
+  if (sample_time > 0.0) {
+    samples = (int)min((double)samples, params.progressive_round_time / sample_time);
+  }
+  samples = max(samples, 1);
+
+  if (use_adaptive_sampling(scene)) {
+    /* End rounds on the samples at which adaptive filtering happens, so converged pixels are
+     * detected as soon as possible. */
+    AdaptiveSampling adaptive_sampling;
+    adaptive_sampling.adaptive_step = scene->dscene.data.integrator.adaptive_step;
+    samples = adaptive_sampling.align_dynamic_samples(
+        tile_manager.state.sample + num_samples, samples);
+  }
+
+  tile_manager.progressive_round_samples = samples;
+}
+
+/* Adaptive sampling marks pixels that reached the noise threshold as converged. Once all
+ * pixels are, further rounds would not add any samples. */
+bool Session::progressive_refine_converged()
+{
+  if (!use_adaptive_sampling(scene)) {
+    return false;
+  }
+
+  const int aux_offset = scene->dscene.data.film.pass_adaptive_aux_buffer;
+
+  foreach (Tile &tile, tile_manager.state.tiles) {
+    if (!tile.buffers || !tile.buffers->copy_from_device()) {
+      return false;
+    }
+
+    const int pass_stride = tile.buffers->params.get_passes_size();
+    const int num_pixels = tile.buffers->params.width * tile.buffers->params.height;
+    const float *buffer = tile.buffers->buffer.data();
+
+    for (int i = 0; i < num_pixels; i++) {
+      if (buffer[i * pass_stride + aux_offset + 3] == 0.0f) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/* Checkpoint file layout: header, path of the source file, then the render buffer of every
+ * tile. */
+
+static const char checkpoint_magic[8] = "CYCKPT2";
+
+struct CheckpointHeader {
+  char magic[8];
+  /* Settings which affect the render result, see checkpoint_settings_hash(). */
+  char settings_hash[32];
+  int source_len;
+  int width, height;
+  int pass_stride;
+  int sample;
+  int num_tiles;
+};
+
+/* A checkpoint is only resumed with the same integrator, film and camera settings, geometry
+ * and shading changes are only detected as far as they change the number of scene elements.
+ * The number of samples may change, to continue a render with more samples. Except with
+ * correlated multi-jitter, of which the pattern depends on the number of samples. */
+static string checkpoint_settings_hash(Scene *scene)
+{
+  static const ustring aa_samples("aa_samples");
+  MD5Hash md5;
+
+  Integrator *integrator = scene->integrator;
+  foreach (const SocketType &socket, integrator->type->inputs) {
+    if (socket.name == aa_samples && integrator->sampling_pattern != SAMPLING_PATTERN_CMJ) {
+      continue;
+    }
+    /* All integrator settings are plain values. */
+    md5.append(socket.name.string());
+    md5.append((const uint8_t *)integrator + socket.struct_offset, socket.size());
+  }
+
+  scene->film->hash(md5);
+  scene->camera->hash(md5);
+
+  const int num_elements[4] = {(int)scene->objects.size(),
+                               (int)scene->geometry.size(),
+                               (int)scene->shaders.size(),
+                               (int)scene->lights.size()};
+  md5.append((const uint8_t *)num_elements, sizeof(num_elements));
+  return md5.get_hex();
+}
+
+struct CheckpointTile {
+  int index;
+  int x, y, w, h;
+};
+
+/* Copy the render buffers to \a data in the checkpoint file layout, while holding the buffers
+ * lock. Writing the file is left to write_checkpoint() after the lock is released. */
+bool Session::copy_checkpoint(vector<uint8_t> &data)
+{
+  CheckpointHeader header;
+  memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+  const string settings_hash = checkpoint_settings_hash(scene);
+  memcpy(header.settings_hash, settings_hash.data(), sizeof(header.settings_hash));
+  header.source_len = checkpoint.source.size();
+  header.width = tile_manager.state.buffer.width;
+  header.height = tile_manager.state.buffer.height;
+  header.pass_stride = tile_manager.params.get_passes_size();
+  header.sample = tile_manager.state.sample + tile_manager.state.num_samples;
+  header.num_tiles = tile_manager.state.tiles.size();
+
+  size_t size = sizeof(header) + header.source_len;
+  foreach (Tile &tile, tile_manager.state.tiles) {
+    if (!tile.buffers || !tile.buffers->copy_from_device()) {
+      VLOG(1) << "Failed to copy checkpoint buffers from the device.";
+      return false;
+    }
+    size += sizeof(CheckpointTile) + tile.buffers->buffer.size() * sizeof(float);
+  }
+
+  data.resize(size);
+  uint8_t *dst = data.data();
+
+  memcpy(dst, &header, sizeof(header));
+  dst += sizeof(header);
+  memcpy(dst, checkpoint.source.data(), header.source_len);
+  dst += header.source_len;
+
+  foreach (Tile &tile, tile_manager.state.tiles) {
+    const CheckpointTile info = {tile.index, tile.x, tile.y, tile.w, tile.h};
+    memcpy(dst, &info, sizeof(info));
+    dst += sizeof(info);
+
+    const size_t buffer_size = tile.buffers->buffer.size() * sizeof(float);
+    memcpy(dst, tile.buffers->buffer.data(), buffer_size);
+    dst += buffer_size;
+  }
+
+  checkpoint.write_time = time_dt();
+  return true;
+}
+
+void Session::write_checkpoint(const vector<uint8_t> &data)
+{
+  const string tmp_path = checkpoint.path + ".tmp";
+  FILE *f = path_fopen(tmp_path, "wb");
+  if (!f) {
+    VLOG(1) << "Failed to open checkpoint file " << tmp_path;
+    return;
+  }
+
+  scoped_timer timer;
+
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  ok = (fclose(f) == 0) && ok;
+
+  /* Replace the previous checkpoint only once the new one is complete. */
+  if (ok) {
+    path_remove(checkpoint.path);
+    ok = rename(tmp_path.c_str(), checkpoint.path.c_str()) == 0;
+  }
+
+  if (ok) {
+    const CheckpointHeader *header = (const CheckpointHeader *)data.data();
+    VLOG(1) << "Wrote checkpoint at sample " << header->sample << " to " << checkpoint.path
+            << " in " << timer.get_time() << " seconds.";
+  }
+  else {
+    path_remove(tmp_path);
+    VLOG(1) << "Failed to write checkpoint " << checkpoint.path;
+  }
+}
+
+bool Session::read_checkpoint()
+{
+  checkpoint.tiles.clear();
+
+  FILE *f = path_fopen(checkpoint.path, "rb");
+  if (!f) {
+    return false;
+  }
+
+  CheckpointHeader header;
+  const string settings_hash = checkpoint_settings_hash(scene);
+  const int end_sample = tile_manager.range_start_sample +
+                         tile_manager.get_num_effective_samples();
+  const int pass_stride = tile_manager.params.get_passes_size();
+  bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+            memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) == 0 &&
+            memcmp(header.settings_hash, settings_hash.data(), sizeof(header.settings_hash)) ==
+                0 &&
+            header.source_len == (int)checkpoint.source.size() &&
+            header.width == tile_manager.state.buffer.width &&
+            header.height == tile_manager.state.buffer.height &&
+            header.pass_stride == pass_stride &&
+            header.num_tiles == (int)tile_manager.state.tiles.size() &&
+            header.sample > tile_manager.state.sample && header.sample < end_sample;
+
+  /* Checkpoints of another file rendering the same scene, view layer and frame. */
+  if (ok) {
+    string source(header.source_len, '\0');
+    ok = fread(&source[0], 1, header.source_len, f) == (size_t)header.source_len &&
+         source == checkpoint.source;
+  }
+
+  for (int i = 0; ok && i < header.num_tiles; i++) {
+    CheckpointTile info;
+    ok = fread(&info, sizeof(info), 1, f) == 1 && info.index >= 0 &&
+         info.index < (int)tile_manager.state.tiles.size();
+    if (!ok) {
+      break;
+    }
+
+    const Tile &tile = tile_manager.state.tiles[info.index];
+    ok = tile.x == info.x && tile.y == info.y && tile.w == info.w && tile.h == info.h;
+    if (!ok) {
+      break;
+    }
+
+    /* Same size as the tile buffers allocated in acquire_tile(), so that all tiles can be loaded
+     * once the render continues after the checkpoint. */
+    vector<float> &data = checkpoint.tiles[info.index];
+    data.resize((size_t)tile.w * tile.h * pass_stride);
+    ok = fread(data.data(), sizeof(float), data.size(), f) == data.size();
+  }
+
+  fclose(f);
+
+  if (!ok) {
+    checkpoint.tiles.clear();
+    VLOG(1) << "Ignoring invalid checkpoint " << checkpoint.path;
+    return false;
+  }
+
+  /* Continue rendering after the last sample in the checkpoint. */
+  const int num_resumed_samples = header.sample - tile_manager.state.sample;
+  tile_manager.state.sample = header.sample;
+  tile_manager.state.num_samples = min(tile_manager.state.num_samples,
+                                       end_sample - header.sample);
+  progress.add_samples((uint64_t)num_resumed_samples * header.width * header.height,
+                       header.sample);
+
+  VLOG(1) << "Resuming render at sample " << header.sample << " from checkpoint "
+          << checkpoint.path;
+
+  return true;
+}
+
+/* Fill newly allocated tile buffers from the checkpoint the render was resumed from. */
+void Session::load_checkpoint_tile(Tile *tile)
+{
+  map<int, vector<float>>::iterator it = checkpoint.tiles.find(tile->index);
+  if (it == checkpoint.tiles.end()) {
+    return;
+  }
+
+  /* Sizes were checked when reading the checkpoint, samples were skipped already. */
+  device_vector<float> &buffer = tile->buffers->buffer;
+  assert(buffer.size() == it->second.size());
+  memcpy(buffer.data(), it->second.data(), it->second.size() * sizeof(float));
+  buffer.copy_to_device();
+
+  checkpoint.tiles.erase(it);
+}
+
 void Session::device_free()
 {
   scene->device_free();
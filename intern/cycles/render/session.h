@@ -23,6 +23,7 @@
 #include "render/stats.h"
 #include "render/tile.h"
 
+#include "util/util_map.h"
 #include "util/util_progress.h"
 #include "util/util_stats.h"
 #include "util/util_thread.h"
@@ -47,6 +48,15 @@ class SessionParams {
   bool background;
   bool progressive_refine;
 
+  /* Progressive refine of final renders renders all tiles in rounds. The number of samples
+   * per round is adjusted to make a round take about this many seconds, zero renders a single
+   * sample per round. */
+  double progressive_round_time;
+  /* Directory the render buffers are written to during progressive refine rounds, and read
+   * from to resume an interrupted render. Empty to disable checkpoints. The file in it is set
+   * with Session::set_checkpoint(). */
+  string checkpoint_path;
+
   bool progressive;
   bool experimental;
   int samples;
@@ -81,6 +91,7 @@ class SessionParams {
   {
     background = false;
     progressive_refine = false;
+    progressive_round_time = 0.0;
 
     progressive = false;
     experimental = false;
@@ -114,6 +125,8 @@ class SessionParams {
   {
     return !(device == params.device && background == params.background &&
              progressive_refine == params.progressive_refine &&
+             progressive_round_time == params.progressive_round_time &&
+             checkpoint_path == params.checkpoint_path &&
              /* samples == params.samples && denoising_start_sample ==
                 params.denoising_start_sample && */
              progressive == params.progressive && experimental == params.experimental &&
@@ -162,6 +175,7 @@ class Session {
   void set_samples(int samples);
   void set_denoising(bool denoising, bool optix_denoising);
   void set_denoising_start_sample(int sample);
+  void set_checkpoint(const string &path, const string &source);
 
   bool update_scene();
   bool load_kernels(bool lock_scene = true);
@@ -233,6 +247,24 @@ class Session {
 
   /* progressive refine */
   bool update_progressive_refine(bool cancel);
+  void update_progressive_round_samples(double round_time);
+  bool progressive_refine_converged();
+
+  /* progressive refine checkpoints */
+  bool copy_checkpoint(vector<uint8_t> &data);
+  void write_checkpoint(const vector<uint8_t> &data);
+  bool read_checkpoint();
+  void load_checkpoint_tile(Tile *tile);
+
+  struct Checkpoint {
+    /* File unique to the frame, view layer and view, empty to disable checkpoints. */
+    string path;
+    /* File being rendered, checkpoints written while rendering another file are ignored. */
+    string source;
+    double write_time;
+    /* Render buffer contents per tile index, until loaded into the tile buffers. */
+    map<int, vector<float>> tiles;
+  } checkpoint;
 
   DeviceRequestedFeatures get_requested_device_features();
 
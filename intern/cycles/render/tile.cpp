@@ -107,6 +107,7 @@ TileManager::TileManager(bool progressive_,
   preserve_tile_device = preserve_tile_device_;
   background = background_;
   schedule_denoising = false;
+  progressive_round_samples = 1;
 
   range_start_sample = 0;
   range_num_samples = -1;
@@ -495,6 +496,47 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
   }
 }
 
+/* When denoising during rendering, a tile has to stay in memory until all its neighbors have
+ * been rendered and denoised. Rather than strictly following the tile order, pick the tile
+ * among the next few that has the most rendered neighbors. This keeps the region of rendered
+ * tiles compact, so that tiles become ready for denoising sooner and can be freed, which bounds
+ * memory usage for large images. */
+list<int>::iterator TileManager::next_render_tile(list<int> &tiles)
+{
+  list<int>::iterator best = tiles.begin();
+  if (!schedule_denoising || progressive) {
+    return best;
+  }
+
+  /* Denoising a tile needs its 8 neighbors, so look as far ahead as the neighbors of one tile
+   * for each device taking tiles from this list. Looking further ahead would skip over more of
+   * the tile order, which itself keeps the region of rendered tiles compact. */
+  const int num_neighbors = 8;
+  const int devices_per_list = max(num_devices / (int)state.render_tiles.size(), 1);
+  const int lookahead_max = num_neighbors * devices_per_list;
+
+  int best_score = -1;
+  int lookahead = 0;
+  for (list<int>::iterator it = tiles.begin();
+       it != tiles.end() && lookahead < lookahead_max;
+       ++it, ++lookahead) {
+    int score = 0;
+    for (int neighbor = 0; neighbor < 9; neighbor++) {
+      int nindex = get_neighbor_index(*it, neighbor);
+      if (neighbor != 4 && nindex >= 0 && state.tiles[nindex].state >= Tile::RENDERED) {
+        score++;
+      }
+    }
+
+    if (score > best_score) {
+      best = it;
+      best_score = score;
+    }
+  }
+
+  return best;
+}
+
 bool TileManager::next_tile(Tile *&tile, int device, uint tile_types)
 {
   /* Preserve device if requested, unless this is a separate denoising device that just wants to
@@ -542,8 +584,9 @@ bool TileManager::next_tile(Tile *&tile, int device, uint tile_types)
         }
       }
 
-      tile_index = state.render_tiles[logical_device].front();
-      state.render_tiles[logical_device].pop_front();
+      list<int>::iterator it = next_render_tile(state.render_tiles[logical_device]);
+      tile_index = *it;
+      state.render_tiles[logical_device].erase(it);
       break;
     }
 
@@ -586,14 +629,21 @@ bool TileManager::next()
     set_tiles();
   }
   else {
-    state.sample++;
-
-    if (progressive)
-      state.num_samples = 1;
-    else if (range_num_samples == -1)
-      state.num_samples = num_samples;
-    else
-      state.num_samples = range_num_samples;
+    if (progressive) {
+      /* Render all tiles in rounds of one or more samples. */
+      int end_sample = (range_num_samples == -1) ? num_samples :
+                                                   range_start_sample + range_num_samples;
+      state.sample += max(state.num_samples, 1);
+      state.num_samples = max(min(progressive_round_samples, end_sample - state.sample), 1);
+    }
+    else {
+      state.sample++;
+
+      if (range_num_samples == -1)
+        state.num_samples = num_samples;
+      else
+        state.num_samples = range_num_samples;
+    }
 
     state.resolution_divider = pixel_size;
 
@@ -133,6 +133,10 @@ class TileManager {
   /* Schedule tiles for denoising after they've been rendered. */
   bool schedule_denoising;
 
+  /* Number of samples rendered per round in progressive mode, once the final resolution
+   * is reached. */
+  int progressive_round_samples;
+
  protected:
   void set_tiles();
 
@@ -165,6 +169,9 @@ class TileManager {
   /* Generate tile list, return number of tiles. */
   int gen_tiles(bool sliced);
   void gen_render_tiles();
+
+  /* Choose the tile to render next from the list of a device. */
+  list<int>::iterator next_render_tile(list<int> &tiles);
 };
 
 CCL_NAMESPACE_END
@@ -54,8 +54,10 @@
  */
 
 #include "MEM_Allocator.h"
+#include <algorithm>
 #include <list>
 #include <queue>
+#include <utility>
 #include <vector>
 
 template<class T> class MEM_CacheLimiter;
@@ -72,7 +74,7 @@ bool MEM_CacheLimiter_is_disabled(void);
 template<class T> class MEM_CacheLimiterHandle {
  public:
   explicit MEM_CacheLimiterHandle(T *data_, MEM_CacheLimiter<T> *parent_)
-      : data(data_), refcount(0), parent(parent_)
+      : data(data_), refcount(0), data_size(0), parent(parent_)
   {
   }
 
@@ -133,16 +135,39 @@ template<class T> class MEM_CacheLimiterHandle {
   T *data;
   int refcount;
   int pos;
+  /* Size of the data when it was last counted in the parent's memory in use. */
+  size_t data_size;
   MEM_CacheLimiter<T> *parent;
 };
 
+/**
+ * The queue is kept in least recently used order, touched elements are moved to its end.
+ * Unmanaged and touched elements leave holes in the queue, which are removed once there are
+ * enough of them, so that neither needs to shift the queue.
+ *
+ * With a data size function the memory in use is a running total, the size of an element is
+ * computed when it is inserted and again whenever it is touched, in case the data changed.
+ *
+ * Without priority function the least recently used elements are freed first, so they are taken
+ * from the start of the queue. Otherwise priorities are evaluated once per #enforce_limits call
+ * and kept in a heap when more than one element has to be freed, so that freeing k elements out
+ * of n costs O(n + k log(n)) rather than a full scan of the queue for each freed element. The
+ * priorities depend on state outside of the cache (the movie cache uses the distance to the last
+ * requested frame), so they can't be kept from one call to the next.
+ */
 template<class T> class MEM_CacheLimiter {
  public:
   typedef size_t (*MEM_CacheLimiter_DataSize_Func)(void *data);
   typedef int (*MEM_CacheLimiter_ItemPriority_Func)(void *item, int default_priority);
   typedef bool (*MEM_CacheLimiter_ItemDestroyable_Func)(void *item);
 
-  MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func) : data_size_func(data_size_func)
+  MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func)
+      : data_size_func(data_size_func),
+        item_priority_func(NULL),
+        item_destroyable_func(NULL),
+        memory_in_use(0),
+        queue_holes(0),
+        is_enforcing_limits(false)
   {
   }
 
@@ -156,40 +181,39 @@ template<class T> class MEM_CacheLimiter {
 
   MEM_CacheLimiterHandle<T> *insert(T *elem)
   {
-    queue.push_back(new MEM_CacheLimiterHandle<T>(elem, this));
-    queue.back()->pos = queue.size() - 1;
-    return queue.back();
+    MEM_CacheElementPtr handle = new MEM_CacheLimiterHandle<T>(elem, this);
+    if (data_size_func) {
+      handle->data_size = data_size_func(elem->get_data());
+      memory_in_use += handle->data_size;
+    }
+    queue_append(handle);
+    return handle;
   }
 
   void unmanage(MEM_CacheLimiterHandle<T> *handle)
   {
-    int pos = handle->pos;
-    queue[pos] = queue.back();
-    queue[pos]->pos = pos;
-    queue.pop_back();
+    queue_remove(handle);
+    memory_in_use -= handle->data_size;
     delete handle;
+
+    if (!is_enforcing_limits) {
+      queue_compact_if_needed();
+    }
   }
 
   size_t get_memory_in_use()
   {
-    size_t size = 0;
     if (data_size_func) {
-      int i;
-      for (i = 0; i < queue.size(); i++) {
-        size += data_size_func(queue[i]->get()->get_data());
-      }
-    }
-    else {
-      size = MEM_get_memory_in_use();
+      return memory_in_use;
     }
-    return size;
+    return MEM_get_memory_in_use();
   }
 
   void enforce_limits()
   {
     size_t max = MEM_CacheLimiter_get_maximum();
     bool is_disabled = MEM_CacheLimiter_is_disabled();
-    size_t mem_in_use, cur_size;
+    size_t mem_in_use;
 
     if (is_disabled) {
       return;
@@ -205,42 +229,68 @@ template<class T> class MEM_CacheLimiter {
       return;
     }
 
-    while (!queue.empty() && mem_in_use > max) {
-      MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
-
-      if (!elem)
-        break;
+    is_enforcing_limits = true;
 
-      if (data_size_func) {
-        cur_size = data_size_func(elem->get()->get_data());
-      }
-      else {
-        cur_size = mem_in_use;
+    if (!item_priority_func) {
+      /* The least recently used elements are the first ones in the queue. */
+      for (int i = 0; i < queue.size() && mem_in_use > max; i++) {
+        MEM_CacheElementPtr elem = queue[i];
+        if (elem && can_destroy_element(elem)) {
+          destroy_element(elem, mem_in_use);
+        }
       }
-
-      if (elem->destroy_if_possible()) {
-        if (data_size_func) {
-          mem_in_use -= cur_size;
+    }
+    else {
+      /* Most of the time a single element is freed, so only look for the lowest priority one
+       * first. If more are needed, priorities are all stored in a heap: they do not change while
+       * elements are freed, and the queue is not compacted until done so that the positions
+       * stored in the heap stay valid. */
+      MEM_CachePriority best_match = get_destroyable_priorities(false);
+      bool is_heap = false;
+
+      while (best_match.second != -1 && mem_in_use > max) {
+        MEM_CacheElementPtr elem = queue[best_match.second];
+        best_match.second = -1;
+
+        if (elem != NULL) {
+          destroy_element(elem, mem_in_use);
         }
-        else {
-          mem_in_use -= cur_size - MEM_get_memory_in_use();
+
+        if (mem_in_use > max) {
+          if (!is_heap) {
+            get_destroyable_priorities(true);
+            std::make_heap(priorities.begin(), priorities.end(), priority_greater);
+            is_heap = true;
+          }
+          /* Skip elements already freed, or unmanaged as a side effect of freeing another one. */
+          while (!priorities.empty() && best_match.second == -1) {
+            std::pop_heap(priorities.begin(), priorities.end(), priority_greater);
+            if (queue[priorities.back().second]) {
+              best_match = priorities.back();
+            }
+            priorities.pop_back();
+          }
         }
       }
     }
+
+    is_enforcing_limits = false;
+    queue_compact_if_needed();
   }
 
+  /**
+   * Mark the element as most recently used.
+   */
   void touch(MEM_CacheLimiterHandle<T> *handle)
   {
-    /* If we're using custom priority callback re-arranging the queue
-     * doesn't make much sense because we'll iterate it all to get
-     * least priority element anyway.
-     */
-    if (item_priority_func == NULL) {
-      queue[handle->pos] = queue.back();
-      queue[handle->pos]->pos = handle->pos;
-      queue.pop_back();
-      queue.push_back(handle);
-      handle->pos = queue.size() - 1;
+    /* Also done with a priority function, since the default priority it is given is the position
+     * in the queue. */
+    queue_remove(handle);
+    queue_append(handle);
+    queue_compact_if_needed();
+
+    if (data_size_func) {
+      update_data_size(handle);
     }
   }
 
@@ -258,6 +308,15 @@ template<class T> class MEM_CacheLimiter {
   typedef MEM_CacheLimiterHandle<T> *MEM_CacheElementPtr;
   typedef std::vector<MEM_CacheElementPtr, MEM_Allocator<MEM_CacheElementPtr>> MEM_CacheQueue;
   typedef typename MEM_CacheQueue::iterator iterator;
+  /* Priority and position in the queue, ties are resolved in queue order. */
+  typedef std::pair<int, int> MEM_CachePriority;
+  typedef std::vector<MEM_CachePriority, MEM_Allocator<MEM_CachePriority>> MEM_CachePriorities;
+
+  /* Order of the heap, the element with the lowest priority at the top. */
+  static bool priority_greater(const MEM_CachePriority &a, const MEM_CachePriority &b)
+  {
+    return a > b;
+  }
 
   /* Check whether element can be destroyed when enforcing cache limits */
   bool can_destroy_element(MEM_CacheElementPtr &elem)
@@ -273,52 +332,115 @@ template<class T> class MEM_CacheLimiter {
     return true;
   }
 
-  MEM_CacheElementPtr get_least_priority_destroyable_element(void)
+  void destroy_element(MEM_CacheElementPtr elem, size_t &mem_in_use)
   {
-    if (queue.empty())
-      return NULL;
+    size_t cur_size;
 
-    MEM_CacheElementPtr best_match_elem = NULL;
+    if (data_size_func) {
+      cur_size = elem->data_size;
+    }
+    else {
+      cur_size = mem_in_use;
+    }
 
-    if (!item_priority_func) {
-      for (iterator it = queue.begin(); it != queue.end(); it++) {
-        MEM_CacheElementPtr elem = *it;
-        if (!can_destroy_element(elem))
-          continue;
-        best_match_elem = elem;
-        break;
+    if (elem->destroy_if_possible()) {
+      if (data_size_func) {
+        mem_in_use -= cur_size;
+      }
+      else {
+        mem_in_use -= cur_size - MEM_get_memory_in_use();
       }
     }
-    else {
-      int best_match_priority = 0;
-      int i;
+  }
 
-      for (i = 0; i < queue.size(); i++) {
-        MEM_CacheElementPtr elem = queue[i];
+  void queue_append(MEM_CacheElementPtr elem)
+  {
+    queue.push_back(elem);
+    elem->pos = queue.size() - 1;
+  }
 
-        if (!can_destroy_element(elem))
-          continue;
+  void queue_remove(MEM_CacheElementPtr elem)
+  {
+    queue[elem->pos] = NULL;
+    queue_holes++;
+  }
 
-        /* by default 0 means highest priority element */
-        /* casting a size type to int is questionable,
-           but unlikely to cause problems */
-        int priority = -((int)(queue.size()) - i - 1);
-        priority = item_priority_func(elem->get()->get_data(), priority);
+  void queue_compact_if_needed()
+  {
+    if (queue_holes <= queue.size() / 8) {
+      return;
+    }
 
-        if (priority < best_match_priority || best_match_elem == NULL) {
-          best_match_priority = priority;
-          best_match_elem = elem;
-        }
+    int len = 0;
+    for (int i = 0; i < queue.size(); i++) {
+      if (queue[i]) {
+        queue[i]->pos = len;
+        queue[len++] = queue[i];
+      }
+    }
+    queue.resize(len);
+    queue_holes = 0;
+  }
+
+  void update_data_size(MEM_CacheElementPtr elem)
+  {
+    memory_in_use -= elem->data_size;
+    elem->data_size = data_size_func(elem->get()->get_data());
+    memory_in_use += elem->data_size;
+  }
+
+  /**
+   * Find the element with the lowest priority among the ones which can be destroyed, also
+   * fill #priorities with all of them when \a store is true.
+   * \return Priority and position of the element, the position is -1 when there is none.
+   */
+  MEM_CachePriority get_destroyable_priorities(const bool store)
+  {
+    const int queue_len = queue.size() - queue_holes;
+    MEM_CachePriority best_match(0, -1);
+    int index = -1;
+
+    priorities.clear();
+
+    for (int i = 0; i < queue.size(); i++) {
+      MEM_CacheElementPtr elem = queue[i];
+
+      if (elem == NULL) {
+        continue;
+      }
+      index++;
+
+      if (!can_destroy_element(elem))
+        continue;
+
+      /* by default 0 means highest priority element */
+      int priority = -(queue_len - index - 1);
+      priority = item_priority_func(elem->get()->get_data(), priority);
+
+      /* Strict comparison, so that ties are resolved in queue order. */
+      if (priority < best_match.first || best_match.second == -1) {
+        best_match.first = priority;
+        best_match.second = i;
+      }
+      if (store) {
+        priorities.push_back(MEM_CachePriority(priority, i));
       }
     }
 
-    return best_match_elem;
+    return best_match;
   }
 
   MEM_CacheQueue queue;
   MEM_CacheLimiter_DataSize_Func data_size_func;
   MEM_CacheLimiter_ItemPriority_Func item_priority_func;
   MEM_CacheLimiter_ItemDestroyable_Func item_destroyable_func;
+  /* Sum of the sizes of the elements, only used with a data size function. */
+  size_t memory_in_use;
+  /* Amount of unmanaged elements left in the queue. */
+  int queue_holes;
+  bool is_enforcing_limits;
+  /* Storage reused by #enforce_limits. */
+  MEM_CachePriorities priorities;
 };
 
 #endif  // __MEM_CACHELIMITER_H__
@@ -73,6 +73,8 @@ class PHYSICS_PT_cloth(PhysicButtonsPanel, Panel):
         col.prop(cloth, "quality", text="Quality Steps")
         col = flow.column()
         col.prop(cloth, "time_scale", text="Speed Multiplier")
+        col = flow.column()
+        col.prop(cloth, "preconditioner")
 
 
 class PHYSICS_PT_cloth_physical_properties(PhysicButtonsPanel, Panel):
@@ -380,6 +382,9 @@ class PHYSICS_PT_cloth_self_collision(PhysicButtonsPanel, Panel):
 
         flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=True)
 
+        col = flow.column()
+        col.prop(cloth, "self_broadphase", text="Method")
+
         col = flow.column()
         col.prop(cloth, "self_friction", text="Friction")
 
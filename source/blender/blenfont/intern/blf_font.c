@@ -39,6 +39,7 @@
 
 #include "DNA_vec_types.h"
 
+#include "BLI_ghash.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_rect.h"
@@ -194,10 +195,18 @@ static GPUTexture *blf_batch_cache_texture_load(void)
     int offset_x = bitmap_len_landed % tex_width;
     int offset_y = bitmap_len_landed / tex_width;
 
-    /* TODO(germano): Update more than one row in a single call. */
+    /* Partial first and last rows are updated on their own, full rows in between at once. */
     while (remain) {
       int remain_row = tex_width - offset_x;
-      int width = remain > remain_row ? remain_row : remain;
+      int width, height;
+      if (offset_x == 0 && remain >= tex_width) {
+        width = tex_width;
+        height = remain / tex_width;
+      }
+      else {
+        width = remain > remain_row ? remain_row : remain;
+        height = 1;
+      }
       GPU_texture_update_sub(gc->texture,
                              GPU_DATA_UNSIGNED_BYTE,
                              &gc->bitmap_result[bitmap_len_landed],
@@ -205,13 +214,13 @@ static GPUTexture *blf_batch_cache_texture_load(void)
                              offset_y,
                              0,
                              width,
-                             1,
+                             height,
                              0);
 
-      bitmap_len_landed += width;
-      remain -= width;
+      bitmap_len_landed += width * height;
+      remain -= width * height;
       offset_x = 0;
-      offset_y += 1;
+      offset_y += height;
     }
 
     gc->bitmap_len_landed = bitmap_len_landed;
@@ -420,32 +429,69 @@ static void blf_font_ensure_ascii_kerning(FontBLF *font,
   } \
   (void)0
 
-static void blf_font_draw_ex(FontBLF *font,
-                             GlyphCacheBLF *gc,
-                             const char *str,
-                             size_t len,
-                             struct ResultBLF *r_info,
-                             int pen_y)
+/* -------------------------------------------------------------------- */
+/** \name Glyph Runs
+ *
+ * Strings are laid out once for each glyph cache and kerning mode, the glyphs and their
+ * positions are then reused when the same string is drawn or measured again, which is
+ * what happens for most of the labels of the interface on every redraw.
+ * \{ */
+
+/* Longer strings are laid out every time, without being cached. */
+#define BLF_GLYPH_RUN_STR_LEN_MAX 512
+/* Amount of strings cached per glyph cache, the least recently used one is freed past it. */
+#define BLF_GLYPH_RUNS_LEN_MAX 4096
+
+static unsigned int blf_glyph_run_hash(const void *ptr)
+{
+  const GlyphRunBLF *run = ptr;
+  return BLI_ghashutil_strhash_n(run->str, run->str_len) ^ run->kern_mode;
+}
+
+static bool blf_glyph_run_cmp(const void *a, const void *b)
+{
+  const GlyphRunBLF *run_a = a;
+  const GlyphRunBLF *run_b = b;
+  return (run_a->kern_mode != run_b->kern_mode) || (run_a->str_len != run_b->str_len) ||
+         (memcmp(run_a->str, run_b->str, run_a->str_len) != 0);
+}
+
+static GlyphRunBLF *blf_glyph_run_new(FontBLF *font,
+                                      GlyphCacheBLF *gc,
+                                      const char *str,
+                                      const size_t str_len,
+                                      const bool has_kerning,
+                                      const FT_UInt kern_mode)
 {
   unsigned int c, c_prev = BLI_UTF8_ERR;
   GlyphBLF *g, *g_prev = NULL;
   int pen_x = 0;
   size_t i = 0;
 
-  if (len == 0) {
-    /* early output, don't do any IMM OpenGL. */
-    return;
-  }
-
   GlyphBLF **glyph_ascii_table = blf_font_ensure_ascii_table(font, gc);
 
-  BLF_KERNING_VARS(font, has_kerning, kern_mode);
-
-  blf_font_ensure_ascii_kerning(font, gc, kern_mode);
+  if (has_kerning) {
+    blf_font_ensure_ascii_kerning(font, gc, kern_mode);
+  }
 
-  blf_batch_draw_begin(font);
+  /* Single allocation, with room for one glyph per byte of the string. */
+  GlyphRunBLF *run = MEM_mallocN(
+      sizeof(*run) + str_len * (sizeof(*run->glyphs) + sizeof(*run->glyphs_pen_x) + 1),
+      __func__);
+  run->glyphs = (GlyphBLF **)(run + 1);
+  run->glyphs_pen_x = (int *)(run->glyphs + str_len);
+  run->str = memcpy(run->glyphs_pen_x + str_len, str, str_len);
+  run->str_len = str_len;
+  run->kern_mode = kern_mode;
+  run->glyphs_len = 0;
+
+  rctf *box = &run->box;
+  box->xmin = 32000.0f;
+  box->xmax = -32000.0f;
+  box->ymin = 32000.0f;
+  box->ymax = -32000.0f;
 
-  while ((i < len) && str[i]) {
+  while (i < str_len) {
     BLF_UTF8_NEXT_FAST(font, gc, g, str, i, c, glyph_ascii_table);
 
     if (UNLIKELY(c == BLI_UTF8_ERR)) {
@@ -458,20 +504,105 @@ static void blf_font_draw_ex(FontBLF *font,
       BLF_KERNING_STEP_FAST(font, kern_mode, g_prev, g, c_prev, c, pen_x);
     }
 
-    /* do not return this loop if clipped, we want every character tested */
-    blf_glyph_render(font, gc, g, (float)pen_x, (float)pen_y);
+    run->glyphs[run->glyphs_len] = g;
+    run->glyphs_pen_x[run->glyphs_len] = pen_x;
+    run->glyphs_len++;
+
+    box->xmin = min_ff(box->xmin, (float)pen_x);
+    box->xmax = max_ff(box->xmax, (float)pen_x + g->advance);
+    box->ymin = min_ff(box->ymin, g->box.ymin);
+    box->ymax = max_ff(box->ymax, g->box.ymax);
 
     pen_x += g->advance_i;
     g_prev = g;
     c_prev = c;
   }
 
+  run->pen_x = pen_x;
+
+  return run;
+}
+
+/**
+ * Get the layout of the first \a len bytes of \a str, to be released with
+ * #blf_glyph_run_release once used.
+ */
+static GlyphRunBLF *blf_glyph_run_acquire(FontBLF *font,
+                                          GlyphCacheBLF *gc,
+                                          const char *str,
+                                          size_t len)
+{
+  BLF_KERNING_VARS(font, has_kerning, kern_mode);
+
+  const GlyphRunBLF run_key = {
+      .str = str,
+      .str_len = BLI_strnlen(str, len),
+      .kern_mode = kern_mode,
+  };
+
+  if (run_key.str_len > BLF_GLYPH_RUN_STR_LEN_MAX) {
+    return blf_glyph_run_new(font, gc, str, run_key.str_len, has_kerning, kern_mode);
+  }
+
+  if (gc->glyph_runs == NULL) {
+    gc->glyph_runs = BLI_ghash_new(blf_glyph_run_hash, blf_glyph_run_cmp, __func__);
+  }
+
+  GlyphRunBLF *run = BLI_ghash_lookup(gc->glyph_runs, &run_key);
+  if (run == NULL) {
+    if (BLI_ghash_len(gc->glyph_runs) >= BLF_GLYPH_RUNS_LEN_MAX) {
+      GlyphRunBLF *run_lru = BLI_poptail(&gc->glyph_runs_lru);
+      BLI_ghash_remove(gc->glyph_runs, run_lru, NULL, NULL);
+      MEM_freeN(run_lru);
+    }
+    run = blf_glyph_run_new(font, gc, str, run_key.str_len, has_kerning, kern_mode);
+    BLI_ghash_insert(gc->glyph_runs, run, run);
+  }
+  else {
+    BLI_remlink(&gc->glyph_runs_lru, run);
+  }
+  BLI_addhead(&gc->glyph_runs_lru, run);
+  return run;
+}
+
+static void blf_glyph_run_release(GlyphRunBLF *run)
+{
+  if (run->str_len > BLF_GLYPH_RUN_STR_LEN_MAX) {
+    MEM_freeN(run);
+  }
+}
+
+/** \} */
+
+static void blf_font_draw_ex(FontBLF *font,
+                             GlyphCacheBLF *gc,
+                             const char *str,
+                             size_t len,
+                             struct ResultBLF *r_info,
+                             int pen_y)
+{
+  if (len == 0) {
+    /* early output, don't do any IMM OpenGL. */
+    return;
+  }
+
+  GlyphRunBLF *run = blf_glyph_run_acquire(font, gc, str, len);
+
+  blf_batch_draw_begin(font);
+
+  for (int i = 0; i < run->glyphs_len; i++) {
+    /* do not return this loop if clipped, we want every character tested */
+    blf_glyph_render(font, gc, run->glyphs[i], (float)run->glyphs_pen_x[i], (float)pen_y);
+  }
+
   blf_batch_draw_end();
 
   if (r_info) {
     r_info->lines = 1;
-    r_info->width = pen_x;
+    r_info->width = run->pen_x;
   }
+
+  blf_glyph_run_release(run);
 }
 void blf_font_draw(FontBLF *font, const char *str, size_t len, struct ResultBLF *r_info)
 {
@@ -579,13 +710,10 @@ static void blf_font_draw_buffer_ex(FontBLF *font,
                                     struct ResultBLF *r_info,
                                     int pen_y)
 {
-  unsigned int c, c_prev = BLI_UTF8_ERR;
-  GlyphBLF *g, *g_prev = NULL;
-  int pen_x = (int)font->pos[0];
+  const int pen_x_basis = (int)font->pos[0];
   int pen_y_basis = (int)font->pos[1] + pen_y;
-  size_t i = 0;
 
-  GlyphBLF **glyph_ascii_table = blf_font_ensure_ascii_table(font, gc);
+  GlyphRunBLF *run = blf_glyph_run_acquire(font, gc, str, len);
 
   /* buffer specific vars */
   FontBufInfoBLF *buf_info = &font->buf_info;
@@ -594,24 +722,11 @@ static void blf_font_draw_buffer_ex(FontBLF *font,
   int chx, chy;
   int y, x;
 
-  BLF_KERNING_VARS(font, has_kerning, kern_mode);
-
-  blf_font_ensure_ascii_kerning(font, gc, kern_mode);
-
   /* another buffer specific call for color conversion */
 
-  while ((i < len) && str[i]) {
-    BLF_UTF8_NEXT_FAST(font, gc, g, str, i, c, glyph_ascii_table);
-
-    if (UNLIKELY(c == BLI_UTF8_ERR)) {
-      break;
-    }
-    if (UNLIKELY(g == NULL)) {
-      continue;
-    }
-    if (has_kerning) {
-      BLF_KERNING_STEP_FAST(font, kern_mode, g_prev, g, c_prev, c, pen_x);
-    }
+  for (int i = 0; i < run->glyphs_len; i++) {
+    GlyphBLF *g = run->glyphs[i];
+    const int pen_x = pen_x_basis + run->glyphs_pen_x[i];
 
     chx = pen_x + ((int)g->pos_x);
     chy = pen_y_basis + g->height;
@@ -718,16 +833,14 @@ static void blf_font_draw_buffer_ex(FontBLF *font,
         }
       }
     }
-
-    pen_x += g->advance_i;
-    g_prev = g;
-    c_prev = c;
   }
 
   if (r_info) {
     r_info->lines = 1;
-    r_info->width = pen_x;
+    r_info->width = pen_x_basis + run->pen_x;
   }
+
+  blf_glyph_run_release(run);
 }
 
 void blf_font_draw_buffer(FontBLF *font, const char *str, size_t len, struct ResultBLF *r_info)
@@ -858,60 +971,9 @@ static void blf_font_boundbox_ex(FontBLF *font,
                                  struct ResultBLF *r_info,
                                  int pen_y)
 {
-  unsigned int c, c_prev = BLI_UTF8_ERR;
-  GlyphBLF *g, *g_prev = NULL;
-  int pen_x = 0;
-  size_t i = 0;
-
-  GlyphBLF **glyph_ascii_table = blf_font_ensure_ascii_table(font, gc);
-
-  rctf gbox;
-
-  BLF_KERNING_VARS(font, has_kerning, kern_mode);
-
-  box->xmin = 32000.0f;
-  box->xmax = -32000.0f;
-  box->ymin = 32000.0f;
-  box->ymax = -32000.0f;
-
-  blf_font_ensure_ascii_kerning(font, gc, kern_mode);
+  GlyphRunBLF *run = blf_glyph_run_acquire(font, gc, str, len);
 
-  while ((i < len) && str[i]) {
-    BLF_UTF8_NEXT_FAST(font, gc, g, str, i, c, glyph_ascii_table);
-
-    if (UNLIKELY(c == BLI_UTF8_ERR)) {
-      break;
-    }
-    if (UNLIKELY(g == NULL)) {
-      continue;
-    }
-    if (has_kerning) {
-      BLF_KERNING_STEP_FAST(font, kern_mode, g_prev, g, c_prev, c, pen_x);
-    }
-
-    gbox.xmin = (float)pen_x;
-    gbox.xmax = (float)pen_x + g->advance;
-    gbox.ymin = g->box.ymin + (float)pen_y;
-    gbox.ymax = g->box.ymax + (float)pen_y;
-
-    if (gbox.xmin < box->xmin) {
-      box->xmin = gbox.xmin;
-    }
-    if (gbox.ymin < box->ymin) {
-      box->ymin = gbox.ymin;
-    }
-
-    if (gbox.xmax > box->xmax) {
-      box->xmax = gbox.xmax;
-    }
-    if (gbox.ymax > box->ymax) {
-      box->ymax = gbox.ymax;
-    }
-
-    pen_x += g->advance_i;
-    g_prev = g;
-    c_prev = c;
-  }
+  *box = run->box;
 
   if (box->xmin > box->xmax) {
     box->xmin = 0.0f;
@@ -919,11 +981,17 @@ static void blf_font_boundbox_ex(FontBLF *font,
     box->xmax = 0.0f;
     box->ymax = 0.0f;
   }
+  else {
+    box->ymin += (float)pen_y;
+    box->ymax += (float)pen_y;
+  }
 
   if (r_info) {
     r_info->lines = 1;
-    r_info->width = pen_x;
+    r_info->width = run->pen_x;
   }
+
+  blf_glyph_run_release(run);
 }
 void blf_font_boundbox(
     FontBLF *font, const char *str, size_t len, rctf *r_box, struct ResultBLF *r_info)
@@ -40,6 +40,7 @@
 #include "DNA_userdef_types.h"
 #include "DNA_vec_types.h"
 
+#include "BLI_ghash.h"
 #include "BLI_listbase.h"
 #include "BLI_rect.h"
 #include "BLI_threads.h"
@@ -139,7 +140,7 @@ GlyphCacheBLF *blf_glyph_cache_new(FontBLF *font)
   gc->dpi = font->dpi;
 
   memset(gc->glyph_ascii_table, 0, sizeof(gc->glyph_ascii_table));
-  memset(gc->bucket, 0, sizeof(gc->bucket));
+  gc->glyphs = BLI_ghash_int_new(__func__);
 
   gc->glyphs_len_max = (int)font->face->num_glyphs;
   gc->glyphs_len_free = (int)font->face->num_glyphs;
@@ -209,13 +210,10 @@ void blf_glyph_cache_clear(FontBLF *font)
 
 void blf_glyph_cache_free(GlyphCacheBLF *gc)
 {
-  GlyphBLF *g;
-  unsigned int i;
-
-  for (i = 0; i < 257; i++) {
-    while ((g = BLI_pophead(&gc->bucket[i]))) {
-      blf_glyph_free(g);
-    }
+  BLI_ghash_free(gc->glyphs, NULL, (GHashValFreeFP)blf_glyph_free);
+  if (gc->glyph_runs) {
+    BLI_ghash_free(gc->glyph_runs, NULL, NULL);
+    BLI_freelistN(&gc->glyph_runs_lru);
   }
   if (gc->texture) {
     GPU_texture_free(gc->texture);
@@ -228,18 +226,7 @@ void blf_glyph_cache_free(GlyphCacheBLF *gc)
 
 GlyphBLF *blf_glyph_search(GlyphCacheBLF *gc, unsigned int c)
 {
-  GlyphBLF *p;
-  unsigned int key;
-
-  key = blf_hash(c);
-  p = gc->bucket[key].first;
-  while (p) {
-    if (p->c == c) {
-      return p;
-    }
-    p = p->next;
-  }
-  return NULL;
+  return BLI_ghash_lookup(gc->glyphs, POINTER_FROM_UINT(c));
 }
 
 GlyphBLF *blf_glyph_add(FontBLF *font, GlyphCacheBLF *gc, unsigned int index, unsigned int c)
@@ -249,7 +236,6 @@ GlyphBLF *blf_glyph_add(FontBLF *font, GlyphCacheBLF *gc, unsigned int index, un
   FT_Error err;
   FT_Bitmap bitmap, tempbitmap;
   FT_BBox bbox;
-  unsigned int key;
 
   g = blf_glyph_search(gc, c);
   if (g) {
@@ -355,8 +341,7 @@ GlyphBLF *blf_glyph_add(FontBLF *font, GlyphCacheBLF *gc, unsigned int index, un
   g->box.ymin = ((float)bbox.yMin) / 64.0f;
   g->box.ymax = ((float)bbox.yMax) / 64.0f;
 
-  key = blf_hash(g->c);
-  BLI_addhead(&(gc->bucket[key]), g);
+  BLI_ghash_insert(gc->glyphs, POINTER_FROM_UINT(g->c), g);
 
   BLI_spin_unlock(font->ft_lib_mutex);
 
@@ -35,7 +35,6 @@ void blf_batch_draw_begin(struct FontBLF *font);
 void blf_batch_draw(void);
 
 unsigned int blf_next_p2(unsigned int x);
-unsigned int blf_hash(unsigned int val);
 
 char *blf_dir_search(const char *file);
 char *blf_dir_metrics_search(const char *filename);
@@ -65,8 +65,13 @@ typedef struct GlyphCacheBLF {
   /* and dpi. */
   unsigned int dpi;
 
-  /* and the glyphs. */
-  ListBase bucket[257];
+  /* and the glyphs, from the unicode character. */
+  struct GHash *glyphs;
+
+  /* strings laid out with the glyphs, see #GlyphRunBLF. */
+  struct GHash *glyph_runs;
+  /* the same runs, most recently used first. */
+  ListBase glyph_runs_lru;
 
   /* fast ascii lookup */
   struct GlyphBLF *glyph_ascii_table[256];
@@ -94,9 +99,6 @@ typedef struct GlyphCacheBLF {
 } GlyphCacheBLF;
 
 typedef struct GlyphBLF {
-  struct GlyphBLF *next;
-  struct GlyphBLF *prev;
-
   /* and the character, as UTF8 */
   unsigned int c;
 
@@ -134,6 +136,31 @@ typedef struct GlyphBLF {
   struct GlyphCacheBLF *glyph_cache;
 } GlyphBLF;
 
+/* A string laid out once, so that drawing or measuring it again
+ * does not have to decode, search and kern every character. */
+typedef struct GlyphRunBLF {
+  struct GlyphRunBLF *next;
+  struct GlyphRunBLF *prev;
+
+  /* the string, not null terminated. */
+  const char *str;
+  size_t str_len;
+
+  /* kerning mode used for the layout. */
+  FT_UInt kern_mode;
+
+  /* the glyphs of the string and the pen position of each one. */
+  struct GlyphBLF **glyphs;
+  int *glyphs_pen_x;
+  int glyphs_len;
+
+  /* pen position after the last glyph. */
+  int pen_x;
+
+  /* bounds of the glyphs, xmin > xmax when there are none. */
+  rctf box;
+} GlyphRunBLF;
+
 typedef struct FontBufInfoBLF {
   /* for draw to buffer, always set this to NULL after finish! */
   float *fbuf;
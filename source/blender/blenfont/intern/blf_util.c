@@ -42,17 +42,3 @@ unsigned int blf_next_p2(unsigned int x)
   x += 1;
   return x;
 }
-
-unsigned int blf_hash(unsigned int val)
-{
-  unsigned int key;
-
-  key = val;
-  key += ~(key << 16);
-  key ^= (key >> 5);
-  key += (key << 3);
-  key ^= (key >> 13);
-  key += ~(key << 9);
-  key ^= (key >> 17);
-  return key % 257;
-}
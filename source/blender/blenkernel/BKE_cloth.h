@@ -89,6 +89,7 @@ typedef struct Cloth {
   short pad3;
   struct BVHTree *bvhtree;     /* collision tree for this cloth object */
   struct BVHTree *bvhselftree; /* collision tree for this cloth object */
+  struct SpatialHash *selfhash; /* used instead of bvhselftree with CLOTH_SELF_BROADPHASE_HASH */
   struct MVertTri *tri;
   struct Implicit_Data *implicit; /* our implicit solver connects to this pointer */
   struct EdgeSet *edgeset;        /* used for selfcollisions */
@@ -228,6 +229,19 @@ typedef enum {
   CLOTH_BENDING_ANGULAR = 1,
 } CLOTH_BENDING_MODEL;
 
+/* ClothSimSettings.preconditioner. */
+typedef enum {
+  CLOTH_PRECONDITIONER_NONE = 0,
+  CLOTH_PRECONDITIONER_JACOBI = 1,
+  CLOTH_PRECONDITIONER_BLOCK_JACOBI = 2,
+} CLOTH_PRECONDITIONER;
+
+/* ClothCollSettings.self_broadphase. */
+typedef enum {
+  CLOTH_SELF_BROADPHASE_BVH = 0,
+  CLOTH_SELF_BROADPHASE_HASH = 1,
+} CLOTH_SELF_BROADPHASE;
+
 /* COLLISION FLAGS */
 typedef enum {
   CLOTH_COLLSETTINGS_FLAG_ENABLED = (1 << 1), /* enables cloth - object collisions */
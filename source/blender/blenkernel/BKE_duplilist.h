@@ -36,6 +36,8 @@ struct Scene;
 /* ---------------------------------------------------- */
 /* Dupli-Geometry */
 
+/* The duplis are stored in arrays owned by the list, which must only be freed with
+ * free_object_duplilist. */
 struct ListBase *object_duplilist(struct Depsgraph *depsgraph,
                                   struct Scene *sce,
                                   struct Object *ob);
@@ -156,6 +156,9 @@ typedef struct Main {
    */
   struct MainIDRelations *relations;
 
+  /** Registry of the names used by local IDs, see #BKE_main_idmap.h. */
+  struct UniqueName_Map *name_map;
+
   struct MainLock *lock;
 } Main;
 
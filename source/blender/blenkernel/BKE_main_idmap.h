@@ -20,14 +20,20 @@
  * \ingroup bke
  *
  * API to generate and use a mapping from [ID type & name] to [id pointer], within a given Main
- * data-base.
+ * data-base, and a registry of the names used by its local data-blocks, so that a unique name can
+ * be found without going over all the data-blocks of the same type.
+ *
+ * The name registry is stored in #Main.name_map and generated on demand, it is kept up to date by
+ * #BKE_id_new_name_validate and by the code removing data-blocks from Main. Code changing the
+ * names of many data-blocks at once behind its back has to call #BKE_main_namemap_clear.
  *
  * \note `BKE_main` files are for operations over the Main database itself, or generating extra
  * temp data to help working with it. Those should typically not affect the data-blocks themselves.
  *
  * \section Function Names
  *
- * - `BKE_main_idmap_` Should be used for functions in that file.
+ * - `BKE_main_idmap_` Should be used for functions of the ID map.
+ * - `BKE_main_namemap_` Should be used for functions of the name registry.
  */
 
 #include "BLI_compiler_attrs.h"
@@ -39,6 +45,7 @@ extern "C" {
 struct ID;
 struct IDNameLib_Map;
 struct Main;
+struct UniqueName_Map;
 
 enum {
   MAIN_IDMAP_TYPE_NAME = 1 << 0,
@@ -66,6 +73,16 @@ struct ID *BKE_main_idmap_lookup_uuid(struct IDNameLib_Map *id_typemap,
                                       const uint session_uuid) ATTR_WARN_UNUSED_RESULT
     ATTR_NONNULL(1);
 
+void BKE_main_namemap_destroy(struct UniqueName_Map **r_name_map) ATTR_NONNULL();
+void BKE_main_namemap_clear(struct Main *bmain) ATTR_NONNULL();
+
+bool BKE_main_namemap_get_free_number(struct Main *bmain,
+                                      struct ID *id,
+                                      const char *name,
+                                      int *r_number) ATTR_NONNULL();
+void BKE_main_namemap_add_name(struct Main *bmain, struct ID *id) ATTR_NONNULL();
+void BKE_main_namemap_remove_name(struct Main *bmain, struct ID *id) ATTR_NONNULL();
+
 #ifdef __cplusplus
 }
 #endif
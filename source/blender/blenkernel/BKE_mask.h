@@ -328,6 +328,8 @@ void BKE_maskrasterize_buffer(MaskRasterHandle *mr_handle,
                               const unsigned int height,
                               float *buffer);
 
+void BKE_maskrasterize_cache_free(void);
+
 #ifdef __cplusplus
 }
 #endif
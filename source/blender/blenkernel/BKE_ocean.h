@@ -99,6 +99,10 @@ void BKE_ocean_simulate(struct Ocean *o, float t, float scale, float chop_amount
 /* sampling the ocean surface */
 float BKE_ocean_jminus_to_foam(float jminus, float coverage);
 void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float v);
+void BKE_ocean_eval_uv_array(struct Ocean *oc,
+                             struct OceanResult *r_ocr,
+                             const float (*uv)[2],
+                             const int uv_len);
 void BKE_ocean_eval_uv_catrom(struct Ocean *oc, struct OceanResult *ocr, float u, float v);
 void BKE_ocean_eval_xz(struct Ocean *oc, struct OceanResult *ocr, float x, float z);
 void BKE_ocean_eval_xz_catrom(struct Ocean *oc, struct OceanResult *ocr, float x, float z);
@@ -122,6 +126,11 @@ void BKE_ocean_bake(struct Ocean *o,
                     void *update_cb_data);
 void BKE_ocean_cache_eval_uv(
     struct OceanCache *och, struct OceanResult *ocr, int f, float u, float v);
+void BKE_ocean_cache_eval_uv_array(struct OceanCache *och,
+                                   struct OceanResult *r_ocr,
+                                   int f,
+                                   const float (*uv)[2],
+                                   const int uv_len);
 void BKE_ocean_cache_eval_ij(struct OceanCache *och, struct OceanResult *ocr, int f, int i, int j);
 
 void BKE_ocean_free_cache(struct OceanCache *och);
@@ -184,8 +184,7 @@ typedef struct ParticleThreadContext {
 
 typedef struct ParticleTask {
   ParticleThreadContext *ctx;
-  struct RNG *rng, *rng_path;
-  int begin, end;
+  struct RNG *rng;
 } ParticleTask;
 
 typedef struct ParticleCollisionElement {
@@ -451,12 +450,6 @@ void psys_get_dupli_path_transform(struct ParticleSimulationData *sim,
 void psys_thread_context_init(struct ParticleThreadContext *ctx,
                               struct ParticleSimulationData *sim);
 void psys_thread_context_free(struct ParticleThreadContext *ctx);
-void psys_tasks_create(struct ParticleThreadContext *ctx,
-                       int startpart,
-                       int endpart,
-                       struct ParticleTask **r_tasks,
-                       int *r_numtasks);
-void psys_tasks_free(struct ParticleTask *tasks, int numtasks);
 
 void psys_apply_hair_lattice(struct Depsgraph *depsgraph,
                              struct Scene *scene,
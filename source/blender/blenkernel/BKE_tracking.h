@@ -328,6 +328,7 @@ struct AutoTrackContext *BKE_autotrack_context_new(struct MovieClip *clip,
                                                    const bool backwards,
                                                    const bool sequence);
 bool BKE_autotrack_context_step(struct AutoTrackContext *context);
+int BKE_autotrack_context_step_frames(struct AutoTrackContext *context, const int num_frames);
 void BKE_autotrack_context_sync(struct AutoTrackContext *context);
 void BKE_autotrack_context_sync_user(struct AutoTrackContext *context, struct MovieClipUser *user);
 void BKE_autotrack_context_finish(struct AutoTrackContext *context);
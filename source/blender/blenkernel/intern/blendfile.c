@@ -52,6 +52,7 @@
 #include "BKE_layer.h"
 #include "BKE_lib_id.h"
 #include "BKE_main.h"
+#include "BKE_mask.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
@@ -167,6 +168,8 @@ static void setup_app_data(bContext *C,
   /* Free all render results, without this stale data gets displayed after loading files */
   if (mode != LOAD_UNDO) {
     RE_FreeAllRenderResults();
+    /* Masks of the previous file are not drawn again. */
+    BKE_maskrasterize_cache_free();
   }
 
   /* Only make filepaths compatible when loading for real (not undo) */
@@ -34,6 +34,7 @@
 #include "BLI_linklist.h"
 #include "BLI_math.h"
 #include "BLI_rand.h"
+#include "BLI_spatial_hash.h"
 #include "BLI_utildefines.h"
 
 #include "DEG_depsgraph.h"
@@ -104,6 +105,7 @@ void cloth_init(ClothModifierData *clmd)
   clmd->sim_parms->stepsPerFrame = 5;
   clmd->sim_parms->flags = 0;
   clmd->sim_parms->solver_type = 0;
+  clmd->sim_parms->preconditioner = CLOTH_PRECONDITIONER_NONE;
   clmd->sim_parms->maxspringlen = 10;
   clmd->sim_parms->vgroup_mass = 0;
   clmd->sim_parms->vgroup_shrink = 0;
@@ -124,6 +126,7 @@ void cloth_init(ClothModifierData *clmd)
   clmd->coll_parms->flags = CLOTH_COLLSETTINGS_FLAG_ENABLED;
   clmd->coll_parms->collision_list = NULL;
   clmd->coll_parms->selfepsilon = 0.015;
+  clmd->coll_parms->self_broadphase = CLOTH_SELF_BROADPHASE_BVH;
   clmd->coll_parms->vgroup_selfcol = 0;
 
   /* These defaults are copied from softbody.c's
@@ -240,6 +243,10 @@ void bvhtree_update_from_cloth(ClothModifierData *clmd, bool moving, bool self)
   BLI_assert(!(clmd->hairdata != NULL && self));
 
   if (self) {
+    /* Only built when used, self collisions may use #CLOTH_SELF_BROADPHASE_HASH instead. */
+    if (cloth->bvhselftree == NULL) {
+      cloth->bvhselftree = bvhtree_build_from_cloth(clmd, clmd->coll_parms->selfepsilon);
+    }
     bvhtree = cloth->bvhselftree;
   }
   else {
@@ -575,6 +582,10 @@ void cloth_free_modifier(ClothModifierData *clmd)
       BLI_bvhtree_free(cloth->bvhselftree);
     }
 
+    if (cloth->selfhash) {
+      BLI_spatial_hash_free(cloth->selfhash);
+    }
+
     // we save our faces for collision objects
     if (cloth->tri) {
       MEM_freeN(cloth->tri);
@@ -657,6 +668,10 @@ void cloth_free_modifier_extern(ClothModifierData *clmd)
       BLI_bvhtree_free(cloth->bvhselftree);
     }
 
+    if (cloth->selfhash) {
+      BLI_spatial_hash_free(cloth->selfhash);
+    }
+
     // we save our faces for collision objects
     if (cloth->tri) {
       MEM_freeN(cloth->tri);
@@ -925,7 +940,6 @@ static int cloth_from_object(
   }
 
   clmd->clothObject->bvhtree = bvhtree_build_from_cloth(clmd, clmd->coll_parms->epsilon);
-  clmd->clothObject->bvhselftree = bvhtree_build_from_cloth(clmd, clmd->coll_parms->selfepsilon);
 
   return 1;
 }
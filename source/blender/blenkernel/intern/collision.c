@@ -35,6 +35,7 @@
 #include "BLI_ghash.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
+#include "BLI_spatial_hash.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
@@ -1617,6 +1618,45 @@ static bool cloth_bvh_self_overlap_cb(void *userdata, int index_a, int index_b,
   return false;
 }
 
+static void cloth_selfhash_update_cb(void *__restrict userdata,
+                                     const int index,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  Cloth *cloth = (Cloth *)userdata;
+  const ClothVertex *verts = cloth->verts;
+  const MVertTri *vt = &cloth->tri[index];
+  float co[3][3], co_moving[3][3];
+
+  for (int i = 0; i < 3; i++) {
+    copy_v3_v3(co[i], verts[vt->tri[i]].txold);
+    copy_v3_v3(co_moving[i], verts[vt->tri[i]].tx);
+  }
+
+  BLI_spatial_hash_update_item(cloth->selfhash, index, co[0], co_moving[0], 3);
+}
+
+/* Alternative to the overlap of bvhselftree, rebuilt from scratch every step. The triangles are
+ * bounded over their motion during the step, so candidates which may touch in between are kept
+ * and the others are filtered out. */
+static BVHTreeOverlap *cloth_selfhash_overlap(ClothModifierData *clmd, uint *r_overlap_tot)
+{
+  Cloth *cloth = clmd->clothObject;
+
+  if (cloth->selfhash == NULL) {
+    cloth->selfhash = BLI_spatial_hash_new(cloth->primitive_num, clmd->coll_parms->selfepsilon);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = true;
+  BLI_task_parallel_range(0, cloth->primitive_num, cloth, cloth_selfhash_update_cb, &settings);
+
+  BLI_spatial_hash_update(cloth->selfhash);
+
+  return BLI_spatial_hash_overlap_self(
+      cloth->selfhash, r_overlap_tot, cloth_bvh_self_overlap_cb, clmd);
+}
+
 int cloth_bvh_collision(
     Depsgraph *depsgraph, Object *ob, ClothModifierData *clmd, float step, float dt)
 {
@@ -1675,10 +1715,20 @@ int cloth_bvh_collision(
   }
 
   if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
-    bvhtree_update_from_cloth(clmd, false, true);
+    if (clmd->coll_parms->self_broadphase == CLOTH_SELF_BROADPHASE_HASH) {
+      overlap_self = cloth_selfhash_overlap(clmd, &coll_count_self);
+    }
+    else {
+      bvhtree_update_from_cloth(clmd, false, true);
 
-    overlap_self = BLI_bvhtree_overlap(
-        cloth->bvhselftree, cloth->bvhselftree, &coll_count_self, cloth_bvh_self_overlap_cb, clmd);
+      if (cloth->bvhselftree) {
+        overlap_self = BLI_bvhtree_overlap(cloth->bvhselftree,
+                                           cloth->bvhselftree,
+                                           &coll_count_self,
+                                           cloth_bvh_self_overlap_cb,
+                                           clmd);
+      }
+    }
   }
 
   do {
@@ -1733,16 +1783,13 @@ int cloth_bvh_collision(
       verts = cloth->verts;
       mvert_num = cloth->mvert_num;
 
-      if (cloth->bvhselftree) {
-        if (coll_count_self && overlap_self) {
-          collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self,
-                                               "collision array");
-
-          if (cloth_bvh_selfcollisions_nearcheck(
-                  clmd, collisions, coll_count_self, overlap_self)) {
-            ret += cloth_bvh_selfcollisions_resolve(clmd, collisions, coll_count_self, dt);
-            ret2 += ret;
-          }
+      if (coll_count_self && overlap_self) {
+        collisions = (CollPair *)MEM_mallocN(sizeof(CollPair) * coll_count_self,
+                                             "collision array");
+
+        if (cloth_bvh_selfcollisions_nearcheck(clmd, collisions, coll_count_self, overlap_self)) {
+          ret += cloth_bvh_selfcollisions_resolve(clmd, collisions, coll_count_self, dt);
+          ret2 += ret;
         }
       }
 
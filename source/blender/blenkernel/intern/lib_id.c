@@ -106,6 +106,7 @@
 #include "BKE_lightprobe.h"
 #include "BKE_linestyle.h"
 #include "BKE_main.h"
+#include "BKE_main_idmap.h"
 #include "BKE_mask.h"
 #include "BKE_material.h"
 #include "BKE_mball.h"
@@ -196,7 +197,7 @@ static void lib_id_clear_library_data_ex(Main *bmain, ID *id)
   id->tag &= ~(LIB_TAG_INDIRECT | LIB_TAG_EXTERN);
   id->flag &= ~LIB_INDIRECT_WEAK_LINK;
   if (id_in_mainlist) {
-    if (BKE_id_new_name_validate(which_libbase(bmain, GS(id->name)), id, NULL)) {
+    if (BKE_id_new_name_validate(bmain, which_libbase(bmain, GS(id->name)), id, NULL)) {
       bmain->is_memfile_undo_written = false;
     }
   }
@@ -770,7 +771,7 @@ void BKE_libblock_management_main_add(Main *bmain, void *idv)
   ListBase *lb = which_libbase(bmain, GS(id->name));
   BKE_main_lock(bmain);
   BLI_addtail(lb, id);
-  BKE_id_new_name_validate(lb, id, NULL);
+  BKE_id_new_name_validate(bmain, lb, id, NULL);
   /* alphabetic insertion: is in new_id */
   id->tag &= ~(LIB_TAG_NO_MAIN | LIB_TAG_NO_USER_REFCOUNT);
   bmain->is_memfile_undo_written = false;
@@ -794,6 +795,7 @@ void BKE_libblock_management_main_remove(Main *bmain, void *idv)
   ListBase *lb = which_libbase(bmain, GS(id->name));
   BKE_main_lock(bmain);
   BLI_remlink(lb, id);
+  BKE_main_namemap_remove_name(bmain, id);
   id->tag |= LIB_TAG_NO_MAIN;
   bmain->is_memfile_undo_written = false;
   BKE_main_unlock(bmain);
@@ -926,7 +928,7 @@ void BKE_main_id_repair_duplicate_names_listbase(ListBase *lb)
   }
   for (i = 0; i < lb_len; i++) {
     if (!BLI_gset_add(gset, id_array[i]->name + 2)) {
-      BKE_id_new_name_validate(lb, id_array[i], NULL);
+      BKE_id_new_name_validate(NULL, lb, id_array[i], NULL);
     }
   }
   BLI_gset_free(gset, NULL);
@@ -1022,7 +1024,7 @@ void *BKE_libblock_alloc(Main *bmain, short type, const char *name, const int fl
 
       BKE_main_lock(bmain);
       BLI_addtail(lb, id);
-      BKE_id_new_name_validate(lb, id, name);
+      BKE_id_new_name_validate(bmain, lb, id, name);
       bmain->is_memfile_undo_written = false;
       /* alphabetic insertion: is in new_id */
       BKE_main_unlock(bmain);
@@ -1583,6 +1585,42 @@ static bool check_for_dupid(ListBase *lb, ID *id, char *name, ID **r_id_sorting_
 #undef MAX_NUMBERS_IN_USE
 }
 
+/**
+ * Same as #check_for_dupid, using the name registry of \a bmain to find used names and numbers
+ * instead of looping over all IDs of the same type.
+ */
+static bool check_for_dupid_namemap(Main *bmain, ID *id, char *name)
+{
+  BLI_assert(strlen(name) < MAX_ID_NAME - 2);
+
+  bool is_name_changed = false;
+
+  while (true) {
+    /* Get the name and number parts ("name.number"). */
+    char base_name[MAX_ID_NAME - 2];
+    int number = MIN_NUMBER;
+    size_t base_name_len = BLI_split_name_num(base_name, &number, name, '.');
+
+    /* In case we get an insane initial number suffix in given name. */
+    if (number >= MAX_NUMBER || number < MIN_NUMBER) {
+      number = MIN_NUMBER;
+    }
+
+    /* If there is no double, we are done. */
+    if (!BKE_main_namemap_get_free_number(bmain, id, name, &number)) {
+      return is_name_changed;
+    }
+
+    is_name_changed = true;
+
+    /* If id_name_final_build helper returns false, it had to truncate further given name, hence
+     * we have to go over the whole check again. */
+    if (id_name_final_build(name, base_name, base_name_len, number)) {
+      return is_name_changed;
+    }
+  }
+}
+
 #undef MIN_NUMBER
 #undef MAX_NUMBER
 
@@ -1591,9 +1629,11 @@ static bool check_for_dupid(ListBase *lb, ID *id, char *name, ID **r_id_sorting_
  *
  * Only for local IDs (linked ones already have a unique ID in their library).
  *
+ * \param bmain: The Main \a lb belongs to, if given its name registry is used and kept up to
+ * date, instead of looping over the whole \a lb.
  * \return true if a new name had to be created.
  */
-bool BKE_id_new_name_validate(ListBase *lb, ID *id, const char *tname)
+bool BKE_id_new_name_validate(Main *bmain, ListBase *lb, ID *id, const char *tname)
 {
   bool result;
   char name[MAX_ID_NAME - 2];
@@ -1622,8 +1662,15 @@ bool BKE_id_new_name_validate(ListBase *lb, ID *id, const char *tname)
   }
 
   ID *id_sorting_hint = NULL;
-  result = check_for_dupid(lb, id, name, &id_sorting_hint);
-  strcpy(id->name + 2, name);
+  if (bmain != NULL) {
+    result = check_for_dupid_namemap(bmain, id, name);
+    strcpy(id->name + 2, name);
+    BKE_main_namemap_add_name(bmain, id);
+  }
+  else {
+    result = check_for_dupid(lb, id, name, &id_sorting_hint);
+    strcpy(id->name + 2, name);
+  }
 
   /* This was in 2.43 and previous releases
    * however all data in blender should be sorted, not just duplicate names
@@ -2091,8 +2138,15 @@ void BLI_libblock_ensure_unique_name(Main *bmain, const char *name)
   /* search for id */
   idtest = BLI_findstring(lb, name + 2, offsetof(ID, name) + 2);
   if (idtest != NULL) {
+    /* The name was set without updating the name registry, and is not necessarily the one of
+     * idtest, register it for all IDs using it. */
+    for (ID *id = idtest->next; id; id = id->next) {
+      if (STREQ(id->name + 2, name + 2)) {
+        BKE_main_namemap_add_name(bmain, id);
+      }
+    }
     /* BKE_id_new_name_validate also takes care of sorting. */
-    BKE_id_new_name_validate(lb, idtest, NULL);
+    BKE_id_new_name_validate(bmain, lb, idtest, NULL);
     bmain->is_memfile_undo_written = false;
   }
 }
@@ -2103,7 +2157,7 @@ void BLI_libblock_ensure_unique_name(Main *bmain, const char *name)
 void BKE_libblock_rename(Main *bmain, ID *id, const char *name)
 {
   ListBase *lb = which_libbase(bmain, GS(id->name));
-  if (BKE_id_new_name_validate(lb, id, name)) {
+  if (BKE_id_new_name_validate(bmain, lb, id, name)) {
     bmain->is_memfile_undo_written = false;
   }
 }
@@ -19,8 +19,12 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_bitmap.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_math_bits.h"
+#include "BLI_string.h"
+#include "BLI_string_utils.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_ID.h"
@@ -250,3 +254,296 @@ void BKE_main_idmap_destroy(struct IDNameLib_Map *id_map)
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BKE_main_namemap API
+ *
+ * Registry of the names used by local IDs, to find unique names in constant time.
+ * Unlike the ID map above, it is stored in #Main.name_map and kept up to date when data-blocks
+ * are added, renamed or removed.
+ *
+ * For each ID type, names are split in a base name and a number suffix ("name.number"), the
+ * registry keeps track of which numbers are used for each base name, so that the numbering
+ * rules of #BKE_id_new_name_validate can be applied without looping over all IDs.
+ *
+ * Several IDs may share a name (e.g. when they are being renamed), and several names may share
+ * a number ("name.1" and "name.001"), hence all entries are reference counted.
+ *
+ * \note Maps are initialized on demand, since many ID types are never renamed.
+ * \{ */
+
+/* Must match the values used by #BKE_id_new_name_validate. */
+#define MIN_NUMBER 1
+#define MAX_NUMBERS_IN_USE 1024
+
+typedef struct UniqueName_Base {
+  /** Base name, without the number suffix. */
+  char name[MAX_ID_NAME - 2];
+  /** Which numbers below #MAX_NUMBERS_IN_USE are used, 0 being the name without suffix. */
+  BLI_bitmap used_numbers[MAX_NUMBERS_IN_USE >> _BITMAP_POWER];
+  /** Largest used number, only valid when `max_number_dirty` is false. Only needed once all
+   * numbers below #MAX_NUMBERS_IN_USE are used, so it is computed on demand. */
+  int max_number;
+  bool max_number_dirty;
+  /** Number value to #UniqueName_Number using this base. */
+  GHash *numbers;
+} UniqueName_Base;
+
+typedef struct UniqueName_Number {
+  UniqueName_Base *base;
+  int number;
+  /** Amount of #UniqueName_Name using this number. */
+  int users;
+} UniqueName_Number;
+
+typedef struct UniqueName_Name {
+  char name[MAX_ID_NAME - 2];
+  UniqueName_Number *number;
+  /** Amount of IDs using this name. */
+  int users;
+} UniqueName_Name;
+
+typedef struct UniqueName_TypeMap {
+  /** ID pointer to the #UniqueName_Name it was registered with. */
+  GHash *ids;
+  /** Full name to #UniqueName_Name. */
+  GHash *names;
+  /** Base name to #UniqueName_Base. */
+  GHash *bases;
+} UniqueName_TypeMap;
+
+/**
+ * Opaque structure, external API users only see this.
+ */
+struct UniqueName_Map {
+  UniqueName_TypeMap type_maps[MAX_LIBARRAY];
+};
+
+static void namemap_base_free(void *ptr)
+{
+  UniqueName_Base *base = ptr;
+  BLI_ghash_free(base->numbers, NULL, MEM_freeN);
+  MEM_freeN(base);
+}
+
+static void namemap_type_remove_id(UniqueName_TypeMap *type_map, ID *id)
+{
+  UniqueName_Name *name = BLI_ghash_popkey(type_map->ids, id, NULL);
+  if (name == NULL || --name->users > 0) {
+    return;
+  }
+
+  UniqueName_Number *number = name->number;
+  BLI_ghash_remove(type_map->names, name->name, NULL, NULL);
+  MEM_freeN(name);
+  if (--number->users > 0) {
+    return;
+  }
+
+  UniqueName_Base *base = number->base;
+  BLI_ghash_remove(base->numbers, POINTER_FROM_INT(number->number), NULL, NULL);
+  if (BLI_ghash_len(base->numbers) == 0) {
+    BLI_ghash_remove(type_map->bases, base->name, NULL, namemap_base_free);
+  }
+  else {
+    if (number->number < MAX_NUMBERS_IN_USE) {
+      BLI_BITMAP_DISABLE(base->used_numbers, number->number);
+    }
+    if (number->number == base->max_number) {
+      base->max_number_dirty = true;
+    }
+  }
+  MEM_freeN(number);
+}
+
+static void namemap_type_add_id(UniqueName_TypeMap *type_map, ID *id)
+{
+  const char *id_name = id->name + 2;
+
+  namemap_type_remove_id(type_map, id);
+
+  UniqueName_Name *name = BLI_ghash_lookup(type_map->names, id_name);
+  if (name == NULL) {
+    char base_name[MAX_ID_NAME - 2];
+    int number_value;
+    BLI_split_name_num(base_name, &number_value, id_name, '.');
+
+    UniqueName_Base *base = BLI_ghash_lookup(type_map->bases, base_name);
+    if (base == NULL) {
+      base = MEM_callocN(sizeof(*base), __func__);
+      STRNCPY(base->name, base_name);
+      base->max_number = -1;
+      base->numbers = BLI_ghash_int_new(__func__);
+      BLI_ghash_insert(type_map->bases, base->name, base);
+    }
+
+    UniqueName_Number *number = BLI_ghash_lookup(base->numbers, POINTER_FROM_INT(number_value));
+    if (number == NULL) {
+      number = MEM_mallocN(sizeof(*number), __func__);
+      number->base = base;
+      number->number = number_value;
+      number->users = 0;
+      BLI_ghash_insert(base->numbers, POINTER_FROM_INT(number_value), number);
+      if (number_value < MAX_NUMBERS_IN_USE) {
+        BLI_BITMAP_ENABLE(base->used_numbers, number_value);
+      }
+      if (!base->max_number_dirty && number_value > base->max_number) {
+        base->max_number = number_value;
+      }
+    }
+    number->users++;
+
+    name = MEM_mallocN(sizeof(*name), __func__);
+    STRNCPY(name->name, id_name);
+    name->number = number;
+    name->users = 0;
+    BLI_ghash_insert(type_map->names, name->name, name);
+  }
+  name->users++;
+
+  BLI_ghash_insert(type_map->ids, id, name);
+}
+
+static void namemap_base_max_number_update(UniqueName_Base *base)
+{
+  GHashIterator gh_iter;
+
+  base->max_number = -1;
+  GHASH_ITER (gh_iter, base->numbers) {
+    const UniqueName_Number *number = BLI_ghashIterator_getValue(&gh_iter);
+    base->max_number = MAX2(base->max_number, number->number);
+  }
+  base->max_number_dirty = false;
+}
+
+static UniqueName_TypeMap *namemap_type_get(Main *bmain, short id_type)
+{
+  if (bmain->name_map == NULL) {
+    return NULL;
+  }
+  UniqueName_TypeMap *type_map = &bmain->name_map->type_maps[BKE_idtype_idcode_to_index(id_type)];
+  return type_map->ids != NULL ? type_map : NULL;
+}
+
+static UniqueName_TypeMap *namemap_type_ensure(Main *bmain, short id_type)
+{
+  if (bmain->name_map == NULL) {
+    bmain->name_map = MEM_callocN(sizeof(*bmain->name_map), __func__);
+  }
+
+  UniqueName_TypeMap *type_map = &bmain->name_map->type_maps[BKE_idtype_idcode_to_index(id_type)];
+
+  /* lazy init */
+  if (type_map->ids == NULL) {
+    ListBase *lb = which_libbase(bmain, id_type);
+    const int lb_len = BLI_listbase_count(lb);
+
+    type_map->ids = BLI_ghash_ptr_new_ex(__func__, lb_len);
+    type_map->names = BLI_ghash_str_new_ex(__func__, lb_len);
+    type_map->bases = BLI_ghash_str_new(__func__);
+
+    LISTBASE_FOREACH (ID *, id, lb) {
+      if (!ID_IS_LINKED(id)) {
+        namemap_type_add_id(type_map, id);
+      }
+    }
+  }
+
+  return type_map;
+}
+
+void BKE_main_namemap_destroy(struct UniqueName_Map **r_name_map)
+{
+  struct UniqueName_Map *name_map = *r_name_map;
+  if (name_map == NULL) {
+    return;
+  }
+
+  UniqueName_TypeMap *type_map = name_map->type_maps;
+  for (int i = 0; i < MAX_LIBARRAY; i++, type_map++) {
+    if (type_map->ids) {
+      BLI_ghash_free(type_map->ids, NULL, NULL);
+      BLI_ghash_free(type_map->names, NULL, MEM_freeN);
+      BLI_ghash_free(type_map->bases, NULL, namemap_base_free);
+    }
+  }
+
+  MEM_freeN(name_map);
+  *r_name_map = NULL;
+}
+
+/**
+ * Discard the registry of \a bmain, it will be re-generated from the IDs on next use.
+ * Needed after names have been changed without going through #BKE_id_new_name_validate.
+ */
+void BKE_main_namemap_clear(Main *bmain)
+{
+  BKE_main_namemap_destroy(&bmain->name_map);
+}
+
+/**
+ * Check whether \a name is used by another local ID of the same type as \a id, and if so find
+ * the number to give it: the smallest unused one below #MAX_NUMBERS_IN_USE, or else the first
+ * one after both \a r_number and the largest used one.
+ *
+ * \a id itself does not count as a user of its current name, since it is being renamed.
+ *
+ * \return false if \a name is not used, \a r_number is not modified then.
+ */
+bool BKE_main_namemap_get_free_number(Main *bmain, ID *id, const char *name, int *r_number)
+{
+  UniqueName_TypeMap *type_map = namemap_type_ensure(bmain, GS(id->name));
+
+  namemap_type_remove_id(type_map, id);
+
+  const UniqueName_Name *name_used = BLI_ghash_lookup(type_map->names, name);
+  if (name_used == NULL) {
+    return false;
+  }
+
+  UniqueName_Base *base = name_used->number->base;
+  for (int block = 0; block < ARRAY_SIZE(base->used_numbers); block++) {
+    BLI_bitmap unused = ~base->used_numbers[block];
+    if (block == 0) {
+      unused &= ~(BLI_bitmap)((1u << MIN_NUMBER) - 1);
+    }
+    if (unused != 0) {
+      *r_number = (block << _BITMAP_POWER) + (int)bitscan_forward_uint(unused);
+      return true;
+    }
+  }
+
+  /* All numbers below #MAX_NUMBERS_IN_USE are used. */
+  if (base->max_number_dirty) {
+    namemap_base_max_number_update(base);
+  }
+  if (*r_number <= base->max_number) {
+    *r_number = base->max_number + 1;
+  }
+
+  return true;
+}
+
+/**
+ * Register the current name of \a id, replacing the name it was previously registered with.
+ */
+void BKE_main_namemap_add_name(Main *bmain, ID *id)
+{
+  UniqueName_TypeMap *type_map = namemap_type_get(bmain, GS(id->name));
+  if (type_map != NULL && !ID_IS_LINKED(id)) {
+    namemap_type_add_id(type_map, id);
+  }
+}
+
+/**
+ * Unregister \a id, to be called when it is removed from \a bmain.
+ */
+void BKE_main_namemap_remove_name(Main *bmain, ID *id)
+{
+  UniqueName_TypeMap *type_map = namemap_type_get(bmain, GS(id->name));
+  if (type_map != NULL) {
+    namemap_type_remove_id(type_map, id);
+  }
+}
+
+/** \} */
@@ -77,11 +77,13 @@
 #include "BLI_scanfill.h"
 #include "BLI_utildefines.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_rect.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_mask.h"
 
@@ -208,6 +210,9 @@ struct MaskRasterHandle {
 
   /* 2d bounds (to quickly skip bucket lookup) */
   rctf bounds;
+
+  /* cache entry owning the layers, NULL when the handle owns them */
+  struct MaskRasterCacheEntry *cache_entry;
 };
 
 /* --------------------------------------------------------------------- */
@@ -223,11 +228,10 @@ MaskRasterHandle *BKE_maskrasterize_handle_new(void)
   return mr_handle;
 }
 
-void BKE_maskrasterize_handle_free(MaskRasterHandle *mr_handle)
+static void maskrasterize_layers_free(MaskRasterLayer *layers, const unsigned int layers_tot)
 {
-  const unsigned int layers_tot = mr_handle->layers_tot;
   unsigned int i;
-  MaskRasterLayer *layer = mr_handle->layers;
+  MaskRasterLayer *layer = layers;
 
   for (i = 0; i < layers_tot; i++, layer++) {
 
@@ -253,7 +257,19 @@ void BKE_maskrasterize_handle_free(MaskRasterHandle *mr_handle)
     }
   }
 
-  MEM_freeN(mr_handle->layers);
+  MEM_freeN(layers);
+}
+
+static void maskrasterize_cache_entry_release(struct MaskRasterCacheEntry *entry);
+
+void BKE_maskrasterize_handle_free(MaskRasterHandle *mr_handle)
+{
+  if (mr_handle->cache_entry) {
+    maskrasterize_cache_entry_release(mr_handle->cache_entry);
+  }
+  else {
+    maskrasterize_layers_free(mr_handle->layers, mr_handle->layers_tot);
+  }
   MEM_freeN(mr_handle);
 }
 
@@ -575,6 +591,241 @@ static void layer_bucket_init(MaskRasterLayer *layer, const float pixel_size)
   BLI_memarena_free(arena);
 }
 
+/* --------------------------------------------------------------------- */
+/* cache of initialized layers                                           */
+/* --------------------------------------------------------------------- */
+
+/* Masks usually don't change on every frame (or redraw), initializing the layers is expensive
+ * though (scan-fill, feather and buckets), so they are kept around for the last few masks and
+ * shared between handles initialized from identical mask data. */
+
+/* Memory used by the cached layers, the least recently used are freed past it. */
+#define MASK_RASTER_CACHE_MEM_MAX (256 * 1024 * 1024)
+
+typedef struct MaskRasterCacheKey {
+  /* two hashes of the mask data, different seeds */
+  uint32_t hash[2];
+  int width, height;
+  bool do_aspect_correct, do_mask_aa, do_feather;
+} MaskRasterCacheKey;
+
+typedef struct MaskRasterCacheEntry {
+  struct MaskRasterCacheEntry *next, *prev;
+
+  MaskRasterCacheKey key;
+
+  MaskRasterLayer *layers;
+  unsigned int layers_tot;
+  rctf bounds;
+  /* memory used by the layers */
+  size_t mem_size;
+
+  /* handles using the layers, plus one while in the cache */
+  int users;
+} MaskRasterCacheEntry;
+
+static ListBase maskrasterize_cache = {NULL, NULL};
+static size_t maskrasterize_cache_mem_size = 0;
+static ThreadMutex maskrasterize_cache_mutex = BLI_MUTEX_INITIALIZER;
+
+static void maskrasterize_cache_key_add(BLI_HashMurmur2A mm2[2], const void *data, size_t len)
+{
+  BLI_hash_mm2a_add(&mm2[0], data, len);
+  BLI_hash_mm2a_add(&mm2[1], data, len);
+}
+
+static void maskrasterize_cache_key_add_points(BLI_HashMurmur2A mm2[2],
+                                               const MaskSplinePoint *points,
+                                               const int tot_point)
+{
+  for (int i = 0; i < tot_point; i++) {
+    const MaskSplinePoint *point = &points[i];
+    maskrasterize_cache_key_add(mm2, &point->bezt, sizeof(point->bezt));
+    maskrasterize_cache_key_add(mm2, &point->tot_uw, sizeof(point->tot_uw));
+    if (point->tot_uw) {
+      maskrasterize_cache_key_add(mm2, point->uw, sizeof(*point->uw) * (size_t)point->tot_uw);
+    }
+  }
+}
+
+/* Everything #BKE_maskrasterize_handle_init reads from the mask. */
+static void maskrasterize_cache_key_init(MaskRasterCacheKey *key,
+                                         Mask *mask,
+                                         const int width,
+                                         const int height,
+                                         const bool do_aspect_correct,
+                                         const bool do_mask_aa,
+                                         const bool do_feather)
+{
+  BLI_HashMurmur2A mm2[2];
+
+  BLI_hash_mm2a_init(&mm2[0], 0);
+  BLI_hash_mm2a_init(&mm2[1], 0x9e3779b9);
+
+  LISTBASE_FOREACH (MaskLayer *, masklay, &mask->masklayers) {
+    maskrasterize_cache_key_add(mm2, &masklay->restrictflag, sizeof(masklay->restrictflag));
+    maskrasterize_cache_key_add(mm2, &masklay->flag, sizeof(masklay->flag));
+    maskrasterize_cache_key_add(mm2, &masklay->alpha, sizeof(masklay->alpha));
+    maskrasterize_cache_key_add(mm2, &masklay->blend, sizeof(masklay->blend));
+    maskrasterize_cache_key_add(mm2, &masklay->blend_flag, sizeof(masklay->blend_flag));
+    maskrasterize_cache_key_add(mm2, &masklay->falloff, sizeof(masklay->falloff));
+
+    LISTBASE_FOREACH (MaskSpline *, spline, &masklay->splines) {
+      maskrasterize_cache_key_add(mm2, &spline->flag, sizeof(spline->flag));
+      maskrasterize_cache_key_add(mm2, &spline->offset_mode, sizeof(spline->offset_mode));
+      maskrasterize_cache_key_add(mm2, &spline->weight_interp, sizeof(spline->weight_interp));
+      maskrasterize_cache_key_add(mm2, &spline->tot_point, sizeof(spline->tot_point));
+      maskrasterize_cache_key_add_points(mm2, spline->points, spline->tot_point);
+      if (spline->points_deform) {
+        maskrasterize_cache_key_add_points(mm2, spline->points_deform, spline->tot_point);
+      }
+    }
+
+    /* separate the layers */
+    BLI_hash_mm2a_add_int(&mm2[0], -1);
+    BLI_hash_mm2a_add_int(&mm2[1], -1);
+  }
+
+  memset(key, 0, sizeof(*key));
+  key->hash[0] = BLI_hash_mm2a_end(&mm2[0]);
+  key->hash[1] = BLI_hash_mm2a_end(&mm2[1]);
+  key->width = width;
+  key->height = height;
+  key->do_aspect_correct = do_aspect_correct;
+  key->do_mask_aa = do_mask_aa;
+  key->do_feather = do_feather;
+}
+
+static bool maskrasterize_cache_key_cmp(const MaskRasterCacheKey *a, const MaskRasterCacheKey *b)
+{
+  return (a->hash[0] != b->hash[0]) || (a->hash[1] != b->hash[1]) || (a->width != b->width) ||
+         (a->height != b->height) || (a->do_aspect_correct != b->do_aspect_correct) ||
+         (a->do_mask_aa != b->do_mask_aa) || (a->do_feather != b->do_feather);
+}
+
+static void maskrasterize_cache_entry_handle_set(MaskRasterCacheEntry *entry,
+                                                 MaskRasterHandle *mr_handle)
+{
+  mr_handle->layers = entry->layers;
+  mr_handle->layers_tot = entry->layers_tot;
+  mr_handle->bounds = entry->bounds;
+  mr_handle->cache_entry = entry;
+  entry->users++;
+}
+
+static size_t maskrasterize_layers_mem_size(const MaskRasterLayer *layers,
+                                           const unsigned int layers_tot)
+{
+  size_t mem_size = MEM_allocN_len(layers);
+
+  for (unsigned int i = 0; i < layers_tot; i++) {
+    const MaskRasterLayer *layer = &layers[i];
+
+    if (layer->face_array) {
+      mem_size += MEM_allocN_len(layer->face_array);
+    }
+    if (layer->face_coords) {
+      mem_size += MEM_allocN_len(layer->face_coords);
+    }
+    if (layer->buckets_face) {
+      const unsigned int bucket_tot = layer->buckets_x * layer->buckets_y;
+      mem_size += MEM_allocN_len(layer->buckets_face);
+      for (unsigned int bucket_index = 0; bucket_index < bucket_tot; bucket_index++) {
+        if (layer->buckets_face[bucket_index]) {
+          mem_size += MEM_allocN_len(layer->buckets_face[bucket_index]);
+        }
+      }
+    }
+  }
+
+  return mem_size;
+}
+
+/* Caller must hold the lock. */
+static void maskrasterize_cache_entry_release_nolock(MaskRasterCacheEntry *entry)
+{
+  BLI_assert(entry->users > 0);
+  if (--entry->users == 0) {
+    maskrasterize_layers_free(entry->layers, entry->layers_tot);
+    MEM_freeN(entry);
+  }
+}
+
+static void maskrasterize_cache_entry_release(MaskRasterCacheEntry *entry)
+{
+  BLI_mutex_lock(&maskrasterize_cache_mutex);
+  maskrasterize_cache_entry_release_nolock(entry);
+  BLI_mutex_unlock(&maskrasterize_cache_mutex);
+}
+
+/**
+ * Make \a mr_handle use the cached layers matching \a key.
+ * \return false when there are none.
+ */
+static bool maskrasterize_cache_lookup(MaskRasterHandle *mr_handle, const MaskRasterCacheKey *key)
+{
+  bool found = false;
+
+  BLI_mutex_lock(&maskrasterize_cache_mutex);
+  LISTBASE_FOREACH (MaskRasterCacheEntry *, entry, &maskrasterize_cache) {
+    if (!maskrasterize_cache_key_cmp(&entry->key, key)) {
+      /* most recently used first */
+      BLI_remlink(&maskrasterize_cache, entry);
+      BLI_addhead(&maskrasterize_cache, entry);
+
+      maskrasterize_cache_entry_handle_set(entry, mr_handle);
+      found = true;
+      break;
+    }
+  }
+  BLI_mutex_unlock(&maskrasterize_cache_mutex);
+
+  return found;
+}
+
+/**
+ * Move the layers of the newly initialized \a mr_handle to the cache.
+ */
+static void maskrasterize_cache_add(MaskRasterHandle *mr_handle, const MaskRasterCacheKey *key)
+{
+  MaskRasterCacheEntry *entry = MEM_callocN(sizeof(*entry), __func__);
+
+  entry->key = *key;
+  entry->layers = mr_handle->layers;
+  entry->layers_tot = mr_handle->layers_tot;
+  entry->bounds = mr_handle->bounds;
+  entry->mem_size = maskrasterize_layers_mem_size(entry->layers, entry->layers_tot);
+  entry->users = 1;
+
+  BLI_mutex_lock(&maskrasterize_cache_mutex);
+  maskrasterize_cache_entry_handle_set(entry, mr_handle);
+  BLI_addhead(&maskrasterize_cache, entry);
+  maskrasterize_cache_mem_size += entry->mem_size;
+
+  /* Always keep the new entry, even when it's larger than the limit on its own. */
+  while (maskrasterize_cache_mem_size > MASK_RASTER_CACHE_MEM_MAX &&
+         maskrasterize_cache.last != entry) {
+    MaskRasterCacheEntry *entry_last = BLI_poptail(&maskrasterize_cache);
+    maskrasterize_cache_mem_size -= entry_last->mem_size;
+    maskrasterize_cache_entry_release_nolock(entry_last);
+  }
+  BLI_mutex_unlock(&maskrasterize_cache_mutex);
+}
+
+/**
+ * Free the cached layers, handles still using them keep them until they are freed.
+ */
+void BKE_maskrasterize_cache_free(void)
+{
+  BLI_mutex_lock(&maskrasterize_cache_mutex);
+  MaskRasterCacheEntry *entry;
+  while ((entry = BLI_pophead(&maskrasterize_cache))) {
+    maskrasterize_cache_entry_release_nolock(entry);
+  }
+  maskrasterize_cache_mem_size = 0;
+  BLI_mutex_unlock(&maskrasterize_cache_mutex);
+}
+
 void BKE_maskrasterize_handle_init(MaskRasterHandle *mr_handle,
                                    struct Mask *mask,
                                    const int width,
@@ -593,6 +844,13 @@ void BKE_maskrasterize_handle_init(MaskRasterHandle *mr_handle,
   MaskLayer *masklay;
   unsigned int masklay_index;
   MemArena *sf_arena;
+  MaskRasterCacheKey cache_key;
+
+  maskrasterize_cache_key_init(
+      &cache_key, mask, width, height, do_aspect_correct, do_mask_aa, do_feather);
+  if (maskrasterize_cache_lookup(mr_handle, &cache_key)) {
+    return;
+  }
 
   mr_handle->layers_tot = (unsigned int)BLI_listbase_count(&mask->masklayers);
   mr_handle->layers = MEM_mallocN(sizeof(MaskRasterLayer) * mr_handle->layers_tot,
@@ -1228,6 +1486,8 @@ void BKE_maskrasterize_handle_init(MaskRasterHandle *mr_handle,
   }
 
   BLI_memarena_free(sf_arena);
+
+  maskrasterize_cache_add(mr_handle, &cache_key);
 }
 
 /* --------------------------------------------------------------------- */
@@ -1324,11 +1584,10 @@ BLI_INLINE unsigned int layer_bucket_index_from_xy(MaskRasterLayer *layer, const
           layer->buckets_x);
 }
 
-static float layer_bucket_depth_from_xy(MaskRasterLayer *layer, const float xy[2])
+static float layer_bucket_depth_from_faces(MaskRasterLayer *layer,
+                                           const unsigned int *face_index,
+                                           const float xy[2])
 {
-  unsigned int index = layer_bucket_index_from_xy(layer, xy);
-  unsigned int *face_index = layer->buckets_face[index];
-
   if (face_index) {
     unsigned int(*face_array)[4] = layer->face_array;
     float(*cos)[3] = layer->face_coords;
@@ -1353,6 +1612,193 @@ static float layer_bucket_depth_from_xy(MaskRasterLayer *layer, const float xy[2
   }
 }
 
+static float layer_bucket_depth_from_xy(MaskRasterLayer *layer, const float xy[2])
+{
+  unsigned int index = layer_bucket_index_from_xy(layer, xy);
+  return layer_bucket_depth_from_faces(layer, layer->buckets_face[index], xy);
+}
+
+/**
+ * Fill \a r_values with the layer values along a row of pixels: 1.0 - depth inside the
+ * layer bounds, 0.0 outside.
+ *
+ * The bucket row is the same for all pixels, so the face list is only looked up again when
+ * crossing into the next bucket.
+ */
+static void layer_bucket_values_from_row(MaskRasterLayer *layer,
+                                         const float y,
+                                         const float x_inv,
+                                         const float x_px_ofs,
+                                         const unsigned int width,
+                                         float *r_values)
+{
+  const rctf *bounds = &layer->bounds;
+
+  if ((y < bounds->ymin) || (y > bounds->ymax)) {
+    memset(r_values, 0, sizeof(*r_values) * width);
+    return;
+  }
+
+  unsigned int **buckets_face_row =
+      &layer->buckets_face[((unsigned int)((y - bounds->ymin) * layer->buckets_xy_scalar[1])) *
+                           layer->buckets_x];
+  unsigned int bucket_x_prev = (unsigned int)-1;
+  unsigned int *face_index = NULL;
+  float xy[2];
+
+  xy[1] = y;
+  for (unsigned int x = 0; x < width; x++) {
+    xy[0] = ((float)x * x_inv) + x_px_ofs;
+
+    if ((xy[0] < bounds->xmin) || (xy[0] > bounds->xmax)) {
+      r_values[x] = 0.0f;
+      continue;
+    }
+
+    const unsigned int bucket_x = (unsigned int)((xy[0] - bounds->xmin) *
+                                                 layer->buckets_xy_scalar[0]);
+    if (bucket_x != bucket_x_prev) {
+      face_index = buckets_face_row[bucket_x];
+      bucket_x_prev = bucket_x;
+    }
+
+    r_values[x] = 1.0f - layer_bucket_depth_from_faces(layer, face_index, xy);
+  }
+}
+
+/**
+ * Apply the layer falloff and alpha to \a values.
+ * Loops are kept free of branches so they can be vectorized.
+ */
+BLI_INLINE void maskrasterize_layer_falloff(const MaskRasterLayer *layer,
+                                            float *values,
+                                            const unsigned int values_len)
+{
+  unsigned int i;
+
+  switch (layer->falloff) {
+    case PROP_SMOOTH:
+      /* ease - gives less hard lines for dilate/erode feather */
+      for (i = 0; i < values_len; i++) {
+        const float v = values[i];
+        values[i] = (3.0f * v * v - 2.0f * v * v * v);
+      }
+      break;
+    case PROP_SPHERE:
+      for (i = 0; i < values_len; i++) {
+        const float v = values[i];
+        values[i] = sqrtf(2.0f * v - v * v);
+      }
+      break;
+    case PROP_ROOT:
+      for (i = 0; i < values_len; i++) {
+        values[i] = sqrtf(values[i]);
+      }
+      break;
+    case PROP_SHARP:
+      for (i = 0; i < values_len; i++) {
+        values[i] = values[i] * values[i];
+      }
+      break;
+    case PROP_INVSQUARE:
+      for (i = 0; i < values_len; i++) {
+        values[i] = values[i] * (2.0f - values[i]);
+      }
+      break;
+    case PROP_LIN:
+    default:
+      /* nothing */
+      break;
+  }
+
+  if (layer->blend != MASK_BLEND_REPLACE) {
+    const float alpha = layer->alpha;
+    for (i = 0; i < values_len; i++) {
+      values[i] *= alpha;
+    }
+  }
+}
+
+/**
+ * Blend the (already faded) \a values_layer into \a values.
+ */
+BLI_INLINE void maskrasterize_layer_blend(const MaskRasterLayer *layer,
+                                          float *values,
+                                          float *values_layer,
+                                          const unsigned int values_len)
+{
+  unsigned int i;
+
+  if (layer->blend_flag & MASK_BLENDFLAG_INVERT) {
+    for (i = 0; i < values_len; i++) {
+      values_layer[i] = 1.0f - values_layer[i];
+    }
+  }
+
+  switch (layer->blend) {
+    case MASK_BLEND_MERGE_ADD:
+      for (i = 0; i < values_len; i++) {
+        values[i] += values_layer[i] * (1.0f - values[i]);
+      }
+      break;
+    case MASK_BLEND_MERGE_SUBTRACT:
+      for (i = 0; i < values_len; i++) {
+        values[i] -= values_layer[i] * values[i];
+      }
+      break;
+    case MASK_BLEND_ADD:
+      for (i = 0; i < values_len; i++) {
+        values[i] += values_layer[i];
+      }
+      break;
+    case MASK_BLEND_SUBTRACT:
+      for (i = 0; i < values_len; i++) {
+        values[i] -= values_layer[i];
+      }
+      break;
+    case MASK_BLEND_LIGHTEN:
+      for (i = 0; i < values_len; i++) {
+        values[i] = max_ff(values[i], values_layer[i]);
+      }
+      break;
+    case MASK_BLEND_DARKEN:
+      for (i = 0; i < values_len; i++) {
+        values[i] = min_ff(values[i], values_layer[i]);
+      }
+      break;
+    case MASK_BLEND_MUL:
+      for (i = 0; i < values_len; i++) {
+        values[i] *= values_layer[i];
+      }
+      break;
+    case MASK_BLEND_REPLACE: {
+      const float alpha = layer->alpha;
+      for (i = 0; i < values_len; i++) {
+        values[i] = (values[i] * (1.0f - alpha)) + (values_layer[i] * alpha);
+      }
+      break;
+    }
+    case MASK_BLEND_DIFFERENCE:
+      for (i = 0; i < values_len; i++) {
+        values[i] = fabsf(values[i] - values_layer[i]);
+      }
+      break;
+    default: /* same as add */
+      CLOG_ERROR(&LOG, "unhandled blend type: %d", layer->blend);
+      BLI_assert(0);
+      for (i = 0; i < values_len; i++) {
+        values[i] += values_layer[i];
+      }
+      break;
+  }
+
+  /* clamp after applying each layer so we don't get
+   * issues subtracting after accumulating over 1.0f */
+  for (i = 0; i < values_len; i++) {
+    CLAMP(values[i], 0.0f, 1.0f);
+  }
+}
+
 float BKE_maskrasterize_handle_sample(MaskRasterHandle *mr_handle, const float xy[2])
 {
   /* can't do this because some layers may invert */
@@ -1371,81 +1817,13 @@ float BKE_maskrasterize_handle_sample(MaskRasterHandle *mr_handle, const float x
     /* also used as signal for unused layer (when render is disabled) */
     if (layer->alpha != 0.0f && BLI_rctf_isect_pt_v(&layer->bounds, xy)) {
       value_layer = 1.0f - layer_bucket_depth_from_xy(layer, xy);
-
-      switch (layer->falloff) {
-        case PROP_SMOOTH:
-          /* ease - gives less hard lines for dilate/erode feather */
-          value_layer = (3.0f * value_layer * value_layer -
-                         2.0f * value_layer * value_layer * value_layer);
-          break;
-        case PROP_SPHERE:
-          value_layer = sqrtf(2.0f * value_layer - value_layer * value_layer);
-          break;
-        case PROP_ROOT:
-          value_layer = sqrtf(value_layer);
-          break;
-        case PROP_SHARP:
-          value_layer = value_layer * value_layer;
-          break;
-        case PROP_INVSQUARE:
-          value_layer = value_layer * (2.0f - value_layer);
-          break;
-        case PROP_LIN:
-        default:
-          /* nothing */
-          break;
-      }
-
-      if (layer->blend != MASK_BLEND_REPLACE) {
-        value_layer *= layer->alpha;
-      }
+      maskrasterize_layer_falloff(layer, &value_layer, 1);
     }
     else {
       value_layer = 0.0f;
     }
 
-    if (layer->blend_flag & MASK_BLENDFLAG_INVERT) {
-      value_layer = 1.0f - value_layer;
-    }
-
-    switch (layer->blend) {
-      case MASK_BLEND_MERGE_ADD:
-        value += value_layer * (1.0f - value);
-        break;
-      case MASK_BLEND_MERGE_SUBTRACT:
-        value -= value_layer * value;
-        break;
-      case MASK_BLEND_ADD:
-        value += value_layer;
-        break;
-      case MASK_BLEND_SUBTRACT:
-        value -= value_layer;
-        break;
-      case MASK_BLEND_LIGHTEN:
-        value = max_ff(value, value_layer);
-        break;
-      case MASK_BLEND_DARKEN:
-        value = min_ff(value, value_layer);
-        break;
-      case MASK_BLEND_MUL:
-        value *= value_layer;
-        break;
-      case MASK_BLEND_REPLACE:
-        value = (value * (1.0f - layer->alpha)) + (value_layer * layer->alpha);
-        break;
-      case MASK_BLEND_DIFFERENCE:
-        value = fabsf(value - value_layer);
-        break;
-      default: /* same as add */
-        CLOG_ERROR(&LOG, "unhandled blend type: %d", layer->blend);
-        BLI_assert(0);
-        value += value_layer;
-        break;
-    }
-
-    /* clamp after applying each layer so we don't get
-     * issues subtracting after accumulating over 1.0f */
-    CLAMP(value, 0.0f, 1.0f);
+    maskrasterize_layer_blend(layer, &value, &value_layer, 1);
   }
 
   return value;
@@ -1460,31 +1838,63 @@ typedef struct MaskRasterizeBufferData {
   float *buffer;
 } MaskRasterizeBufferData;
 
+typedef struct MaskRasterizeBufferChunk {
+  /* values of a single layer along the row, allocated on first use */
+  float *values_layer;
+} MaskRasterizeBufferChunk;
+
+/* Rasterize the row one layer at a time (instead of one pixel at a time),
+ * falloff and blending are then applied to the whole row at once. */
 static void maskrasterize_buffer_cb(void *__restrict userdata,
                                     const int y,
-                                    const TaskParallelTLS *__restrict UNUSED(tls))
+                                    const TaskParallelTLS *__restrict tls)
 {
   MaskRasterizeBufferData *data = userdata;
+  MaskRasterizeBufferChunk *chunk = tls->userdata_chunk;
 
   MaskRasterHandle *mr_handle = data->mr_handle;
-  float *buffer = data->buffer;
+  const unsigned int layers_tot = mr_handle->layers_tot;
+  MaskRasterLayer *layer = mr_handle->layers;
 
   const uint width = data->width;
-  const float x_inv = data->x_inv;
-  const float x_px_ofs = data->x_px_ofs;
+  float *values = &data->buffer[(size_t)y * width];
+  const float xy_y = ((float)y * data->y_inv) + data->y_px_ofs;
 
-  uint i = (uint)y * width;
-  float xy[2];
-  xy[1] = ((float)y * data->y_inv) + data->y_px_ofs;
-  for (uint x = 0; x < width; x++, i++) {
-    xy[0] = ((float)x * x_inv) + x_px_ofs;
+  if (chunk->values_layer == NULL) {
+    chunk->values_layer = MEM_mallocN(sizeof(*chunk->values_layer) * width, __func__);
+  }
+  float *values_layer = chunk->values_layer;
 
-    buffer[i] = BKE_maskrasterize_handle_sample(mr_handle, xy);
+  memset(values, 0, sizeof(*values) * width);
+
+  for (unsigned int i = 0; i < layers_tot; i++, layer++) {
+    /* also used as signal for unused layer (when render is disabled) */
+    if (layer->alpha != 0.0f) {
+      layer_bucket_values_from_row(layer, xy_y, data->x_inv, data->x_px_ofs, width, values_layer);
+      /* the falloff keeps pixels outside of the layer at zero */
+      maskrasterize_layer_falloff(layer, values_layer, width);
+    }
+    else {
+      memset(values_layer, 0, sizeof(*values_layer) * width);
+    }
+
+    maskrasterize_layer_blend(layer, values, values_layer, width);
+  }
+}
+
+static void maskrasterize_buffer_free(const void *__restrict UNUSED(userdata),
+                                      void *__restrict userdata_chunk)
+{
+  MaskRasterizeBufferChunk *chunk = userdata_chunk;
+  if (chunk->values_layer) {
+    MEM_freeN(chunk->values_layer);
   }
 }
 
 /**
  * \brief Rasterize a buffer from a single mask (threaded execution).
+ *
+ * Gives the same values as #BKE_maskrasterize_handle_sample at the pixel centers.
  */
 void BKE_maskrasterize_buffer(MaskRasterHandle *mr_handle,
                               const unsigned int width,
@@ -1503,8 +1913,12 @@ void BKE_maskrasterize_buffer(MaskRasterHandle *mr_handle,
       .width = width,
       .buffer = buffer,
   };
+  MaskRasterizeBufferChunk chunk = {NULL};
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.use_threading = ((size_t)height * width > 10000);
+  settings.userdata_chunk = &chunk;
+  settings.userdata_chunk_size = sizeof(chunk);
+  settings.func_free = maskrasterize_buffer_free;
   BLI_task_parallel_range(0, (int)height, &data, maskrasterize_buffer_cb, &settings);
 }
@@ -28,7 +28,9 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_listbase.h"
+#include "BLI_memarena.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 
 #include "BLI_math.h"
 #include "BLI_rand.h"
@@ -63,6 +65,19 @@
 
 /* Dupli-Geometry */
 
+/* Minimum amount of duplis generated at once to do it in parallel. */
+#define DUPLI_PARALLEL_THRESHOLD 1024
+
+/**
+ * The result of #object_duplilist. Duplis are allocated in arrays from an arena rather than one
+ * by one, so that iterating over the list mostly goes through contiguous memory.
+ */
+typedef struct DupliList {
+  /** Legacy doubly-linked list, first member since this is what #object_duplilist returns. */
+  ListBase duplis;
+  MemArena *arena;
+} DupliList;
+
 typedef struct DupliContext {
   Depsgraph *depsgraph;
   /** XXX child objects are selected from this group if set, could be nicer. */
@@ -81,7 +96,7 @@ typedef struct DupliContext {
   const struct DupliGenerator *gen;
 
   /** Result containers. */
-  ListBase *duplilist; /* legacy doubly-linked list */
+  DupliList *duplilist;
 } DupliContext;
 
 typedef struct DupliGenerator {
@@ -140,22 +155,38 @@ static void copy_dupli_context(
   r_ctx->gen = get_dupli_generator(r_ctx);
 }
 
-/* generate a dupli instance
- * mat is transform of the object relative to current context (including object obmat)
- */
-static DupliObject *make_dupli(const DupliContext *ctx, Object *ob, float mat[4][4], int index)
+/* Allocate a zero initialized array of dupli instances, not yet added to the result list. */
+static DupliObject *dupli_array_alloc(const DupliContext *ctx, int duplis_num)
 {
-  DupliObject *dob;
-  int i;
+  return BLI_memarena_alloc(ctx->duplilist->arena, sizeof(DupliObject) * (size_t)duplis_num);
+}
 
-  /* add a DupliObject instance to the result container */
-  if (ctx->duplilist) {
-    dob = MEM_callocN(sizeof(DupliObject), "dupli object");
-    BLI_addtail(ctx->duplilist, dob);
+/* Add the dupli instances of an array in order, skipping the unused ones (without object). */
+static void dupli_array_add(const DupliContext *ctx, DupliObject *duplis, int duplis_num)
+{
+  for (int i = 0; i < duplis_num; i++) {
+    if (duplis[i].ob != NULL) {
+      BLI_addtail(&ctx->duplilist->duplis, &duplis[i]);
+    }
   }
-  else {
-    return NULL;
+}
+
+/* Whether instances of ob generate duplis themselves, added right after each instance. */
+static bool has_recursive_duplis(const DupliContext *ctx, Object *ob)
+{
+  if (ctx->level >= MAX_DUPLI_RECUR) {
+    return false;
   }
+  DupliContext rctx = *ctx;
+  rctx.object = ob;
+  return get_dupli_generator(&rctx) != NULL;
+}
+
+/* Initialize a dupli instance, can be called from multiple threads for different duplis. */
+static void dupli_init(
+    const DupliContext *ctx, DupliObject *dob, Object *ob, float mat[4][4], int index)
+{
+  int i;
 
   dob->ob = ob;
   mul_m4_m4m4(dob->mat, (float(*)[4])ctx->space_mat, mat);
@@ -197,6 +228,25 @@ static DupliObject *make_dupli(const DupliContext *ctx, Object *ob, float mat[4]
   if (ctx->object != ob) {
     dob->random_id ^= BLI_hash_int(BLI_hash_string(ctx->object->id.name + 2));
   }
+}
+
+/* generate a dupli instance
+ * mat is transform of the object relative to current context (including object obmat)
+ */
+static DupliObject *make_dupli(const DupliContext *ctx, Object *ob, float mat[4][4], int index)
+{
+  DupliObject *dob;
+
+  /* add a DupliObject instance to the result container */
+  if (ctx->duplilist) {
+    dob = dupli_array_alloc(ctx, 1);
+    BLI_addtail(&ctx->duplilist->duplis, dob);
+  }
+  else {
+    return NULL;
+  }
+
+  dupli_init(ctx, dob, ob, mat, index);
 
   return dob;
 }
@@ -358,14 +408,12 @@ static void get_duplivert_transform(const float co[3],
   loc_quat_size_to_mat4(mat, co, quat, size);
 }
 
-static void vertex_dupli(const VertexDupliData *vdd,
-                         int index,
-                         const float co[3],
-                         const short no[3])
+static void vertex_dupli_transform(const VertexDupliData *vdd,
+                                   const float co[3],
+                                   const short no[3],
+                                   float obmat[4][4])
 {
   Object *inst_ob = vdd->inst_ob;
-  DupliObject *dob;
-  float obmat[4][4], space_mat[4][4];
 
   /* obmat is transform to vertex */
   get_duplivert_transform(co, no, vdd->use_rotation, inst_ob->trackflag, inst_ob->upflag, obmat);
@@ -373,6 +421,18 @@ static void vertex_dupli(const VertexDupliData *vdd,
   mul_mat3_m4_v3((float(*)[4])vdd->child_imat, obmat[3]);
   /* apply obmat _after_ the local vertex transform */
   mul_m4_m4m4(obmat, inst_ob->obmat, obmat);
+}
+
+static void vertex_dupli(const VertexDupliData *vdd,
+                         int index,
+                         const float co[3],
+                         const short no[3])
+{
+  Object *inst_ob = vdd->inst_ob;
+  DupliObject *dob;
+  float obmat[4][4], space_mat[4][4];
+
+  vertex_dupli_transform(vdd, co, no, obmat);
 
   /* space matrix is constructed by removing obmat transform,
    * this yields the worldspace transform for recursive duplis
@@ -389,6 +449,29 @@ static void vertex_dupli(const VertexDupliData *vdd,
   make_recursive_duplis(vdd->ctx, vdd->inst_ob, space_mat, index);
 }
 
+typedef struct VertexDupliParallelData {
+  const VertexDupliData *vdd;
+  const MVert *mvert;
+  DupliObject *duplis;
+} VertexDupliParallelData;
+
+static void vertex_dupli_parallel_cb(void *__restrict userdata,
+                                     const int index,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const VertexDupliParallelData *data = userdata;
+  const VertexDupliData *vdd = data->vdd;
+  DupliObject *dob = &data->duplis[index];
+  float obmat[4][4];
+
+  vertex_dupli_transform(vdd, data->mvert[index].co, data->mvert[index].no, obmat);
+  dupli_init(vdd->ctx, dob, vdd->inst_ob, obmat, index);
+
+  if (vdd->orco) {
+    copy_v3_v3(dob->orco, vdd->orco[index]);
+  }
+}
+
 static void make_child_duplis_verts(const DupliContext *ctx, void *userdata, Object *child)
 {
   VertexDupliData *vdd = userdata;
@@ -400,6 +483,22 @@ static void make_child_duplis_verts(const DupliContext *ctx, void *userdata, Obj
   mul_m4_m4m4(vdd->child_imat, child->imat, ctx->object->obmat);
 
   const MVert *mvert = me_eval->mvert;
+
+  if (me_eval->totvert >= DUPLI_PARALLEL_THRESHOLD && vdd->ctx->duplilist &&
+      !has_recursive_duplis(vdd->ctx, child)) {
+    /* Each vertex adds a single dupli, compute them in parallel and add them in order. */
+    VertexDupliParallelData data = {
+        .vdd = vdd,
+        .mvert = mvert,
+        .duplis = dupli_array_alloc(vdd->ctx, me_eval->totvert),
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    BLI_task_parallel_range(0, me_eval->totvert, &data, vertex_dupli_parallel_cb, &settings);
+    dupli_array_add(vdd->ctx, data.duplis, me_eval->totvert);
+    return;
+  }
+
   for (int i = 0; i < me_eval->totvert; i++) {
     vertex_dupli(vdd, i, mvert[i].co, mvert[i].no);
   }
@@ -615,14 +714,84 @@ static void get_dupliface_transform(
   loc_quat_size_to_mat4(mat, loc, quat, size);
 }
 
+static void face_dupli_transform(const DupliContext *ctx,
+                                 const FaceDupliData *fdd,
+                                 Object *inst_ob,
+                                 const float child_imat[4][4],
+                                 MPoly *mp,
+                                 float obmat[4][4])
+{
+  MLoop *loopstart = fdd->mloop + mp->loopstart;
+
+  /* obmat is transform to face */
+  get_dupliface_transform(
+      mp, loopstart, fdd->mvert, fdd->use_scale, ctx->object->instance_faces_scale, obmat);
+  /* make offset relative to inst_ob using relative child transform */
+  mul_mat3_m4_v3(child_imat, obmat[3]);
+
+  /* XXX ugly hack to ensure same behavior as in master
+   * this should not be needed, parentinv is not consistent
+   * outside of parenting.
+   */
+  {
+    float imat[3][3];
+    copy_m3_m4(imat, inst_ob->parentinv);
+    mul_m4_m3m4(obmat, imat, obmat);
+  }
+
+  /* apply obmat _after_ the local face transform */
+  mul_m4_m4m4(obmat, inst_ob->obmat, obmat);
+}
+
+static void face_dupli_texture(const FaceDupliData *fdd, const MPoly *mp, DupliObject *dob)
+{
+  const MLoop *loopstart = fdd->mloop + mp->loopstart;
+  const float w = 1.0f / (float)mp->totloop;
+
+  if (fdd->orco) {
+    for (int j = 0; j < mp->totloop; j++) {
+      madd_v3_v3fl(dob->orco, fdd->orco[loopstart[j].v], w);
+    }
+  }
+  if (fdd->mloopuv) {
+    for (int j = 0; j < mp->totloop; j++) {
+      madd_v2_v2fl(dob->uv, fdd->mloopuv[mp->loopstart + j].uv, w);
+    }
+  }
+}
+
+typedef struct FaceDupliParallelData {
+  const DupliContext *ctx;
+  const FaceDupliData *fdd;
+  Object *inst_ob;
+  float child_imat[4][4];
+  DupliObject *duplis;
+} FaceDupliParallelData;
+
+static void face_dupli_parallel_cb(void *__restrict userdata,
+                                   const int index,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FaceDupliParallelData *data = userdata;
+  const FaceDupliData *fdd = data->fdd;
+  MPoly *mp = &fdd->mpoly[index];
+  DupliObject *dob = &data->duplis[index];
+  float obmat[4][4];
+
+  /* Unused duplis keep a NULL object and are not added to the list. */
+  if (UNLIKELY(mp->totloop < 3)) {
+    return;
+  }
+
+  face_dupli_transform(data->ctx, fdd, data->inst_ob, data->child_imat, mp, obmat);
+  dupli_init(data->ctx, dob, data->inst_ob, obmat, index);
+  face_dupli_texture(fdd, mp, dob);
+}
+
 static void make_child_duplis_faces(const DupliContext *ctx, void *userdata, Object *inst_ob)
 {
   FaceDupliData *fdd = userdata;
   MPoly *mpoly = fdd->mpoly, *mp;
-  MLoop *mloop = fdd->mloop;
-  MVert *mvert = fdd->mvert;
-  float(*orco)[3] = fdd->orco;
-  MLoopUV *mloopuv = fdd->mloopuv;
   int a, totface = fdd->totface;
   float child_imat[4][4];
   DupliObject *dob;
@@ -631,32 +800,31 @@ static void make_child_duplis_faces(const DupliContext *ctx, void *userdata, Obj
   /* relative transform from parent to child space */
   mul_m4_m4m4(child_imat, inst_ob->imat, ctx->object->obmat);
 
+  if (totface >= DUPLI_PARALLEL_THRESHOLD && ctx->duplilist &&
+      !has_recursive_duplis(ctx, inst_ob)) {
+    /* Each face adds at most one dupli, compute them in parallel and add them in order. */
+    FaceDupliParallelData data = {
+        .ctx = ctx,
+        .fdd = fdd,
+        .inst_ob = inst_ob,
+        .duplis = dupli_array_alloc(ctx, totface),
+    };
+    copy_m4_m4(data.child_imat, child_imat);
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    BLI_task_parallel_range(0, totface, &data, face_dupli_parallel_cb, &settings);
+    dupli_array_add(ctx, data.duplis, totface);
+    return;
+  }
+
   for (a = 0, mp = mpoly; a < totface; a++, mp++) {
-    MLoop *loopstart = mloop + mp->loopstart;
     float space_mat[4][4], obmat[4][4];
 
     if (UNLIKELY(mp->totloop < 3)) {
       continue;
     }
 
-    /* obmat is transform to face */
-    get_dupliface_transform(
-        mp, loopstart, mvert, fdd->use_scale, ctx->object->instance_faces_scale, obmat);
-    /* make offset relative to inst_ob using relative child transform */
-    mul_mat3_m4_v3(child_imat, obmat[3]);
-
-    /* XXX ugly hack to ensure same behavior as in master
-     * this should not be needed, parentinv is not consistent
-     * outside of parenting.
-     */
-    {
-      float imat[3][3];
-      copy_m3_m4(imat, inst_ob->parentinv);
-      mul_m4_m3m4(obmat, imat, obmat);
-    }
-
-    /* apply obmat _after_ the local face transform */
-    mul_m4_m4m4(obmat, inst_ob->obmat, obmat);
+    face_dupli_transform(ctx, fdd, inst_ob, child_imat, mp, obmat);
 
     /* space matrix is constructed by removing obmat transform,
      * this yields the worldspace transform for recursive duplis
@@ -664,18 +832,7 @@ static void make_child_duplis_faces(const DupliContext *ctx, void *userdata, Obj
     mul_m4_m4m4(space_mat, obmat, inst_ob->imat);
 
     dob = make_dupli(ctx, inst_ob, obmat, a);
-
-    const float w = 1.0f / (float)mp->totloop;
-    if (orco) {
-      for (int j = 0; j < mp->totloop; j++) {
-        madd_v3_v3fl(dob->orco, orco[loopstart[j].v], w);
-      }
-    }
-    if (mloopuv) {
-      for (int j = 0; j < mp->totloop; j++) {
-        madd_v2_v2fl(dob->uv, mloopuv[mp->loopstart + j].uv, w);
-      }
-    }
+    face_dupli_texture(fdd, mp, dob);
 
     /* recursion */
     make_recursive_duplis(ctx, inst_ob, space_mat, a);
@@ -1120,22 +1277,27 @@ static const DupliGenerator *get_dupli_generator(const DupliContext *ctx)
 
 /* ---- ListBase dupli container implementation ---- */
 
-/* Returns a list of DupliObject */
+/* Returns a list of DupliObject, to be freed with #free_object_duplilist. */
 ListBase *object_duplilist(Depsgraph *depsgraph, Scene *sce, Object *ob)
 {
-  ListBase *duplilist = MEM_callocN(sizeof(ListBase), "duplilist");
+  DupliList *duplilist = MEM_callocN(sizeof(DupliList), "duplilist");
   DupliContext ctx;
   init_context(&ctx, depsgraph, sce, ob, NULL);
   if (ctx.gen) {
+    duplilist->arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+    BLI_memarena_use_calloc(duplilist->arena);
     ctx.duplilist = duplilist;
     ctx.gen->make_duplis(&ctx);
   }
 
-  return duplilist;
+  return &duplilist->duplis;
 }
 
 void free_object_duplilist(ListBase *lb)
 {
-  BLI_freelistN(lb);
-  MEM_freeN(lb);
+  DupliList *duplilist = (DupliList *)lb;
+  if (duplilist->arena) {
+    BLI_memarena_free(duplilist->arena);
+  }
+  MEM_freeN(duplilist);
 }
@@ -199,7 +199,8 @@ float BKE_ocean_jminus_to_foam(float jminus, float coverage)
   return foam;
 }
 
-void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float v)
+/* Bilinear sampling of the simulation grids, the caller holds the read lock. */
+BLI_INLINE void ocean_eval_uv_nolock(struct Ocean *oc, struct OceanResult *ocr, float u, float v)
 {
   int i0, i1, j0, j1;
   float frac_x, frac_z;
@@ -216,8 +217,6 @@ void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float
     v += 1.0f;
   }
 
-  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
-
   uu = u * oc->_M;
   vv = v * oc->_N;
 
@@ -236,10 +235,13 @@ void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float
   i1 = i1 % oc->_M;
   j1 = j1 % oc->_N;
 
-#  define BILERP(m) \
-    (interpf(interpf(m[i1 * oc->_N + j1], m[i0 * oc->_N + j1], frac_x), \
-             interpf(m[i1 * oc->_N + j0], m[i0 * oc->_N + j0], frac_x), \
-             frac_z))
+  /* Offsets and weights of the four samples are shared by all the grids. */
+  const int i00 = i0 * oc->_N + j0, i10 = i1 * oc->_N + j0;
+  const int i01 = i0 * oc->_N + j1, i11 = i1 * oc->_N + j1;
+  const float w00 = (1.0f - frac_x) * (1.0f - frac_z), w10 = frac_x * (1.0f - frac_z);
+  const float w01 = (1.0f - frac_x) * frac_z, w11 = frac_x * frac_z;
+
+#  define BILERP(m) ((float)(m[i00] * w00 + m[i10] * w10 + m[i01] * w01 + m[i11] * w11))
 
   {
     if (oc->_do_disp_y) {
@@ -266,7 +268,29 @@ void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float
     }
   }
 #  undef BILERP
+}
 
+void BKE_ocean_eval_uv(struct Ocean *oc, struct OceanResult *ocr, float u, float v)
+{
+  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+  ocean_eval_uv_nolock(oc, ocr, u, v);
+  BLI_rw_mutex_unlock(&oc->oceanmutex);
+}
+
+/**
+ * Sample the ocean at many coordinates at once, \a r_ocr is an array of \a uv_len results.
+ * Much cheaper than calling #BKE_ocean_eval_uv for each point, since the lock is only taken
+ * once and the loop over the grids stays hot in the cache.
+ */
+void BKE_ocean_eval_uv_array(struct Ocean *oc,
+                             struct OceanResult *r_ocr,
+                             const float (*uv)[2],
+                             const int uv_len)
+{
+  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+  for (int i = 0; i < uv_len; i++) {
+    ocean_eval_uv_nolock(oc, &r_ocr[i], uv[i][0], uv[i][1]);
+  }
   BLI_rw_mutex_unlock(&oc->oceanmutex);
 }
 
@@ -380,10 +404,8 @@ void BKE_ocean_eval_xz_catrom(struct Ocean *oc, struct OceanResult *ocr, float x
 
 /* note that this doesn't wrap properly for i, j < 0, but its not really meant for that being
  * just a way to get the raw data out to save in some image format. */
-void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+BLI_INLINE void ocean_eval_ij_nolock(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
 {
-  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
-
   i = abs(i) % oc->_M;
   j = abs(j) % oc->_N;
 
@@ -410,7 +432,12 @@ void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
     compute_eigenstuff(
         ocr, oc->_Jxx[i * oc->_N + j], oc->_Jzz[i * oc->_N + j], oc->_Jxz[i * oc->_N + j]);
   }
+}
 
+void BKE_ocean_eval_ij(struct Ocean *oc, struct OceanResult *ocr, int i, int j)
+{
+  BLI_rw_mutex_lock(&oc->oceanmutex, THREAD_LOCK_READ);
+  ocean_eval_ij_nolock(oc, ocr, i, j);
   BLI_rw_mutex_unlock(&oc->oceanmutex);
 }
 
@@ -1232,6 +1259,20 @@ void BKE_ocean_cache_eval_uv(
   }
 }
 
+/**
+ * Sample the baked frame \a f at many coordinates at once, see #BKE_ocean_eval_uv_array.
+ */
+void BKE_ocean_cache_eval_uv_array(struct OceanCache *och,
+                                   struct OceanResult *r_ocr,
+                                   int f,
+                                   const float (*uv)[2],
+                                   const int uv_len)
+{
+  for (int i = 0; i < uv_len; i++) {
+    BKE_ocean_cache_eval_uv(och, &r_ocr[i], f, uv[i][0], uv[i][1]);
+  }
+}
+
 void BKE_ocean_cache_eval_ij(struct OceanCache *och, struct OceanResult *ocr, int f, int i, int j)
 {
   const int res_x = och->resolution_x;
@@ -1323,19 +1364,94 @@ void BKE_ocean_simulate_cache(struct OceanCache *och, int frame)
   och->ibufs_norm[f] = IMB_loadiffname(string, 0, NULL);
 }
 
-void BKE_ocean_bake(struct Ocean *o,
-                    struct OceanCache *och,
-                    void (*update_cb)(void *, float progress, int *cancel),
-                    void *update_cb_data)
-{
+typedef struct OceanBakeData {
+  struct Ocean *o;
+  struct OceanCache *och;
+  ImBuf *ibuf_foam, *ibuf_disp, *ibuf_normal;
+  float *prev_foam;
+  int frame_index;
+} OceanBakeData;
+
+/* Rows are independent, including the foam accumulated from the previous frame. */
+static void ocean_bake_row(void *__restrict userdata,
+                           const int y,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  OceanBakeData *data = userdata;
+  struct Ocean *o = data->o;
+  struct OceanCache *och = data->och;
+  float *prev_foam = data->prev_foam;
+  const int res_x = och->resolution_x;
+
   /* note: some of these values remain uninitialized unless certain options
    * are enabled, take care that BKE_ocean_eval_ij() initializes a member
    * before use - campbell */
   OceanResult ocr;
 
+  for (int x = 0; x < res_x; x++) {
+    ocean_eval_ij_nolock(o, &ocr, x, y);
+
+    /* add to the image */
+    rgb_to_rgba_unit_alpha(&data->ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
+
+    if (o->_do_jacobian) {
+      /* TODO, cleanup unused code - campbell */
+
+      float /*r, */ /* UNUSED */ pr = 0.0f, foam_result;
+      float neg_disp, neg_eplus;
+
+      ocr.foam = BKE_ocean_jminus_to_foam(ocr.Jminus, och->foam_coverage);
+
+      /* accumulate previous value for this cell */
+      if (data->frame_index > 0) {
+        pr = prev_foam[res_x * y + x];
+      }
+
+      /* r = BLI_rng_get_float(rng); */ /* UNUSED */ /* randomly reduce foam */
+
+      /* pr = pr * och->foam_fade; */ /* overall fade */
+
+      /* Remember ocean coord sys is Y up!
+       * break up the foam where height (Y) is low (wave valley),
+       * and X and Z displacement is greatest. */
+
+      neg_disp = ocr.disp[1] < 0.0f ? 1.0f + ocr.disp[1] : 1.0f;
+      neg_disp = neg_disp < 0.0f ? 0.0f : neg_disp;
+
+      /* foam, 'ocr.Eplus' only initialized with do_jacobian */
+      neg_eplus = ocr.Eplus[2] < 0.0f ? 1.0f + ocr.Eplus[2] : 1.0f;
+      neg_eplus = neg_eplus < 0.0f ? 0.0f : neg_eplus;
+
+      if (pr < 1.0f) {
+        pr *= pr;
+      }
+
+      pr *= och->foam_fade * (0.75f + neg_eplus * 0.25f);
+
+      /* A full clamping should not be needed! */
+      foam_result = min_ff(pr + ocr.foam, 1.0f);
+
+      prev_foam[res_x * y + x] = foam_result;
+
+      /*foam_result = min_ff(foam_result, 1.0f); */
+
+      value_to_rgba_unit_alpha(&data->ibuf_foam->rect_float[4 * (res_x * y + x)], foam_result);
+    }
+
+    if (o->_do_normals) {
+      rgb_to_rgba_unit_alpha(&data->ibuf_normal->rect_float[4 * (res_x * y + x)], ocr.normal);
+    }
+  }
+}
+
+void BKE_ocean_bake(struct Ocean *o,
+                    struct OceanCache *och,
+                    void (*update_cb)(void *, float progress, int *cancel),
+                    void *update_cb_data)
+{
   ImageFormatData imf = {0};
 
-  int f, i = 0, x, y, cancel = 0;
+  int f, i = 0, cancel = 0;
   float progress;
 
   ImBuf *ibuf_foam, *ibuf_disp, *ibuf_normal;
@@ -1358,6 +1474,16 @@ void BKE_ocean_bake(struct Ocean *o,
 
   // rng = BLI_rng_new(0);
 
+  OceanBakeData data = {
+      .o = o,
+      .och = och,
+      .prev_foam = prev_foam,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (res_y > 16);
+
   /* setup image format */
   imf.imtype = R_IMF_IMTYPE_OPENEXR;
   imf.depth = R_IMF_CHAN_DEPTH_16;
@@ -1373,63 +1499,14 @@ void BKE_ocean_bake(struct Ocean *o,
     BKE_ocean_simulate(o, och->time[i], och->wave_scale, och->chop_amount);
 
     /* add new foam */
-    for (y = 0; y < res_y; y++) {
-      for (x = 0; x < res_x; x++) {
-
-        BKE_ocean_eval_ij(o, &ocr, x, y);
+    data.ibuf_foam = ibuf_foam;
+    data.ibuf_disp = ibuf_disp;
+    data.ibuf_normal = ibuf_normal;
+    data.frame_index = i;
 
-        /* add to the image */
-        rgb_to_rgba_unit_alpha(&ibuf_disp->rect_float[4 * (res_x * y + x)], ocr.disp);
-
-        if (o->_do_jacobian) {
-          /* TODO, cleanup unused code - campbell */
-
-          float /*r, */ /* UNUSED */ pr = 0.0f, foam_result;
-          float neg_disp, neg_eplus;
-
-          ocr.foam = BKE_ocean_jminus_to_foam(ocr.Jminus, och->foam_coverage);
-
-          /* accumulate previous value for this cell */
-          if (i > 0) {
-            pr = prev_foam[res_x * y + x];
-          }
-
-          /* r = BLI_rng_get_float(rng); */ /* UNUSED */ /* randomly reduce foam */
-
-          /* pr = pr * och->foam_fade; */ /* overall fade */
-
-          /* Remember ocean coord sys is Y up!
-           * break up the foam where height (Y) is low (wave valley),
-           * and X and Z displacement is greatest. */
-
-          neg_disp = ocr.disp[1] < 0.0f ? 1.0f + ocr.disp[1] : 1.0f;
-          neg_disp = neg_disp < 0.0f ? 0.0f : neg_disp;
-
-          /* foam, 'ocr.Eplus' only initialized with do_jacobian */
-          neg_eplus = ocr.Eplus[2] < 0.0f ? 1.0f + ocr.Eplus[2] : 1.0f;
-          neg_eplus = neg_eplus < 0.0f ? 0.0f : neg_eplus;
-
-          if (pr < 1.0f) {
-            pr *= pr;
-          }
-
-          pr *= och->foam_fade * (0.75f + neg_eplus * 0.25f);
-
-          /* A full clamping should not be needed! */
-          foam_result = min_ff(pr + ocr.foam, 1.0f);
-
-          prev_foam[res_x * y + x] = foam_result;
-
-          /*foam_result = min_ff(foam_result, 1.0f); */
-
-          value_to_rgba_unit_alpha(&ibuf_foam->rect_float[4 * (res_x * y + x)], foam_result);
-        }
-
-        if (o->_do_normals) {
-          rgb_to_rgba_unit_alpha(&ibuf_normal->rect_float[4 * (res_x * y + x)], ocr.normal);
-        }
-      }
-    }
+    BLI_rw_mutex_lock(&o->oceanmutex, THREAD_LOCK_READ);
+    BLI_task_parallel_range(0, res_y, &data, ocean_bake_row, &settings);
+    BLI_rw_mutex_unlock(&o->oceanmutex);
 
     /* write the images */
     cache_filename(string, och->bakepath, och->relbase, f, CACHE_TYPE_DISPLACE);
@@ -1489,6 +1566,14 @@ void BKE_ocean_eval_uv(struct Ocean *UNUSED(oc),
 {
 }
 
+void BKE_ocean_eval_uv_array(struct Ocean *UNUSED(oc),
+                             struct OceanResult *UNUSED(r_ocr),
+                             const float (*uv)[2],
+                             const int UNUSED(uv_len))
+{
+  UNUSED_VARS(uv);
+}
+
 /* use catmullrom interpolation rather than linear */
 void BKE_ocean_eval_uv_catrom(struct Ocean *UNUSED(oc),
                               struct OceanResult *UNUSED(ocr),
@@ -1587,6 +1672,15 @@ void BKE_ocean_cache_eval_uv(struct OceanCache *UNUSED(och),
 {
 }
 
+void BKE_ocean_cache_eval_uv_array(struct OceanCache *UNUSED(och),
+                                   struct OceanResult *UNUSED(r_ocr),
+                                   int UNUSED(f),
+                                   const float (*uv)[2],
+                                   const int UNUSED(uv_len))
+{
+  UNUSED_VARS(uv);
+}
+
 void BKE_ocean_cache_eval_ij(struct OceanCache *UNUSED(och),
                              struct OceanResult *UNUSED(ocr),
                              int UNUSED(f),
@@ -699,6 +699,9 @@ static void distribute_children_exec(ParticleTask *thread, ChildParticle *cpa, i
     cpa->num = 0;
     cpa->fuv[0] = cpa->fuv[1] = cpa->fuv[2] = cpa->fuv[3] = 0.0f;
     cpa->pa[0] = cpa->pa[1] = cpa->pa[2] = cpa->pa[3] = 0;
+    /* Still use the random values of this element, the next one may be distributed by the same
+     * task without moving the generator. */
+    BLI_rng_skip(thread->rng, rng_skip_tot);
     return;
   }
 
@@ -773,54 +776,73 @@ static void distribute_children_exec(ParticleTask *thread, ChildParticle *cpa, i
   }
 }
 
-static void exec_distribute_parent(TaskPool *__restrict UNUSED(pool),
-                                   void *taskdata,
-                                   int UNUSED(threadid))
+/* Per thread data of the distribution. */
+typedef struct DistributeThreadData {
+  ParticleTask task;
+  unsigned int seed;
+  /* Element the random number generator of the task is at. */
+  int rng_index;
+} DistributeThreadData;
+
+/**
+ * Each element uses #PSYS_RND_DIST_SKIP random values, so the generator is moved to the element
+ * before it is distributed, which gives the same values whichever thread handles it.
+ */
+static ParticleTask *distribute_thread_task_get(DistributeThreadData *data, const int p)
 {
-  ParticleTask *task = taskdata;
-  ParticleSystem *psys = task->ctx->sim.psys;
-  ParticleData *pa;
-  int p;
+  ParticleTask *task = &data->task;
 
-  BLI_rng_skip(task->rng, PSYS_RND_DIST_SKIP * task->begin);
+  if (task->rng == NULL) {
+    task->rng = BLI_rng_new(data->seed);
+    data->rng_index = 0;
+  }
+  if (data->rng_index != p) {
+    BLI_rng_seed(task->rng, data->seed);
+    BLI_rng_skip(task->rng, PSYS_RND_DIST_SKIP * p);
+  }
+  data->rng_index = p + 1;
+
+  return task;
+}
+
+static void exec_distribute_parent(void *__restrict userdata,
+                                   const int p,
+                                   const TaskParallelTLS *__restrict tls)
+{
+  ParticleThreadContext *ctx = userdata;
+  ParticleSystem *psys = ctx->sim.psys;
+  ParticleTask *task = distribute_thread_task_get(tls->userdata_chunk, p);
+  ParticleData *pa = psys->particles + p;
 
-  pa = psys->particles + task->begin;
   switch (psys->part->from) {
     case PART_FROM_FACE:
-      for (p = task->begin; p < task->end; p++, pa++) {
-        distribute_from_faces_exec(task, pa, p);
-      }
+      distribute_from_faces_exec(task, pa, p);
       break;
     case PART_FROM_VOLUME:
-      for (p = task->begin; p < task->end; p++, pa++) {
-        distribute_from_volume_exec(task, pa, p);
-      }
+      distribute_from_volume_exec(task, pa, p);
       break;
     case PART_FROM_VERT:
-      for (p = task->begin; p < task->end; p++, pa++) {
-        distribute_from_verts_exec(task, pa, p);
-      }
+      distribute_from_verts_exec(task, pa, p);
       break;
   }
 }
 
-static void exec_distribute_child(TaskPool *__restrict UNUSED(pool),
-                                  void *taskdata,
-                                  int UNUSED(threadid))
+static void exec_distribute_child(void *__restrict userdata,
+                                  const int p,
+                                  const TaskParallelTLS *__restrict tls)
 {
-  ParticleTask *task = taskdata;
-  ParticleSystem *psys = task->ctx->sim.psys;
-  ChildParticle *cpa;
-  int p;
+  ParticleThreadContext *ctx = userdata;
+  ParticleTask *task = distribute_thread_task_get(tls->userdata_chunk, p);
 
-  /* RNG skipping at the beginning */
-  cpa = psys->child;
-  for (p = 0; p < task->begin; p++, cpa++) {
-    BLI_rng_skip(task->rng, PSYS_RND_DIST_SKIP);
-  }
+  distribute_children_exec(task, ctx->sim.psys->child + p, p);
+}
 
-  for (; p < task->end; p++, cpa++) {
-    distribute_children_exec(task, cpa, p);
+static void exec_distribute_free(const void *__restrict UNUSED(userdata),
+                                 void *__restrict chunk)
+{
+  DistributeThreadData *data = chunk;
+  if (data->task.rng) {
+    BLI_rng_free(data->task.rng);
   }
 }
 
@@ -1314,47 +1336,36 @@ static int psys_thread_context_init_distribute(ParticleThreadContext *ctx,
   return 1;
 }
 
-static void psys_task_init_distribute(ParticleTask *task, ParticleSimulationData *sim)
-{
-  /* init random number generator */
-  int seed = 31415926 + sim->psys->seed;
-
-  task->rng = BLI_rng_new(seed);
-}
-
 static void distribute_particles_on_dm(ParticleSimulationData *sim, int from)
 {
-  TaskScheduler *task_scheduler;
-  TaskPool *task_pool;
   ParticleThreadContext ctx;
-  ParticleTask *tasks;
   Mesh *final_mesh = sim->psmd->mesh_final;
-  int i, totpart, numtasks;
+  int totpart;
 
-  /* create a task pool for distribution tasks */
   if (!psys_thread_context_init_distribute(&ctx, sim, from)) {
     return;
   }
 
-  task_scheduler = BLI_task_scheduler_get();
-  task_pool = BLI_task_pool_create(task_scheduler, &ctx, TASK_PRIORITY_LOW);
-
   totpart = (from == PART_FROM_CHILD ? sim->psys->totchild : sim->psys->totpart);
-  psys_tasks_create(&ctx, 0, totpart, &tasks, &numtasks);
-  for (i = 0; i < numtasks; i++) {
-    ParticleTask *task = &tasks[i];
 
-    psys_task_init_distribute(task, sim);
-    if (from == PART_FROM_CHILD) {
-      BLI_task_pool_push(task_pool, exec_distribute_child, task, false, NULL);
-    }
-    else {
-      BLI_task_pool_push(task_pool, exec_distribute_parent, task, false, NULL);
-    }
-  }
-  BLI_task_pool_work_and_wait(task_pool);
-
-  BLI_task_pool_free(task_pool);
+  /* Elements are distributed in parallel, with a random number generator per thread. */
+  DistributeThreadData thread_data = {
+      .task = {.ctx = &ctx},
+      .seed = 31415926 + sim->psys->seed,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  settings.userdata_chunk = &thread_data;
+  settings.userdata_chunk_size = sizeof(thread_data);
+  settings.func_free = exec_distribute_free;
+  BLI_task_parallel_range(0,
+                          totpart,
+                          &ctx,
+                          (from == PART_FROM_CHILD) ? exec_distribute_child :
+                                                      exec_distribute_parent,
+                          &settings);
 
   psys_calc_dmcache(sim->ob, final_mesh, sim->psmd->mesh_original, sim->psys);
 
@@ -1362,8 +1373,6 @@ static void distribute_particles_on_dm(ParticleSimulationData *sim, int from)
     BKE_id_free(NULL, ctx.mesh);
   }
 
-  psys_tasks_free(tasks, numtasks);
-
   psys_thread_context_free(&ctx);
 }
 
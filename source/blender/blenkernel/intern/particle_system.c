@@ -468,48 +468,6 @@ void psys_thread_context_init(ParticleThreadContext *ctx, ParticleSimulationData
   ctx->ma = BKE_object_material_get(sim->ob, sim->psys->part->omat);
 }
 
-void psys_tasks_create(ParticleThreadContext *ctx,
-                       int startpart,
-                       int endpart,
-                       ParticleTask **r_tasks,
-                       int *r_numtasks)
-{
-  ParticleTask *tasks;
-  int numtasks = min_ii(BLI_system_thread_count() * 4, endpart - startpart);
-  float particles_per_task = (float)(endpart - startpart) / (float)numtasks, p, pnext;
-  int i;
-
-  tasks = MEM_callocN(sizeof(ParticleTask) * numtasks, "ParticleThread");
-  *r_numtasks = numtasks;
-  *r_tasks = tasks;
-
-  p = (float)startpart;
-  for (i = 0; i < numtasks; i++, p = pnext) {
-    pnext = p + particles_per_task;
-
-    tasks[i].ctx = ctx;
-    tasks[i].begin = (int)p;
-    tasks[i].end = min_ii((int)pnext, endpart);
-  }
-}
-
-void psys_tasks_free(ParticleTask *tasks, int numtasks)
-{
-  int i;
-
-  /* threads */
-  for (i = 0; i < numtasks; i++) {
-    if (tasks[i].rng) {
-      BLI_rng_free(tasks[i].rng);
-    }
-    if (tasks[i].rng_path) {
-      BLI_rng_free(tasks[i].rng_path);
-    }
-  }
-
-  MEM_freeN(tasks);
-}
-
 void psys_thread_context_free(ParticleThreadContext *ctx)
 {
   /* path caching */
@@ -45,6 +45,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -139,8 +140,32 @@ static int ptcache_extra_datasize[] = {
     sizeof(ParticleSpring),
 };
 
+/* A compressed block read from a cache file, decompressing it can be deferred so the
+ * blocks of multiple channels are decompressed in parallel. */
+typedef struct PTCacheCompressedBlock {
+  unsigned char *result;
+  unsigned int len;
+  unsigned char compressed;
+  unsigned char *in;
+  size_t in_len;
+  unsigned char props[16];
+  size_t props_len;
+} PTCacheCompressedBlock;
+
+#define PTCACHE_COMPRESSED_BLOCKS_MAX 32
+
+typedef struct PTCacheCompressedRead {
+  PTCacheCompressedBlock blocks[PTCACHE_COMPRESSED_BLOCKS_MAX];
+  int blocks_num;
+} PTCacheCompressedRead;
+
 /* forward declarations */
 static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len);
+static void ptcache_file_compressed_read_deferred(PTCacheFile *pf,
+                                                  PTCacheCompressedRead *cr,
+                                                  unsigned char *result,
+                                                  unsigned int len);
+static void ptcache_file_compressed_read_finish(PTCacheCompressedRead *cr);
 static int ptcache_file_compressed_write(
     PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode);
 static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot, unsigned int size);
@@ -2205,55 +2230,128 @@ static void ptcache_file_close(PTCacheFile *pf)
   }
 }
 
-static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
+/* Read a compressed block from the file, uncompressed data is read into the result directly. */
+static void ptcache_file_compressed_block_read(PTCacheFile *pf,
+                                               PTCacheCompressedBlock *block,
+                                               unsigned char *result,
+                                               unsigned int len)
 {
-  int r = 0;
-  unsigned char compressed = 0;
-  size_t in_len;
-#ifdef WITH_LZO
-  size_t out_len = len;
-#endif
-  unsigned char *in;
-  unsigned char *props = MEM_callocN(16 * sizeof(char), "tmp");
+  memset(block, 0, sizeof(*block));
+  block->result = result;
+  block->len = len;
 
-  ptcache_file_read(pf, &compressed, 1, sizeof(unsigned char));
-  if (compressed) {
+  ptcache_file_read(pf, &block->compressed, 1, sizeof(unsigned char));
+  if (block->compressed) {
     unsigned int size;
     ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
-    in_len = (size_t)size;
-    if (in_len == 0) {
+    block->in_len = (size_t)size;
+    if (block->in_len == 0) {
       /* do nothing */
     }
     else {
-      in = (unsigned char *)MEM_callocN(sizeof(unsigned char) * in_len,
-                                        "pointcache_compressed_buffer");
-      ptcache_file_read(pf, in, in_len, sizeof(unsigned char));
-#ifdef WITH_LZO
-      if (compressed == 1) {
-        r = lzo1x_decompress_safe(in, (lzo_uint)in_len, result, (lzo_uint *)&out_len, NULL);
-      }
-#endif
+      block->in = (unsigned char *)MEM_callocN(sizeof(unsigned char) * block->in_len,
+                                               "pointcache_compressed_buffer");
+      ptcache_file_read(pf, block->in, block->in_len, sizeof(unsigned char));
 #ifdef WITH_LZMA
-      if (compressed == 2) {
-        size_t sizeOfIt;
-        size_t leni = in_len, leno = len;
+      if (block->compressed == 2) {
         ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
-        sizeOfIt = (size_t)size;
-        ptcache_file_read(pf, props, sizeOfIt, sizeof(unsigned char));
-        r = LzmaUncompress(result, &leno, in, &leni, props, sizeOfIt);
+        if ((size_t)size > sizeof(block->props)) {
+          /* Not written by Blender, skip the properties and don't decompress the block. */
+          fseek(pf->fp, (long)size, SEEK_CUR);
+          MEM_freeN(block->in);
+          block->in = NULL;
+        }
+        else {
+          block->props_len = (size_t)size;
+          ptcache_file_read(pf, block->props, block->props_len, sizeof(unsigned char));
+        }
       }
 #endif
-      MEM_freeN(in);
     }
   }
   else {
     ptcache_file_read(pf, result, len, sizeof(unsigned char));
   }
+}
 
-  MEM_freeN(props);
+static int ptcache_file_compressed_block_decompress(PTCacheCompressedBlock *block)
+{
+  int r = 0;
+
+  if (block->in == NULL) {
+    return r;
+  }
+
+#ifdef WITH_LZO
+  if (block->compressed == 1) {
+    size_t out_len = block->len;
+    r = lzo1x_decompress_safe(
+        block->in, (lzo_uint)block->in_len, block->result, (lzo_uint *)&out_len, NULL);
+  }
+#endif
+#ifdef WITH_LZMA
+  if (block->compressed == 2) {
+    size_t leni = block->in_len, leno = block->len;
+    r = LzmaUncompress(
+        block->result, &leno, block->in, &leni, block->props, block->props_len);
+  }
+#endif
+
+  MEM_freeN(block->in);
+  block->in = NULL;
 
   return r;
 }
+
+static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
+{
+  PTCacheCompressedBlock block;
+  ptcache_file_compressed_block_read(pf, &block, result, len);
+  return ptcache_file_compressed_block_decompress(&block);
+}
+
+/* Like #ptcache_file_compressed_read, the result is only valid after
+ * #ptcache_file_compressed_read_finish. */
+static void ptcache_file_compressed_read_deferred(PTCacheFile *pf,
+                                                  PTCacheCompressedRead *cr,
+                                                  unsigned char *result,
+                                                  unsigned int len)
+{
+  if (cr->blocks_num == PTCACHE_COMPRESSED_BLOCKS_MAX) {
+    ptcache_file_compressed_read_finish(cr);
+  }
+
+  PTCacheCompressedBlock *block = &cr->blocks[cr->blocks_num];
+  ptcache_file_compressed_block_read(pf, block, result, len);
+  if (block->in) {
+    cr->blocks_num++;
+  }
+}
+
+static void ptcache_compressed_block_decompress_cb(void *__restrict userdata,
+                                                   const int i,
+                                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PTCacheCompressedRead *cr = userdata;
+  ptcache_file_compressed_block_decompress(&cr->blocks[i]);
+}
+
+static void ptcache_file_compressed_read_finish(PTCacheCompressedRead *cr)
+{
+  size_t in_len = 0;
+  for (int i = 0; i < cr->blocks_num; i++) {
+    in_len += cr->blocks[i].in_len;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (cr->blocks_num > 1 && in_len > 65536);
+  BLI_task_parallel_range(
+      0, cr->blocks_num, cr, ptcache_compressed_block_decompress_cb, &settings);
+
+  cr->blocks_num = 0;
+}
+
 static int ptcache_file_compressed_write(
     PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode)
 {
@@ -2333,19 +2431,45 @@ static int ptcache_file_write(PTCacheFile *pf, const void *f, unsigned int tot,
 {
   return (fwrite(f, size, tot, pf->fp) == tot);
 }
-static int ptcache_file_data_read(PTCacheFile *pf)
+/* Read the point data of all points at once, the data of each point is interleaved. */
+static int ptcache_file_data_read_all(PTCacheFile *pf, PTCacheMem *pm)
 {
+  size_t point_size = 0;
   int i;
 
   for (i = 0; i < BPHYS_TOT_DATA; i++) {
-    if ((pf->data_types & (1 << i)) &&
-        !ptcache_file_read(pf, pf->cur[i], 1, ptcache_data_size[i])) {
-      return 0;
+    if (pf->data_types & (1 << i)) {
+      point_size += ptcache_data_size[i];
     }
   }
 
+  if (point_size == 0 || pm->totpoint == 0) {
+    return 1;
+  }
+
+  char *buffer = MEM_mallocN(point_size * pm->totpoint, __func__);
+  if (!ptcache_file_read(pf, buffer, pm->totpoint, (unsigned int)point_size)) {
+    MEM_freeN(buffer);
+    return 0;
+  }
+
+  size_t offset = 0;
+  for (i = 0; i < BPHYS_TOT_DATA; i++) {
+    if (pf->data_types & (1 << i)) {
+      const size_t data_size = ptcache_data_size[i];
+      const char *src = buffer + offset;
+      char *dst = pm->data[i];
+      for (unsigned int p = 0; p < pm->totpoint; p++, src += point_size, dst += data_size) {
+        memcpy(dst, src, data_size);
+      }
+      offset += data_size;
+    }
+  }
+
+  MEM_freeN(buffer);
   return 1;
 }
+
 static int ptcache_file_data_write(PTCacheFile *pf)
 {
   int i;
@@ -2653,25 +2777,17 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
     ptcache_data_alloc(pm);
 
     if (pf->flag & PTCACHE_TYPEFLAG_COMPRESS) {
+      PTCacheCompressedRead cr = {.blocks_num = 0};
       for (i = 0; i < BPHYS_TOT_DATA; i++) {
         unsigned int out_len = pm->totpoint * ptcache_data_size[i];
         if (pf->data_types & (1 << i)) {
-          ptcache_file_compressed_read(pf, (unsigned char *)(pm->data[i]), out_len);
+          ptcache_file_compressed_read_deferred(pf, &cr, (unsigned char *)(pm->data[i]), out_len);
         }
       }
+      ptcache_file_compressed_read_finish(&cr);
     }
-    else {
-      BKE_ptcache_mem_pointers_init(pm);
-      ptcache_file_pointers_init(pf);
-
-      for (i = 0; i < pm->totpoint; i++) {
-        if (!ptcache_file_data_read(pf)) {
-          error = 1;
-          break;
-        }
-        ptcache_data_copy(pf->cur, pm->cur);
-        BKE_ptcache_mem_pointers_incr(pm);
-      }
+    else if (!ptcache_file_data_read_all(pf, pm)) {
+      error = 1;
     }
   }
 
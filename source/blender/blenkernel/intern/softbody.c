@@ -46,6 +46,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 /* types */
 #include "DNA_collection_types.h"
 #include "DNA_curve_types.h"
@@ -55,9 +57,13 @@
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
+#include "BLI_buffer.h"
 #include "BLI_ghash.h"
+#include "BLI_kdopbvh.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_sort_utils.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -128,14 +134,15 @@ typedef struct SB_thread_context {
   Object *ob;
   float forcetime;
   float timenow;
-  int ifirst;
-  int ilast;
   ListBase *effectors;
   int do_deflector;
   float fieldfactor;
   float windfactor;
-  int nr;
+
+  /* Items [0, tot) are handed out in chunks from next_index, see #sb_threads_run. */
+  void (*slice_func)(struct SB_thread_context *pctx, int ifirst, int ilast);
   int tot;
+  int next_index;
 } SB_thread_context;
 
 #define MID_PRESERVE 1
@@ -271,11 +278,89 @@ typedef struct ccd_Mesh {
   const MVertTri *tri;
   int safety;
   ccdf_minmax *mima;
+  /* Tree of the mima boxes, so queries only visit faces near to them. */
+  BVHTree *bvhtree;
   /* Axis Aligned Bounding Box AABB */
   float bbmin[3];
   float bbmax[3];
 } ccd_Mesh;
 
+static void ccd_mesh_bvhtree_update(ccd_Mesh *pccd_M)
+{
+  const ccdf_minmax *mima;
+  const bool is_new = (pccd_M->bvhtree == NULL);
+  int i;
+
+  if (is_new) {
+    pccd_M->bvhtree = BLI_bvhtree_new(pccd_M->tri_num, 0.0f, 4, 6);
+  }
+
+  for (i = 0, mima = pccd_M->mima; i < pccd_M->tri_num; i++, mima++) {
+    const float co[2][3] = {{mima->minx, mima->miny, mima->minz},
+                            {mima->maxx, mima->maxy, mima->maxz}};
+    if (is_new) {
+      BLI_bvhtree_insert(pccd_M->bvhtree, i, co[0], 2);
+    }
+    else {
+      BLI_bvhtree_update_node(pccd_M->bvhtree, i, co[0], NULL, 2);
+    }
+  }
+
+  if (is_new) {
+    BLI_bvhtree_balance(pccd_M->bvhtree);
+  }
+  else {
+    BLI_bvhtree_update_tree(pccd_M->bvhtree);
+  }
+}
+
+typedef struct ccd_MeshOverlapData {
+  const ccdf_minmax *mima;
+  const float *aabbmin, *aabbmax;
+  BLI_Buffer *tris;
+} ccd_MeshOverlapData;
+
+static void ccd_mesh_overlap_cb(void *userdata,
+                                int index,
+                                const float UNUSED(co[3]),
+                                float UNUSED(dist_sq))
+{
+  ccd_MeshOverlapData *data = userdata;
+  const ccdf_minmax *mima = &data->mima[index];
+  const float *aabbmin = data->aabbmin, *aabbmax = data->aabbmax;
+
+  if ((aabbmax[0] < mima->minx) || (aabbmin[0] > mima->maxx) || (aabbmax[1] < mima->miny) ||
+      (aabbmin[1] > mima->maxy) || (aabbmax[2] < mima->minz) || (aabbmin[2] > mima->maxz)) {
+    return;
+  }
+  BLI_buffer_append(data->tris, int, index);
+}
+
+/**
+ * Fill \a r_tris with the faces whose mima box touches the box from \a aabbmin to \a aabbmax.
+ * The faces are sorted, so forces accumulate in the same order as a scan over all faces.
+ */
+static int ccd_mesh_overlap(const ccd_Mesh *ccdm,
+                            const float aabbmin[3],
+                            const float aabbmax[3],
+                            BLI_Buffer *r_tris)
+{
+  ccd_MeshOverlapData data = {ccdm->mima, aabbmin, aabbmax, r_tris};
+  float center[3], radius;
+
+  /* The sphere around the box finds a superset of the faces, the callback checks the boxes. */
+  mid_v3_v3v3(center, aabbmin, aabbmax);
+  radius = len_v3v3(center, aabbmax) + FLT_EPSILON;
+
+  BLI_buffer_clear(r_tris);
+  BLI_bvhtree_range_query(ccdm->bvhtree, center, radius, ccd_mesh_overlap_cb, &data);
+
+  if (r_tris->count > 1) {
+    qsort(r_tris->data, r_tris->count, sizeof(int), BLI_sortutil_cmp_int);
+  }
+  return (int)r_tris->count;
+}
+
 static ccd_Mesh *ccd_mesh_make(Object *ob)
 {
   CollisionModifierData *cmd;
@@ -302,6 +387,7 @@ static ccd_Mesh *ccd_mesh_make(Object *ob)
   pccd_M->bbmin[0] = pccd_M->bbmin[1] = pccd_M->bbmin[2] = 1e30f;
   pccd_M->bbmax[0] = pccd_M->bbmax[1] = pccd_M->bbmax[2] = -1e30f;
   pccd_M->mprevvert = NULL;
+  pccd_M->bvhtree = NULL;
 
   /* blow it up with forcefield ranges */
   hull = max_ff(ob->pd->pdef_sbift, ob->pd->pdef_sboft);
@@ -361,6 +447,8 @@ static ccd_Mesh *ccd_mesh_make(Object *ob)
     mima->maxz = max_ff(mima->maxz, v[2] + hull);
   }
 
+  ccd_mesh_bvhtree_update(pccd_M);
+
   return pccd_M;
 }
 static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
@@ -481,7 +569,8 @@ static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
     mima->maxy = max_ff(mima->maxy, v[1] + hull);
     mima->maxz = max_ff(mima->maxz, v[2] + hull);
   }
-  return;
+
+  ccd_mesh_bvhtree_update(pccd_M);
 }
 
 static void ccd_mesh_free(ccd_Mesh *ccdm)
@@ -494,6 +583,7 @@ static void ccd_mesh_free(ccd_Mesh *ccdm)
       MEM_freeN((void *)ccdm->mprevvert);
     }
     MEM_freeN(ccdm->mima);
+    BLI_bvhtree_free(ccdm->bvhtree);
     MEM_freeN(ccdm);
     ccdm = NULL;
   }
@@ -1159,7 +1249,7 @@ static int sb_detect_face_collisionCached(float face_v1[3],
   GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
   float t, tune = 10.0f;
-  int a, deflected = 0;
+  int a, i, deflected = 0;
 
   aabbmin[0] = min_fff(face_v1[0], face_v2[0], face_v3[0]);
   aabbmin[1] = min_fff(face_v1[1], face_v2[1], face_v3[1]);
@@ -1168,6 +1258,8 @@ static int sb_detect_face_collisionCached(float face_v1[3],
   aabbmax[1] = max_fff(face_v1[1], face_v2[1], face_v3[1]);
   aabbmax[2] = max_fff(face_v1[2], face_v2[2], face_v3[2]);
 
+  BLI_buffer_declare_static(int, tris, BLI_BUFFER_NOP, 64);
+
   hash = vertexowner->soft->scratch->colliderhash;
   ihash = BLI_ghashIterator_new(hash);
   while (!BLI_ghashIterator_done(ihash)) {
@@ -1180,14 +1272,10 @@ static int sb_detect_face_collisionCached(float face_v1[3],
         const MVert *mvert = NULL;
         const MVert *mprevvert = NULL;
         const MVertTri *vt = NULL;
-        const ccdf_minmax *mima = NULL;
 
         if (ccdm) {
           mvert = ccdm->mvert;
-          vt = ccdm->tri;
           mprevvert = ccdm->mprevvert;
-          mima = ccdm->mima;
-          a = ccdm->tri_num;
 
           if ((aabbmax[0] < ccdm->bbmin[0]) || (aabbmax[1] < ccdm->bbmin[1]) ||
               (aabbmax[2] < ccdm->bbmin[2]) || (aabbmin[0] > ccdm->bbmax[0]) ||
@@ -1205,14 +1293,9 @@ static int sb_detect_face_collisionCached(float face_v1[3],
         }
 
         /* use mesh*/
-        while (a--) {
-          if ((aabbmax[0] < mima->minx) || (aabbmin[0] > mima->maxx) ||
-              (aabbmax[1] < mima->miny) || (aabbmin[1] > mima->maxy) ||
-              (aabbmax[2] < mima->minz) || (aabbmin[2] > mima->maxz)) {
-            mima++;
-            vt++;
-            continue;
-          }
+        a = ccd_mesh_overlap(ccdm, aabbmin, aabbmax, &tris);
+        for (i = 0; i < a; i++) {
+          vt = &ccdm->tri[BLI_buffer_at(&tris, int, i)];
 
           if (mvert) {
 
@@ -1244,14 +1327,13 @@ static int sb_detect_face_collisionCached(float face_v1[3],
             *damp = tune * ob->pd->pdef_sbdamp;
             deflected = 2;
           }
-          mima++;
-          vt++;
-        } /* while a */
+        } /* for overlapping faces */
       }   /* if (ob->pd && ob->pd->deflect) */
       BLI_ghashIterator_step(ihash);
     }
   } /* while () */
   BLI_ghashIterator_free(ihash);
+  BLI_buffer_free(&tris);
   return deflected;
 }
 
@@ -1337,13 +1419,15 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
   GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
   float t, el;
-  int a, deflected = 0;
+  int a, i, deflected = 0;
 
   minmax_v3v3_v3(aabbmin, aabbmax, edge_v1);
   minmax_v3v3_v3(aabbmin, aabbmax, edge_v2);
 
   el = len_v3v3(edge_v1, edge_v2);
 
+  BLI_buffer_declare_static(int, tris, BLI_BUFFER_NOP, 64);
+
   hash = vertexowner->soft->scratch->colliderhash;
   ihash = BLI_ghashIterator_new(hash);
   while (!BLI_ghashIterator_done(ihash)) {
@@ -1356,14 +1440,10 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
         const MVert *mvert = NULL;
         const MVert *mprevvert = NULL;
         const MVertTri *vt = NULL;
-        const ccdf_minmax *mima = NULL;
 
         if (ccdm) {
           mvert = ccdm->mvert;
           mprevvert = ccdm->mprevvert;
-          vt = ccdm->tri;
-          mima = ccdm->mima;
-          a = ccdm->tri_num;
 
           if ((aabbmax[0] < ccdm->bbmin[0]) || (aabbmax[1] < ccdm->bbmin[1]) ||
               (aabbmax[2] < ccdm->bbmin[2]) || (aabbmin[0] > ccdm->bbmax[0]) ||
@@ -1381,14 +1461,9 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
         }
 
         /* use mesh*/
-        while (a--) {
-          if ((aabbmax[0] < mima->minx) || (aabbmin[0] > mima->maxx) ||
-              (aabbmax[1] < mima->miny) || (aabbmin[1] > mima->maxy) ||
-              (aabbmax[2] < mima->minz) || (aabbmin[2] > mima->maxz)) {
-            mima++;
-            vt++;
-            continue;
-          }
+        a = ccd_mesh_overlap(ccdm, aabbmin, aabbmax, &tris);
+        for (i = 0; i < a; i++) {
+          vt = &ccdm->tri[BLI_buffer_at(&tris, int, i)];
 
           if (mvert) {
 
@@ -1426,18 +1501,59 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
             *damp = ob->pd->pdef_sbdamp;
             deflected = 2;
           }
-
-          mima++;
-          vt++;
-        } /* while a */
+        } /* for overlapping faces */
       }   /* if (ob->pd && ob->pd->deflect) */
       BLI_ghashIterator_step(ihash);
     }
   } /* while () */
   BLI_ghashIterator_free(ihash);
+  BLI_buffer_free(&tris);
   return deflected;
 }
 
+/* Size of the slices of items taken at once by the threads. */
+#define SB_THREAD_SLICE_SIZE 16
+
+static void sb_threads_task_cb(TaskPool *__restrict pool,
+                               void *UNUSED(taskdata),
+                               int UNUSED(threadid))
+{
+  SB_thread_context *pctx = BLI_task_pool_userdata(pool);
+  int ifirst;
+
+  while ((ifirst = atomic_fetch_and_add_int32(&pctx->next_index, SB_THREAD_SLICE_SIZE)) <
+         pctx->tot) {
+    pctx->slice_func(pctx, ifirst, min_ii(ifirst + SB_THREAD_SLICE_SIZE, pctx->tot));
+  }
+}
+
+/* Run pctx->slice_func over all items, with as many threads as the scene allows, while
+ * preventing pretty pointless threading overhead for less than lowitems items per thread.
+ * Items differ a lot in cost, so threads take slices of items as they go instead of getting
+ * fixed ranges of them. */
+static void sb_threads_run(SB_thread_context *pctx, int lowitems)
+{
+  int totthread = BKE_scene_num_threads(pctx->scene);
+  while ((pctx->tot / totthread < lowitems) && (totthread > 1)) {
+    totthread--;
+  }
+
+  if (totthread == 1) {
+    pctx->slice_func(pctx, 0, pctx->tot);
+    return;
+  }
+
+  /* The calling thread works on the tasks too, so no more than totthread of them run. */
+  pctx->next_index = 0;
+  TaskScheduler *scheduler = BLI_task_scheduler_get();
+  TaskPool *pool = BLI_task_pool_create(scheduler, pctx, TASK_PRIORITY_HIGH);
+  for (int i = 0; i < totthread; i++) {
+    BLI_task_pool_push(pool, sb_threads_task_cb, NULL, false, NULL);
+  }
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+}
+
 static void _scan_for_ext_spring_forces(
     Scene *scene, Object *ob, float timenow, int ifirst, int ilast, struct ListBase *effectors)
 {
@@ -1511,12 +1627,10 @@ static void _scan_for_ext_spring_forces(
   }
 }
 
-static void *exec_scan_for_ext_spring_forces(void *data)
+static void scan_for_ext_spring_forces_slice(SB_thread_context *pctx, int ifirst, int ilast)
 {
-  SB_thread_context *pctx = (SB_thread_context *)data;
   _scan_for_ext_spring_forces(
-      pctx->scene, pctx->ob, pctx->timenow, pctx->ifirst, pctx->ilast, pctx->effectors);
-  return NULL;
+      pctx->scene, pctx->ob, pctx->timenow, ifirst, ilast, pctx->effectors);
 }
 
 static void sb_sfesf_threads_run(struct Depsgraph *depsgraph,
@@ -1526,61 +1640,23 @@ static void sb_sfesf_threads_run(struct Depsgraph *depsgraph,
                                  int totsprings,
                                  int *UNUSED(ptr_to_break_func(void)))
 {
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
   /* wild guess .. may increase with better thread management 'above'
    * or even be UI option sb->spawn_cf_threads_nopts */
   int lowsprings = 100;
 
   ListBase *effectors = BKE_effectors_create(depsgraph, ob, NULL, ob->soft->effector_weights);
 
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* what if we got zillions of CPUs running but less to spread*/
-  while ((totsprings / totthread < lowsprings) && (totthread > 1)) {
-    totthread--;
-  }
-
-  sb_threads = MEM_callocN(sizeof(SB_thread_context) * totthread, "SBSpringsThread");
-  memset(sb_threads, 0, sizeof(SB_thread_context) * totthread);
-  left = totsprings;
-  dec = totsprings / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = 0.0;  // not used here
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
-    }
-    else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = false;  // not used here
-    sb_threads[i].fieldfactor = 0.0f;    // not used here
-    sb_threads[i].windfactor = 0.0f;     // not used here
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
-  }
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_scan_for_ext_spring_forces, totthread);
+  SB_thread_context sb_thread = {
+      .scene = scene,
+      .ob = ob,
+      .timenow = timenow,
+      .effectors = effectors,
+      .slice_func = scan_for_ext_spring_forces_slice,
+      .tot = totsprings,
+  };
 
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
-    }
-
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_scan_for_ext_spring_forces(&sb_threads[0]);
-  }
-  /* clean up */
-  MEM_freeN(sb_threads);
+  /* Springs differ a lot in cost (only some of them are near to colliders). */
+  sb_threads_run(&sb_thread, lowsprings);
 
   BKE_effectors_free(effectors);
 }
@@ -1631,13 +1707,16 @@ static int sb_detect_vertex_collisionCached(float opco[3],
   GHash *hash;
   GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], dv1[3], ve[3],
-      avel[3] = {0.0, 0.0, 0.0}, vv1[3], vv2[3], vv3[3], coledge[3] = {0.0f, 0.0f, 0.0f},
+      avel[3] = {0.0, 0.0, 0.0}, vv1[3] = {0.0f}, vv2[3] = {0.0f},
+      vv3[3] = {0.0f}, coledge[3] = {0.0f, 0.0f, 0.0f},
       mindistedge = 1000.0f, outerforceaccu[3], innerforceaccu[3], facedist,
       /* n_mag, */ /* UNUSED */ force_mag_norm, minx, miny, minz, maxx, maxy, maxz,
       innerfacethickness = -0.5f, outerfacethickness = 0.2f, ee = 5.0f, ff = 0.1f, fa = 1;
-  int a, deflected = 0, cavel = 0, ci = 0;
+  int a, i, deflected = 0, cavel = 0, ci = 0;
   /* init */
   *intrusion = 0.0f;
+  BLI_buffer_declare_static(int, tris, BLI_BUFFER_NOP, 64);
+
   hash = vertexowner->soft->scratch->colliderhash;
   ihash = BLI_ghashIterator_new(hash);
   outerforceaccu[0] = outerforceaccu[1] = outerforceaccu[2] = 0.0f;
@@ -1653,14 +1732,10 @@ static int sb_detect_vertex_collisionCached(float opco[3],
         const MVert *mvert = NULL;
         const MVert *mprevvert = NULL;
         const MVertTri *vt = NULL;
-        const ccdf_minmax *mima = NULL;
 
         if (ccdm) {
           mvert = ccdm->mvert;
           mprevvert = ccdm->mprevvert;
-          vt = ccdm->tri;
-          mima = ccdm->mima;
-          a = ccdm->tri_num;
 
           minx = ccdm->bbmin[0];
           miny = ccdm->bbmin[1];
@@ -1693,13 +1768,9 @@ static int sb_detect_vertex_collisionCached(float opco[3],
         fa = 1.0f / fa;
         avel[0] = avel[1] = avel[2] = 0.0f;
         /* use mesh*/
-        while (a--) {
-          if ((opco[0] < mima->minx) || (opco[0] > mima->maxx) || (opco[1] < mima->miny) ||
-              (opco[1] > mima->maxy) || (opco[2] < mima->minz) || (opco[2] > mima->maxz)) {
-            mima++;
-            vt++;
-            continue;
-          }
+        a = ccd_mesh_overlap(ccdm, opco, opco, &tris);
+        for (i = 0; i < a; i++) {
+          vt = &ccdm->tri[BLI_buffer_at(&tris, int, i)];
 
           if (mvert) {
 
@@ -1768,10 +1839,7 @@ static int sb_detect_vertex_collisionCached(float opco[3],
               ci++;
             }
           }
-
-          mima++;
-          vt++;
-        } /* while a */
+        } /* for overlapping faces */
       }   /* if (ob->pd && ob->pd->deflect) */
       BLI_ghashIterator_step(ihash);
     }
@@ -1797,6 +1865,7 @@ static int sb_detect_vertex_collisionCached(float opco[3],
   }
 
   BLI_ghashIterator_free(ihash);
+  BLI_buffer_free(&tris);
   if (cavel) {
     mul_v3_fl(avel, 1.0f / (float)cavel);
   }
@@ -2178,21 +2247,19 @@ static int _softbody_calc_forces_slice_in_a_thread(Scene *scene,
   return 0; /*done fine*/
 }
 
-static void *exec_softbody_calc_forces(void *data)
+static void softbody_calc_forces_slice(SB_thread_context *pctx, int ifirst, int ilast)
 {
-  SB_thread_context *pctx = (SB_thread_context *)data;
   _softbody_calc_forces_slice_in_a_thread(pctx->scene,
                                           pctx->ob,
                                           pctx->forcetime,
                                           pctx->timenow,
-                                          pctx->ifirst,
-                                          pctx->ilast,
+                                          ifirst,
+                                          ilast,
                                           NULL,
                                           pctx->effectors,
                                           pctx->do_deflector,
                                           pctx->fieldfactor,
                                           pctx->windfactor);
-  return NULL;
 }
 
 static void sb_cf_threads_run(Scene *scene,
@@ -2206,62 +2273,25 @@ static void sb_cf_threads_run(Scene *scene,
                               float fieldfactor,
                               float windfactor)
 {
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
   /* wild guess .. may increase with better thread management 'above'
    * or even be UI option sb->spawn_cf_threads_nopts. */
   int lowpoints = 100;
 
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* what if we got zillions of CPUs running but less to spread*/
-  while ((totpoint / totthread < lowpoints) && (totthread > 1)) {
-    totthread--;
-  }
-
-  /* printf("sb_cf_threads_run spawning %d threads\n", totthread); */
-
-  sb_threads = MEM_callocN(sizeof(SB_thread_context) * totthread, "SBThread");
-  memset(sb_threads, 0, sizeof(SB_thread_context) * totthread);
-  left = totpoint;
-  dec = totpoint / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = forcetime;
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
-    }
-    else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = do_deflector;
-    sb_threads[i].fieldfactor = fieldfactor;
-    sb_threads[i].windfactor = windfactor;
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
-  }
-
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_softbody_calc_forces, totthread);
-
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
-    }
-
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_softbody_calc_forces(&sb_threads[0]);
-  }
-  /* clean up */
-  MEM_freeN(sb_threads);
+  SB_thread_context sb_thread = {
+      .scene = scene,
+      .ob = ob,
+      .forcetime = forcetime,
+      .timenow = timenow,
+      .effectors = effectors,
+      .do_deflector = do_deflector,
+      .fieldfactor = fieldfactor,
+      .windfactor = windfactor,
+      .slice_func = softbody_calc_forces_slice,
+      .tot = totpoint,
+  };
+
+  /* Points near colliders or other points cost much more than free ones. */
+  sb_threads_run(&sb_thread, lowpoints);
 }
 
 static void softbody_calc_forces(
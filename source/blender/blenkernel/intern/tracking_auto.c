@@ -21,7 +21,6 @@
  * \ingroup bke
  */
 
-#include "atomic_ops.h"
 #include <stdlib.h>
 
 #include "MEM_guardedalloc.h"
@@ -38,6 +37,9 @@
 #include "BKE_movieclip.h"
 #include "BKE_tracking.h"
 
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
 #include "libmv-capi.h"
 #include "tracking_private.h"
 
@@ -79,8 +81,6 @@ typedef struct AutoTrackContext {
   int sync_frame;
   bool first_sync;
   SpinLock spin_lock;
-
-  bool step_ok;
 } AutoTrackContext;
 
 static void normalized_to_libmv_frame(const float normalized[2],
@@ -373,46 +373,49 @@ AutoTrackContext *BKE_autotrack_context_new(MovieClip *clip,
   return context;
 }
 
-static void autotrack_context_step_cb(void *__restrict userdata,
-                                      const int track,
-                                      const TaskParallelTLS *__restrict UNUSED(tls))
+/* Track a single track from the given clip frame to the next one.
+ *
+ * Returns false when the track is not tracked from this frame: it failed before, has no marker
+ * on the frame or got too close to the frame boundary. Only a failure stops the track for good.
+ */
+static bool autotrack_context_track_step(AutoTrackContext *context,
+                                         AutoTrackOptions *options,
+                                         const int frame)
 {
-  AutoTrackContext *context = userdata;
   const int frame_delta = context->backwards ? -1 : 1;
 
-  AutoTrackOptions *options = &context->options[track];
   if (options->is_failed) {
-    return;
+    return false;
   }
   libmv_Marker libmv_current_marker, libmv_reference_marker, libmv_tracked_marker;
   libmv_TrackRegionResult libmv_result;
-  const int frame = BKE_movieclip_remap_scene_to_clip_frame(context->clips[options->clip_index],
-                                                            context->user.framenr);
   BLI_spin_lock(&context->spin_lock);
   const bool has_marker = libmv_autoTrackGetMarker(
       context->autotrack, options->clip_index, frame, options->track_index, &libmv_current_marker);
   BLI_spin_unlock(&context->spin_lock);
   /* Check whether we've got marker to sync with. */
   if (!has_marker) {
-    return;
+    return false;
   }
   /* Check whether marker is going outside of allowed frame margin. */
   if (!tracking_check_marker_margin(&libmv_current_marker,
                                     options->track->margin,
                                     context->frame_width,
                                     context->frame_height)) {
-    return;
+    return false;
   }
   libmv_tracked_marker = libmv_current_marker;
   libmv_tracked_marker.frame = frame + frame_delta;
   /* Update reference frame. */
   if (options->use_keyframe_match) {
     libmv_tracked_marker.reference_frame = libmv_current_marker.reference_frame;
+    BLI_spin_lock(&context->spin_lock);
     libmv_autoTrackGetMarker(context->autotrack,
                              options->clip_index,
                              libmv_tracked_marker.reference_frame,
                              options->track_index,
                              &libmv_reference_marker);
+    BLI_spin_unlock(&context->spin_lock);
   }
   else {
     libmv_tracked_marker.reference_frame = frame;
@@ -431,29 +434,126 @@ static void autotrack_context_step_cb(void *__restrict userdata,
     options->is_failed = true;
     options->failed_frame = frame + frame_delta;
   }
+  return true;
+}
 
-  /* Note: Atomic is probably not actually needed here, I doubt we could get
-   *       any other result than a true bool anyway.
-   *       But for sake of consistency, and since it costs nothing...
-   */
-  atomic_fetch_and_or_uint8((uint8_t *)&context->step_ok, true);
+typedef struct AutoTrackStepData {
+  AutoTrackContext *context;
+  /* Scene frame the tracks start from. */
+  int start_frame;
+  int num_frames;
+  /* Number of frames up to the last one any track was tracked from. */
+  int num_stepped_frames;
+} AutoTrackStepData;
+
+/* Tracks don't depend on each other, so every track is advanced over all the frames on its own,
+ * without waiting for the other tracks at every frame. */
+static void autotrack_context_step_cb(void *__restrict userdata,
+                                      const int track,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  AutoTrackStepData *data = userdata;
+  AutoTrackContext *context = data->context;
+  AutoTrackOptions *options = &context->options[track];
+  MovieClip *clip = context->clips[options->clip_index];
+  const int frame_delta = context->backwards ? -1 : 1;
+
+  int num_stepped_frames = 0;
+  for (int i = 0; i < data->num_frames && !options->is_failed; i++) {
+    const int frame = BKE_movieclip_remap_scene_to_clip_frame(
+        clip, data->start_frame + i * frame_delta);
+    /* Frames without marker or outside of the margin are skipped, as single steps would. */
+    if (autotrack_context_track_step(context, options, frame)) {
+      num_stepped_frames = i + 1;
+    }
+  }
+
+  if (num_stepped_frames > 0) {
+    BLI_spin_lock(&context->spin_lock);
+    data->num_stepped_frames = max_ii(data->num_stepped_frames, num_stepped_frames);
+    BLI_spin_unlock(&context->spin_lock);
+  }
 }
 
-bool BKE_autotrack_context_step(AutoTrackContext *context)
+/* Read the frames to be tracked ahead of the trackers, so they are in the clip cache by the time
+ * they are needed. Frames are read in order, which is what movie files are best at. */
+static void autotrack_context_prefetch_cb(TaskPool *__restrict pool,
+                                          void *UNUSED(taskdata),
+                                          int UNUSED(threadid))
 {
+  AutoTrackStepData *data = BLI_task_pool_userdata(pool);
+  AutoTrackContext *context = data->context;
   const int frame_delta = context->backwards ? -1 : 1;
-  context->step_ok = false;
+
+  /* The first frame is already needed by the trackers, start with the next one. */
+  for (int i = 1; i <= data->num_frames; i++) {
+    if (BLI_task_pool_canceled(pool)) {
+      break;
+    }
+    for (int clip_index = 0; clip_index < context->num_clips; clip_index++) {
+      MovieClip *clip = context->clips[clip_index];
+      MovieClipUser user = context->user;
+      BKE_movieclip_user_set_frame(&user, data->start_frame + i * frame_delta);
+      if (!BKE_movieclip_has_cached_frame(clip, &user)) {
+        ImBuf *ibuf = BKE_movieclip_get_ibuf(clip, &user);
+        if (ibuf) {
+          IMB_freeImBuf(ibuf);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Track all tracks over up to \a num_frames frames.
+ *
+ * Tracks are advanced as by calling #BKE_autotrack_context_step as many times, but they don't
+ * wait for each other at every frame, and upcoming frames are read while tracking. Unlike single
+ * steps, tracks are not stopped by a frame on which none of them could be tracked, only by the
+ * end of the frames.
+ *
+ * \return the number of frames up to the last one at least one track was tracked from,
+ * tracking is finished when it is less than \a num_frames.
+ */
+int BKE_autotrack_context_step_frames(AutoTrackContext *context, const int num_frames)
+{
+  const int frame_delta = context->backwards ? -1 : 1;
+
+  AutoTrackStepData data = {
+      .context = context,
+      .start_frame = context->user.framenr,
+      .num_frames = num_frames,
+      .num_stepped_frames = 0,
+  };
+
+  TaskPool *prefetch_pool = NULL;
+  if (num_frames > 1) {
+    TaskScheduler *scheduler = BLI_task_scheduler_get();
+    prefetch_pool = BLI_task_pool_create(scheduler, &data, TASK_PRIORITY_LOW);
+    BLI_task_pool_push(prefetch_pool, autotrack_context_prefetch_cb, NULL, false, NULL);
+  }
 
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.use_threading = (context->num_tracks > 1);
-  BLI_task_parallel_range(0, context->num_tracks, context, autotrack_context_step_cb, &settings);
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  BLI_task_parallel_range(0, context->num_tracks, &data, autotrack_context_step_cb, &settings);
 
-  /* Advance the frame. */
+  if (prefetch_pool) {
+    BLI_task_pool_cancel(prefetch_pool);
+    BLI_task_pool_free(prefetch_pool);
+  }
+
+  /* Advance the frame, including the one tracking stopped at (as single steps would do). */
   BLI_spin_lock(&context->spin_lock);
-  context->user.framenr += frame_delta;
+  context->user.framenr += frame_delta * min_ii(data.num_stepped_frames + 1, num_frames);
   BLI_spin_unlock(&context->spin_lock);
-  return context->step_ok;
+  return data.num_stepped_frames;
+}
+
+bool BKE_autotrack_context_step(AutoTrackContext *context)
+{
+  return BKE_autotrack_context_step_frames(context, 1) == 1;
 }
 
 void BKE_autotrack_context_sync(AutoTrackContext *context)
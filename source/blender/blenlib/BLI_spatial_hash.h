@@ -0,0 +1,71 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+#ifndef __BLI_SPATIAL_HASH_H__
+#define __BLI_SPATIAL_HASH_H__
+
+/** \file
+ * \ingroup bli
+ *
+ * Uniform grid of hashed cells, to find overlapping bounding boxes of many items which change
+ * every time step. Unlike a BVH-tree there is no hierarchy to refit, the cells are rebuilt from
+ * scratch and in parallel on every update.
+ */
+
+#include "BLI_kdopbvh.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SpatialHash SpatialHash;
+
+SpatialHash *BLI_spatial_hash_new(int items_num, float epsilon);
+void BLI_spatial_hash_free(SpatialHash *hash);
+int BLI_spatial_hash_get_len(const SpatialHash *hash);
+
+/**
+ * Set the bounds of an item from its points. When \a co_moving is given the bounds contain the
+ * whole motion from \a co to \a co_moving, so that items which may touch during a time step are
+ * reported as overlapping. Can be called from multiple threads for different items.
+ */
+void BLI_spatial_hash_update_item(SpatialHash *hash,
+                                  int index,
+                                  const float co[3],
+                                  const float co_moving[3],
+                                  int numpoints);
+
+/* Rebuild the cells after the items have been updated. */
+void BLI_spatial_hash_update(SpatialHash *hash);
+
+/**
+ * Find all pairs of items with overlapping bounds, each pair is reported once with
+ * `indexA < indexB`.
+ */
+BVHTreeOverlap *BLI_spatial_hash_overlap_self(const SpatialHash *hash,
+                                              unsigned int *r_overlap_tot,
+                                              BVHTree_OverlapCallback callback,
+                                              void *userdata);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_SPATIAL_HASH_H__ */
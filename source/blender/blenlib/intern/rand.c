@@ -254,9 +254,22 @@ void BLI_rng_shuffle_array(RNG *rng, void *data, unsigned int elem_size_i, unsig
  */
 void BLI_rng_skip(RNG *rng, int n)
 {
-  while (n--) {
-    rng_step(rng);
+  /* Each step is the affine map `X -> (MULTIPLIER * X + ADDEND) & MASK`, the map for \a n steps
+   * is built from its powers of two, so skipping takes `O(log(n))` instead of `O(n)`. */
+  uint64_t step_mul = MULTIPLIER, step_add = ADDEND;
+  uint64_t skip_mul = 1, skip_add = 0;
+
+  while (n > 0) {
+    if (n & 1) {
+      skip_mul = (step_mul * skip_mul) & MASK;
+      skip_add = (step_mul * skip_add + step_add) & MASK;
+    }
+    step_add = ((step_mul + 1) * step_add) & MASK;
+    step_mul = (step_mul * step_mul) & MASK;
+    n >>= 1;
   }
+
+  rng->X = (skip_mul * rng->X + skip_add) & MASK;
 }
 
 /***/
@@ -0,0 +1,601 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Every item is inserted into all grid cells touched by its bounds, the cells are hashed into a
+ * table with a counting sort: the entries per bucket are counted with atomics, offsets are
+ * accumulated and the entries are written into their bucket, all without locks.
+ *
+ * Items are bounded by a 26-DOP like BVH-trees, so an overlap query finds the same pairs. It looks
+ * up the cells of each item. A pair of items that shares several cells is
+ * only reported from the first cell they have in common, which also filters out unrelated items
+ * that land in the same bucket because of hash collisions.
+ *
+ * Items that would touch more than #SPATIAL_HASH_ITEM_CELLS_MAX cells (a degenerate face that
+ * spans the whole mesh for example) are not put in the table, they are tested against all other
+ * items instead.
+ */
+
+#include <float.h>
+#include <limits.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_stack.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+
+/* Items are processed in chunks, results are combined in chunk order
+ * so they don't depend on the number of threads. */
+#define SPATIAL_HASH_CHUNK_SIZE 256
+#define SPATIAL_HASH_BUCKET_CHUNK_SIZE 4096
+/* Limit of cells along each axis of the grid, so items that are much larger than average
+ * don't end up in a huge number of cells. */
+#define SPATIAL_HASH_MAX_AXIS_CELLS 1024
+/* Items touching more cells are tested against all items instead of being put in the table. */
+#define SPATIAL_HASH_ITEM_CELLS_MAX 64
+
+/* Items are bounded by the same 26-DOP as a BVH-tree with 26 axes, where the first three axes
+ * give the box which is used for the cells. */
+#define SPATIAL_HASH_AXES 13
+
+typedef struct SpatialHashItem {
+  /* Minimum and maximum along each axis. */
+  float bv[SPATIAL_HASH_AXES * 2];
+  int cell_min[3], cell_max[3];
+  /* Too large for the table, see #SPATIAL_HASH_ITEM_CELLS_MAX. */
+  bool is_large;
+} SpatialHashItem;
+
+typedef struct SpatialHashChunk {
+  float bounds_min[3], bounds_max[3];
+  float extent_sum;
+  int valid_num;
+  int large_num;
+  size_t entries_num;
+} SpatialHashChunk;
+
+struct SpatialHash {
+  SpatialHashItem *items;
+  int items_num;
+  float epsilon;
+
+  float origin[3];
+  float cell_size_inv;
+
+  /* Start of the entries of each bucket, `table_size + 1` elements. */
+  uint *bucket_offset;
+  /* Number of entries during the build, end of the unfilled part of the bucket after. */
+  uint *bucket_fill;
+  uint table_size;
+
+  int *entries;
+  uint entries_num, entries_alloc;
+  /* Number of items which are not in the table. */
+  int large_num;
+
+  SpatialHashChunk *chunks;
+  int chunks_num;
+};
+
+BLI_INLINE bool spatial_hash_item_is_valid(const SpatialHashItem *item)
+{
+  return item->bv[0] <= item->bv[1];
+}
+
+static void spatial_hash_item_clear(SpatialHashItem *item)
+{
+  for (int axis = 0; axis < SPATIAL_HASH_AXES; axis++) {
+    item->bv[axis * 2] = FLT_MAX;
+    item->bv[axis * 2 + 1] = -FLT_MAX;
+  }
+}
+
+static void spatial_hash_item_add_points(SpatialHashItem *item, const float *co, int numpoints)
+{
+  for (int i = 0; i < numpoints; i++) {
+    for (int axis = 0; axis < SPATIAL_HASH_AXES; axis++) {
+      const float proj = dot_v3v3(&co[i * 3], bvhtree_kdop_axes[axis]);
+      item->bv[axis * 2] = min_ff(item->bv[axis * 2], proj);
+      item->bv[axis * 2 + 1] = max_ff(item->bv[axis * 2 + 1], proj);
+    }
+  }
+}
+
+BLI_INLINE uint spatial_hash_cell(const SpatialHash *hash, int x, int y, int z)
+{
+  return (((uint)x * 73856093u) ^ ((uint)y * 19349663u) ^ ((uint)z * 83492791u)) &
+         (hash->table_size - 1);
+}
+
+BLI_INLINE void spatial_hash_chunk_range(int chunk, int num, int *r_start, int *r_end)
+{
+  *r_start = chunk * SPATIAL_HASH_CHUNK_SIZE;
+  *r_end = min_ii(*r_start + SPATIAL_HASH_CHUNK_SIZE, num);
+}
+
+SpatialHash *BLI_spatial_hash_new(int items_num, float epsilon)
+{
+  SpatialHash *hash = MEM_callocN(sizeof(*hash), __func__);
+
+  hash->items_num = items_num;
+  hash->epsilon = epsilon;
+  hash->items = MEM_mallocN(sizeof(*hash->items) * (size_t)max_ii(items_num, 1), __func__);
+  for (int i = 0; i < items_num; i++) {
+    spatial_hash_item_clear(&hash->items[i]);
+  }
+
+  hash->chunks_num = max_ii((items_num + SPATIAL_HASH_CHUNK_SIZE - 1) / SPATIAL_HASH_CHUNK_SIZE,
+                            1);
+  hash->chunks = MEM_mallocN(sizeof(*hash->chunks) * (size_t)hash->chunks_num, __func__);
+
+  return hash;
+}
+
+void BLI_spatial_hash_free(SpatialHash *hash)
+{
+  MEM_freeN(hash->items);
+  MEM_freeN(hash->chunks);
+  MEM_SAFE_FREE(hash->bucket_offset);
+  MEM_SAFE_FREE(hash->bucket_fill);
+  MEM_SAFE_FREE(hash->entries);
+  MEM_freeN(hash);
+}
+
+int BLI_spatial_hash_get_len(const SpatialHash *hash)
+{
+  return hash->items_num;
+}
+
+void BLI_spatial_hash_update_item(
+    SpatialHash *hash, int index, const float co[3], const float co_moving[3], int numpoints)
+{
+  SpatialHashItem *item = &hash->items[index];
+
+  BLI_assert(index >= 0 && index < hash->items_num);
+
+  spatial_hash_item_clear(item);
+  spatial_hash_item_add_points(item, co, numpoints);
+  if (co_moving) {
+    spatial_hash_item_add_points(item, co_moving, numpoints);
+  }
+
+  if (numpoints > 0) {
+    for (int axis = 0; axis < SPATIAL_HASH_AXES; axis++) {
+      item->bv[axis * 2] -= hash->epsilon;
+      item->bv[axis * 2 + 1] += hash->epsilon;
+    }
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Build
+ * \{ */
+
+static void spatial_hash_bounds_task(void *__restrict userdata,
+                                     const int chunk,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHash *hash = userdata;
+  SpatialHashChunk *data = &hash->chunks[chunk];
+  int start, end;
+  spatial_hash_chunk_range(chunk, hash->items_num, &start, &end);
+
+  INIT_MINMAX(data->bounds_min, data->bounds_max);
+  data->extent_sum = 0.0f;
+  data->valid_num = 0;
+
+  for (int i = start; i < end; i++) {
+    const SpatialHashItem *item = &hash->items[i];
+    if (!spatial_hash_item_is_valid(item)) {
+      continue;
+    }
+
+    data->extent_sum += max_fff(
+        item->bv[1] - item->bv[0], item->bv[3] - item->bv[2], item->bv[5] - item->bv[4]);
+    data->valid_num++;
+
+    for (int k = 0; k < 3; k++) {
+      data->bounds_min[k] = min_ff(data->bounds_min[k], item->bv[k * 2]);
+      data->bounds_max[k] = max_ff(data->bounds_max[k], item->bv[k * 2 + 1]);
+    }
+  }
+}
+
+static void spatial_hash_cells_task(void *__restrict userdata,
+                                    const int chunk,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHash *hash = userdata;
+  SpatialHashChunk *data = &hash->chunks[chunk];
+  int start, end;
+  spatial_hash_chunk_range(chunk, hash->items_num, &start, &end);
+
+  data->entries_num = 0;
+  data->large_num = 0;
+
+  for (int i = start; i < end; i++) {
+    SpatialHashItem *item = &hash->items[i];
+    if (!spatial_hash_item_is_valid(item)) {
+      continue;
+    }
+
+    /* Items are within the bounds, so there are at most #SPATIAL_HASH_MAX_AXIS_CELLS + 1 cells
+     * along each axis, clamp anyway in case of precision issues. */
+    size_t cells_num = 1;
+    for (int k = 0; k < 3; k++) {
+      item->cell_min[k] = (int)((item->bv[k * 2] - hash->origin[k]) * hash->cell_size_inv);
+      item->cell_max[k] = (int)((item->bv[k * 2 + 1] - hash->origin[k]) * hash->cell_size_inv);
+      CLAMP(item->cell_min[k], 0, SPATIAL_HASH_MAX_AXIS_CELLS);
+      CLAMP(item->cell_max[k], item->cell_min[k], SPATIAL_HASH_MAX_AXIS_CELLS);
+      cells_num *= (size_t)(item->cell_max[k] - item->cell_min[k] + 1);
+    }
+
+    item->is_large = (cells_num > SPATIAL_HASH_ITEM_CELLS_MAX);
+    if (item->is_large) {
+      data->large_num++;
+    }
+    else {
+      data->entries_num += cells_num;
+    }
+  }
+}
+
+/* Loop over the cells of an item. */
+#define SPATIAL_HASH_ITEM_CELLS_BEGIN(_hash, _item, _x, _y, _z, _bucket) \
+  for (int _z = (_item)->cell_min[2]; _z <= (_item)->cell_max[2]; _z++) { \
+    for (int _y = (_item)->cell_min[1]; _y <= (_item)->cell_max[1]; _y++) { \
+      for (int _x = (_item)->cell_min[0]; _x <= (_item)->cell_max[0]; _x++) { \
+        const uint _bucket = spatial_hash_cell(_hash, _x, _y, _z);
+
+#define SPATIAL_HASH_ITEM_CELLS_END \
+  } \
+  } \
+  } \
+  ((void)0)
+
+static void spatial_hash_count_task(void *__restrict userdata,
+                                    const int chunk,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHash *hash = userdata;
+  int start, end;
+  spatial_hash_chunk_range(chunk, hash->items_num, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    const SpatialHashItem *item = &hash->items[i];
+    if (!spatial_hash_item_is_valid(item) || item->is_large) {
+      continue;
+    }
+
+    SPATIAL_HASH_ITEM_CELLS_BEGIN (hash, item, x, y, z, bucket) {
+      atomic_add_and_fetch_uint32(&hash->bucket_fill[bucket], 1);
+    }
+    SPATIAL_HASH_ITEM_CELLS_END;
+  }
+}
+
+static void spatial_hash_fill_task(void *__restrict userdata,
+                                   const int chunk,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHash *hash = userdata;
+  int start, end;
+  spatial_hash_chunk_range(chunk, hash->items_num, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    const SpatialHashItem *item = &hash->items[i];
+    if (!spatial_hash_item_is_valid(item) || item->is_large) {
+      continue;
+    }
+
+    SPATIAL_HASH_ITEM_CELLS_BEGIN (hash, item, x, y, z, bucket) {
+      const uint entry = atomic_sub_and_fetch_uint32(&hash->bucket_fill[bucket], 1);
+      hash->entries[entry] = i;
+    }
+    SPATIAL_HASH_ITEM_CELLS_END;
+  }
+}
+
+/* The fill order depends on threading, sort the buckets to get a stable result. */
+static void spatial_hash_sort_task(void *__restrict userdata,
+                                   const int chunk,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHash *hash = userdata;
+  const uint start = (uint)chunk * SPATIAL_HASH_BUCKET_CHUNK_SIZE;
+  const uint end = MIN2(start + SPATIAL_HASH_BUCKET_CHUNK_SIZE, hash->table_size);
+
+  for (uint bucket = start; bucket < end; bucket++) {
+    int *entries = &hash->entries[hash->bucket_offset[bucket]];
+    const uint entries_num = hash->bucket_offset[bucket + 1] - hash->bucket_offset[bucket];
+
+    /* Buckets are small, insertion sort is fine. */
+    for (uint i = 1; i < entries_num; i++) {
+      const int value = entries[i];
+      uint j = i;
+      for (; j > 0 && entries[j - 1] > value; j--) {
+        entries[j] = entries[j - 1];
+      }
+      entries[j] = value;
+    }
+  }
+}
+
+void BLI_spatial_hash_update(SpatialHash *hash)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (hash->items_num > SPATIAL_HASH_CHUNK_SIZE);
+
+  /* Size the cells after the average item. */
+  BLI_task_parallel_range(0, hash->chunks_num, hash, spatial_hash_bounds_task, &settings);
+
+  float bounds_min[3], bounds_max[3], extent_sum = 0.0f;
+  int valid_num = 0;
+  INIT_MINMAX(bounds_min, bounds_max);
+  for (int chunk = 0; chunk < hash->chunks_num; chunk++) {
+    const SpatialHashChunk *data = &hash->chunks[chunk];
+    if (data->valid_num) {
+      minmax_v3v3_v3(bounds_min, bounds_max, data->bounds_min);
+      minmax_v3v3_v3(bounds_min, bounds_max, data->bounds_max);
+      extent_sum += data->extent_sum;
+      valid_num += data->valid_num;
+    }
+  }
+
+  if (valid_num == 0) {
+    zero_v3(hash->origin);
+    hash->cell_size_inv = 1.0f;
+  }
+  else {
+    float extent[3];
+    sub_v3_v3v3(extent, bounds_max, bounds_min);
+    float cell_size = max_ff(extent_sum / (float)valid_num,
+                             max_fff(extent[0], extent[1], extent[2]) /
+                                 (float)SPATIAL_HASH_MAX_AXIS_CELLS);
+
+    copy_v3_v3(hash->origin, bounds_min);
+    hash->cell_size_inv = (cell_size > 0.0f) ? 1.0f / cell_size : 1.0f;
+  }
+
+  /* Count the cells of every item, which gives the size of the table. Entries are indexed with
+   * 32 bit integers, in the unlikely case there are more the cells are made larger, at the
+   * latest when a single cell covers all items there is one entry per item. */
+  size_t entries_num;
+  while (true) {
+    BLI_task_parallel_range(0, hash->chunks_num, hash, spatial_hash_cells_task, &settings);
+
+    entries_num = 0;
+    hash->large_num = 0;
+    for (int chunk = 0; chunk < hash->chunks_num; chunk++) {
+      entries_num += hash->chunks[chunk].entries_num;
+      hash->large_num += hash->chunks[chunk].large_num;
+    }
+
+    if (entries_num <= UINT_MAX) {
+      break;
+    }
+    hash->cell_size_inv *= 0.5f;
+  }
+  hash->entries_num = (uint)entries_num;
+
+  if (hash->entries_num > hash->entries_alloc) {
+    MEM_SAFE_FREE(hash->entries);
+    hash->entries_alloc = hash->entries_num;
+    hash->entries = MEM_mallocN(sizeof(*hash->entries) * (size_t)hash->entries_alloc, __func__);
+  }
+
+  /* The table size is a power of two that fits in 32 bits. */
+  uint table_size_min = (hash->entries_num == 0) ? 1u : hash->entries_num;
+  CLAMP_MAX(table_size_min, 1u << 31);
+  const uint table_size = power_of_2_max_u(table_size_min);
+  if (table_size != hash->table_size) {
+    MEM_SAFE_FREE(hash->bucket_offset);
+    MEM_SAFE_FREE(hash->bucket_fill);
+    hash->table_size = table_size;
+    hash->bucket_offset = MEM_mallocN(sizeof(uint) * ((size_t)table_size + 1), __func__);
+    hash->bucket_fill = MEM_mallocN(sizeof(uint) * (size_t)table_size, __func__);
+  }
+  memset(hash->bucket_fill, 0, sizeof(uint) * (size_t)table_size);
+
+  BLI_task_parallel_range(0, hash->chunks_num, hash, spatial_hash_count_task, &settings);
+
+  hash->bucket_offset[0] = 0;
+  for (uint bucket = 0; bucket < table_size; bucket++) {
+    hash->bucket_offset[bucket + 1] = hash->bucket_offset[bucket] + hash->bucket_fill[bucket];
+    hash->bucket_fill[bucket] = hash->bucket_offset[bucket + 1];
+  }
+
+  BLI_task_parallel_range(0, hash->chunks_num, hash, spatial_hash_fill_task, &settings);
+
+  const int bucket_chunks_num = (int)((table_size + SPATIAL_HASH_BUCKET_CHUNK_SIZE - 1) /
+                                      SPATIAL_HASH_BUCKET_CHUNK_SIZE);
+  BLI_task_parallel_range(0, bucket_chunks_num, hash, spatial_hash_sort_task, &settings);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Overlap
+ * \{ */
+
+typedef struct SpatialHashOverlapData {
+  const SpatialHash *hash;
+  BVHTree_OverlapCallback callback;
+  void *userdata;
+  BLI_Stack **overlap;
+} SpatialHashOverlapData;
+
+BLI_INLINE bool spatial_hash_items_overlap(const SpatialHashItem *a, const SpatialHashItem *b)
+{
+  for (int axis = 0; axis < SPATIAL_HASH_AXES; axis++) {
+    if (a->bv[axis * 2] > b->bv[axis * 2 + 1] || b->bv[axis * 2] > a->bv[axis * 2 + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void spatial_hash_overlap_pair(SpatialHashOverlapData *data,
+                                      BLI_Stack *overlap,
+                                      int index_a,
+                                      int index_b,
+                                      int thread)
+{
+  if (!spatial_hash_items_overlap(&data->hash->items[index_a], &data->hash->items[index_b])) {
+    return;
+  }
+
+  if (data->callback && !data->callback(data->userdata, index_a, index_b, thread)) {
+    return;
+  }
+
+  BVHTreeOverlap *pair = BLI_stack_push_r(overlap);
+  pair->indexA = index_a;
+  pair->indexB = index_b;
+}
+
+/* Items that are not in the table are tested against every other item. */
+static void spatial_hash_overlap_large_item(SpatialHashOverlapData *data,
+                                            BLI_Stack *overlap,
+                                            int index_a,
+                                            int thread)
+{
+  const SpatialHash *hash = data->hash;
+
+  for (int index_b = 0; index_b < hash->items_num; index_b++) {
+    const SpatialHashItem *item_b = &hash->items[index_b];
+    if (index_b == index_a || !spatial_hash_item_is_valid(item_b)) {
+      continue;
+    }
+    /* A pair of large items is reported by the first one. */
+    if (item_b->is_large && index_b < index_a) {
+      continue;
+    }
+
+    spatial_hash_overlap_pair(
+        data, overlap, min_ii(index_a, index_b), max_ii(index_a, index_b), thread);
+  }
+}
+
+static void spatial_hash_overlap_task(void *__restrict userdata,
+                                      const int chunk,
+                                      const TaskParallelTLS *__restrict tls)
+{
+  SpatialHashOverlapData *data = userdata;
+  const SpatialHash *hash = data->hash;
+  BLI_Stack *overlap = data->overlap[chunk];
+  int start, end;
+  spatial_hash_chunk_range(chunk, hash->items_num, &start, &end);
+
+  for (int index_a = start; index_a < end; index_a++) {
+    const SpatialHashItem *item_a = &hash->items[index_a];
+    if (!spatial_hash_item_is_valid(item_a)) {
+      continue;
+    }
+    if (item_a->is_large) {
+      spatial_hash_overlap_large_item(data, overlap, index_a, tls->thread_id);
+      continue;
+    }
+
+    SPATIAL_HASH_ITEM_CELLS_BEGIN (hash, item_a, x, y, z, bucket) {
+      int index_prev = -1;
+
+      for (uint entry = hash->bucket_offset[bucket]; entry < hash->bucket_offset[bucket + 1];
+           entry++) {
+        const int index_b = hash->entries[entry];
+
+        /* Entries are sorted, an item can be in a bucket more than once. */
+        if (index_b <= index_a || index_b == index_prev) {
+          continue;
+        }
+        index_prev = index_b;
+
+        /* Only report the pair from the first cell both items are in. */
+        const SpatialHashItem *item_b = &hash->items[index_b];
+        if (max_ii(item_a->cell_min[0], item_b->cell_min[0]) != x ||
+            max_ii(item_a->cell_min[1], item_b->cell_min[1]) != y ||
+            max_ii(item_a->cell_min[2], item_b->cell_min[2]) != z) {
+          continue;
+        }
+
+        spatial_hash_overlap_pair(data, overlap, index_a, index_b, tls->thread_id);
+      }
+    }
+    SPATIAL_HASH_ITEM_CELLS_END;
+  }
+}
+
+BVHTreeOverlap *BLI_spatial_hash_overlap_self(const SpatialHash *hash,
+                                              unsigned int *r_overlap_tot,
+                                              BVHTree_OverlapCallback callback,
+                                              void *userdata)
+{
+  SpatialHashOverlapData data = {
+      .hash = hash,
+      .callback = callback,
+      .userdata = userdata,
+      .overlap = MEM_mallocN(sizeof(BLI_Stack *) * (size_t)hash->chunks_num, __func__),
+  };
+
+  for (int chunk = 0; chunk < hash->chunks_num; chunk++) {
+    data.overlap[chunk] = BLI_stack_new(sizeof(BVHTreeOverlap), __func__);
+  }
+
+  if (hash->entries_num || hash->large_num) {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (hash->items_num > SPATIAL_HASH_CHUNK_SIZE);
+    settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+    BLI_task_parallel_range(0, hash->chunks_num, &data, spatial_hash_overlap_task, &settings);
+  }
+
+  size_t total = 0;
+  for (int chunk = 0; chunk < hash->chunks_num; chunk++) {
+    total += BLI_stack_count(data.overlap[chunk]);
+  }
+
+  BVHTreeOverlap *overlap = MEM_mallocN(sizeof(BVHTreeOverlap) * total, "BVHTreeOverlap");
+  BVHTreeOverlap *to = overlap;
+
+  for (int chunk = 0; chunk < hash->chunks_num; chunk++) {
+    const uint count = (uint)BLI_stack_count(data.overlap[chunk]);
+    BLI_stack_pop_n_reverse(data.overlap[chunk], to, count);
+    BLI_stack_free(data.overlap[chunk]);
+    to += count;
+  }
+
+  MEM_freeN(data.overlap);
+
+  *r_overlap_tot = (uint)total;
+  return overlap;
+}
+
+/** \} */
@@ -10451,6 +10451,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     link_global(fd, bfd); /* as last */
   }
 
+  /* IDs were added and renamed by reading and versioning code without keeping the name registry
+   * up to date, it is re-generated on demand. */
+  BKE_main_namemap_clear(bfd->main);
+
   fd->mainlist = NULL; /* Safety, this is local variable, shall not be used afterward. */
 
   return bfd;
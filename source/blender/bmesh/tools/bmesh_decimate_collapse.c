@@ -32,6 +32,7 @@
 #include "BLI_polyfill_2d.h"
 #include "BLI_polyfill_2d_beautify.h"
 #include "BLI_quadric.h"
+#include "BLI_task.h"
 #include "BLI_utildefines_stack.h"
 
 #include "BKE_customdata.h"
@@ -76,6 +77,18 @@ typedef enum CD_UseFlag {
 /* BMesh Helper Functions
  * ********************** */
 
+static void bm_decim_face_plane_cb(void *userdata, MempoolIterData *mp_f)
+{
+  double(*fplanes)[4] = userdata;
+  BMFace *f = (BMFace *)mp_f;
+  double *plane_db = fplanes[BM_elem_index_get(f)];
+  float center[3];
+
+  BM_face_calc_center_median(f, center);
+  copy_v3db_v3fl(plane_db, f->no);
+  plane_db[3] = -dot_v3db_v3fl(plane_db, center);
+}
+
 /**
  * \param vquadrics: must be calloc'd
  */
@@ -84,20 +97,22 @@ static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
   BMIter iter;
   BMFace *f;
   BMEdge *e;
+  double(*fplanes)[4];
+  int i;
 
-  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+  /* Calculate the face planes in parallel, accumulating them into the vertex quadrics is done
+   * in the same order as before so the result doesn't depend on threading. */
+  BM_mesh_elem_index_ensure(bm, BM_FACE);
+  fplanes = MEM_mallocN(sizeof(*fplanes) * (size_t)bm->totface, __func__);
+  BM_iter_parallel(
+      bm, BM_FACES_OF_MESH, bm_decim_face_plane_cb, fplanes, bm->totface >= BM_OMP_LIMIT);
+
+  BM_ITER_MESH_INDEX (f, &iter, bm, BM_FACES_OF_MESH, i) {
     BMLoop *l_first;
     BMLoop *l_iter;
-
-    float center[3];
-    double plane_db[4];
     Quadric q;
 
-    BM_face_calc_center_median(f, center);
-    copy_v3db_v3fl(plane_db, f->no);
-    plane_db[3] = -dot_v3db_v3fl(plane_db, center);
-
-    BLI_quadric_from_plane(&q, plane_db);
+    BLI_quadric_from_plane(&q, fplanes[i]);
 
     l_iter = l_first = BM_FACE_FIRST_LOOP(f);
     do {
@@ -105,6 +120,8 @@ static void bm_decim_build_quadrics(BMesh *bm, Quadric *vquadrics)
     } while ((l_iter = l_iter->next) != l_first);
   }
 
+  MEM_freeN(fplanes);
+
   /* boundary edges */
   BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
     if (UNLIKELY(BM_edge_is_boundary(e))) {
@@ -237,12 +254,13 @@ static float bm_decim_build_edge_cost_single__topology(BMEdge *e)
 
 #endif /* USE_TOPOLOGY_FALLBACK */
 
-static void bm_decim_build_edge_cost_single(BMEdge *e,
-                                            const Quadric *vquadrics,
-                                            const float *vweights,
-                                            const float vweight_factor,
-                                            Heap *eheap,
-                                            HeapNode **eheap_table)
+/**
+ * \return the collapse cost of \a e or #COST_INVALID when it can't be collapsed.
+ */
+static float bm_decim_calc_edge_cost(BMEdge *e,
+                                     const Quadric *vquadrics,
+                                     const float *vweights,
+                                     const float vweight_factor)
 {
   float cost;
 
@@ -324,14 +342,30 @@ static void bm_decim_build_edge_cost_single(BMEdge *e,
     }
   }
 
-  BLI_heap_insert_or_update(eheap, &eheap_table[BM_elem_index_get(e)], cost, e);
-  return;
+  return cost;
 
 clear:
-  if (eheap_table[BM_elem_index_get(e)]) {
-    BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+  return COST_INVALID;
+}
+
+static void bm_decim_build_edge_cost_single(BMEdge *e,
+                                            const Quadric *vquadrics,
+                                            const float *vweights,
+                                            const float vweight_factor,
+                                            Heap *eheap,
+                                            HeapNode **eheap_table)
+{
+  const float cost = bm_decim_calc_edge_cost(e, vquadrics, vweights, vweight_factor);
+
+  if (cost != COST_INVALID) {
+    BLI_heap_insert_or_update(eheap, &eheap_table[BM_elem_index_get(e)], cost, e);
+  }
+  else {
+    if (eheap_table[BM_elem_index_get(e)]) {
+      BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+    }
+    eheap_table[BM_elem_index_get(e)] = NULL;
   }
-  eheap_table[BM_elem_index_get(e)] = NULL;
 }
 
 /* use this for degenerate cases - add back to the heap with an invalid cost,
@@ -342,6 +376,22 @@ static void bm_decim_invalid_edge_cost_single(BMEdge *e, Heap *eheap, HeapNode *
   eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, COST_INVALID, e);
 }
 
+typedef struct BuildEdgeCostData {
+  const Quadric *vquadrics;
+  const float *vweights;
+  float vweight_factor;
+  float *ecosts;
+} BuildEdgeCostData;
+
+static void bm_decim_build_edge_cost_cb(void *userdata, MempoolIterData *mp_e)
+{
+  BuildEdgeCostData *data = userdata;
+  BMEdge *e = (BMEdge *)mp_e;
+
+  data->ecosts[BM_elem_index_get(e)] = bm_decim_calc_edge_cost(
+      e, data->vquadrics, data->vweights, data->vweight_factor);
+}
+
 static void bm_decim_build_edge_cost(BMesh *bm,
                                      const Quadric *vquadrics,
                                      const float *vweights,
@@ -353,11 +403,31 @@ static void bm_decim_build_edge_cost(BMesh *bm,
   BMEdge *e;
   uint i;
 
+  /* The costs are calculated in parallel, the heap is filled in edge order
+   * so the collapse order doesn't depend on threading. */
+  BuildEdgeCostData data = {
+      .vquadrics = vquadrics,
+      .vweights = vweights,
+      .vweight_factor = vweight_factor,
+      .ecosts = MEM_mallocN(sizeof(float) * (size_t)bm->totedge, __func__),
+  };
+  BM_iter_parallel(
+      bm, BM_EDGES_OF_MESH, bm_decim_build_edge_cost_cb, &data, bm->totedge >= BM_OMP_LIMIT);
+
+  /* Edges which can't be collapsed are left out of the heap, as before threading this: the
+   * collapse loop stops at the first #COST_INVALID edge so they would never be taken. They can
+   * become valid when the faces or quadrics around them change, which only happens around a
+   * collapsed vertex: #bm_decim_edge_collapse evaluates the edges of the vertex and of its face
+   * fan again, inserting them into the heap then. */
   BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
     /* keep sanity check happy */
     eheap_table[i] = NULL;
-    bm_decim_build_edge_cost_single(e, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+    if (data.ecosts[i] != COST_INVALID) {
+      eheap_table[i] = BLI_heap_insert(eheap, data.ecosts[i], e);
+    }
   }
+
+  MEM_freeN(data.ecosts);
 }
 
 #ifdef USE_SYMMETRY
@@ -940,6 +940,80 @@ static int isect_bvhtree_point_v3(BVHTree *tree, const float **looptris, const f
   return num_isect;
 }
 
+struct OverlapData {
+  BMLoop *(*looptris)[3];
+  /* Distance beyond which #bm_isect_tri_tri can't find any contact. */
+  float eps_margin;
+};
+
+/**
+ * Check all corners of \a t_a are on the same side of the plane of \a t_b, further away than
+ * any of the tests in #bm_isect_tri_tri reach (including the float precision of those tests).
+ */
+static bool bm_isect_tri_tri_is_separated(const float *t_a[3],
+                                          const float *t_b[3],
+                                          const float eps_margin)
+{
+  double a[3], b[3], c[3], n[3];
+  double scale = 0.0;
+
+  for (uint i = 0; i < 3; i++) {
+    for (uint j = 0; j < 3; j++) {
+      scale = max_dd(scale, fabs((double)t_a[i][j]));
+      scale = max_dd(scale, fabs((double)t_b[i][j]));
+    }
+  }
+
+  copy_v3db_v3fl(a, t_b[0]);
+  copy_v3db_v3fl(b, t_b[1]);
+  copy_v3db_v3fl(c, t_b[2]);
+  sub_v3_v3v3_db(b, b, a);
+  sub_v3_v3v3_db(c, c, a);
+  cross_v3_v3v3_db(n, b, c);
+  if (normalize_v3_d(n) == 0.0) {
+    return false;
+  }
+
+  const double margin = (double)eps_margin * 2.0 + scale * (double)FLT_EPSILON * 16.0;
+  int side = 0;
+  for (uint i = 0; i < 3; i++) {
+    double co[3];
+    copy_v3db_v3fl(co, t_a[i]);
+    sub_v3_v3v3_db(co, co, a);
+    const double d = dot_v3v3_db(co, n);
+    const int side_test = (d > margin) ? 1 : ((d < -margin) ? -1 : 0);
+    if ((side_test == 0) || (side != 0 && side != side_test)) {
+      return false;
+    }
+    side = side_test;
+  }
+  return true;
+}
+
+/**
+ * Runs on the (threaded) BVH overlap, culling pairs #bm_isect_tri_tri would skip anyway,
+ * so only the pairs which may touch are handled by the serial intersection loop.
+ */
+static bool bm_isect_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+  const struct OverlapData *data = userdata;
+  BMLoop **a = data->looptris[index_a];
+  BMLoop **b = data->looptris[index_b];
+  const BMVert *fv_a[3] = {UNPACK3_EX(, a, ->v)};
+  const BMVert *fv_b[3] = {UNPACK3_EX(, b, ->v)};
+
+  /* Triangles sharing a vertex are skipped. */
+  if (ELEM(fv_a[0], UNPACK3(fv_b)) || ELEM(fv_a[1], UNPACK3(fv_b)) ||
+      ELEM(fv_a[2], UNPACK3(fv_b))) {
+    return false;
+  }
+
+  const float *f_a_cos[3] = {UNPACK3_EX(, fv_a, ->co)};
+  const float *f_b_cos[3] = {UNPACK3_EX(, fv_b, ->co)};
+  return !(bm_isect_tri_tri_is_separated(f_a_cos, f_b_cos, data->eps_margin) ||
+           bm_isect_tri_tri_is_separated(f_b_cos, f_a_cos, data->eps_margin));
+}
+
 #endif /* USE_BVH */
 
 /**
@@ -1090,7 +1164,9 @@ bool BM_mesh_intersect(BMesh *bm,
     flag &= ~BVH_OVERLAP_USE_THREADING;
   }
 #  endif
-  overlap = BLI_bvhtree_overlap_ex(tree_b, tree_a, &tree_overlap_tot, NULL, NULL, 0, flag);
+  struct OverlapData overlap_data = {looptris, s.epsilon.eps_margin};
+  overlap = BLI_bvhtree_overlap_ex(
+      tree_b, tree_a, &tree_overlap_tot, bm_isect_overlap_cb, &overlap_data, 0, flag);
 
   if (overlap) {
     uint i;
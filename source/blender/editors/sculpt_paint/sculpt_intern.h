@@ -492,6 +492,9 @@ typedef struct SculptUndoNode {
   /* Sculpt Face Sets */
   int *face_sets;
 
+  /* Replaces co, mask or face_sets once the push is done, see #sculpt_undo_compact_nodes. */
+  struct SculptUndoDelta *delta;
+
   size_t undo_size;
 } SculptUndoNode;
 
@@ -26,6 +26,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "CLG_log.h"
+
+#include "BLI_bitmap.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
@@ -69,6 +72,7 @@
 
 #include "bmesh.h"
 #include "sculpt_intern.h"
+#include "sculpt_undo_delta.h"
 
 /* Implementation of undo system for objects in sculpt mode.
  *
@@ -107,16 +111,319 @@
  * does modifications on it.
  *
  * End of dynamic topology and symmetrize in this mode are handled in a special
- * manner as well. */
+ * manner as well.
+ *
+ * Once the push is done the arrays of COORDS, MASK and FACE_SETS nodes are replaced
+ * by a compressed delta against the current mesh, see #sculpt_undo_compact_nodes. */
+
+static CLG_LogRef LOG = {"ed.sculpt.undo"};
 
 typedef struct UndoSculpt {
   ListBase nodes;
 
   size_t undo_size;
+  /* Size of the nodes before they got compacted. */
+  size_t undo_size_uncompacted;
+
+  /* Object the nodes are pushed for, only valid during push. */
+  Object *ob;
 } UndoSculpt;
 
 static UndoSculpt *sculpt_undo_get_nodes(void);
 
+/* -------------------------------------------------------------------- */
+/** \name Undo Deltas
+ *
+ * See #SculptUndoDelta for how the values are stored.
+ * \{ */
+
+typedef enum eSculptUndoDeltaOp {
+  /* Keep the stored values which differ from the mesh. */
+  SCULPT_UNDO_DELTA_ENCODE,
+  /* Swap the kept values with the mesh. */
+  SCULPT_UNDO_DELTA_SWAP,
+  /* Fill a full array from the mesh and the kept values. */
+  SCULPT_UNDO_DELTA_EXPAND,
+} eSculptUndoDeltaOp;
+
+BLI_INLINE void sculpt_undo_delta_elem(SculptUndoDelta *delta,
+                                       const eSculptUndoDeltaOp op,
+                                       const int elem,
+                                       int *value,
+                                       uint *mesh,
+                                       uint *r_words,
+                                       MVert *mvert)
+{
+  switch (op) {
+    case SCULPT_UNDO_DELTA_ENCODE:
+      SCULPT_undo_delta_add(delta, elem, mesh);
+      break;
+    case SCULPT_UNDO_DELTA_SWAP:
+      if (SCULPT_undo_delta_swap(delta, elem, value, mesh) && mvert) {
+        mvert->flag |= ME_VERT_PBVH_UPDATE;
+      }
+      break;
+    case SCULPT_UNDO_DELTA_EXPAND: {
+      uint *words = &r_words[elem * delta->elem_len];
+      memcpy(words, mesh, sizeof(uint) * (size_t)delta->elem_len);
+      SCULPT_undo_delta_swap(delta, elem, value, words);
+      break;
+    }
+  }
+}
+
+/**
+ * Run \a op on the delta of a COORDS, MASK or FACE_SETS node, against the matching values of the
+ * mesh. The node is expected to match the mesh, as checked before restoring it.
+ * \param r_words: The full array of values, only used for #SCULPT_UNDO_DELTA_EXPAND.
+ */
+static void sculpt_undo_node_delta(Object *ob,
+                                   SculptUndoNode *unode,
+                                   const eSculptUndoDeltaOp op,
+                                   uint *r_words)
+{
+  SculptSession *ss = ob->sculpt;
+  SubdivCCG *subdiv_ccg = ss->subdiv_ccg;
+  SculptUndoDelta *delta = unode->delta;
+  int elem = 0, value = 0;
+
+  if (unode->type == SCULPT_UNDO_FACE_SETS) {
+    Mesh *me = BKE_object_get_original_mesh(ob);
+    uint *face_sets = CustomData_get_layer(&me->pdata, CD_SCULPT_FACE_SETS);
+    for (int i = 0; i < me->totpoly; i++) {
+      sculpt_undo_delta_elem(delta, op, elem++, &value, &face_sets[i], r_words, NULL);
+    }
+  }
+  else if (unode->maxvert) {
+    const int *index = unode->index;
+    MVert *mvert = ss->mvert;
+
+    for (int i = 0; i < unode->totvert; i++) {
+      MVert *v = &mvert[index[i]];
+      uint *mesh = (unode->type == SCULPT_UNDO_COORDS) ? (uint *)v->co :
+                                                         (uint *)&ss->vmask[index[i]];
+      sculpt_undo_delta_elem(delta, op, elem++, &value, mesh, r_words, v);
+    }
+  }
+  else if (unode->maxgrid && subdiv_ccg != NULL) {
+    CCGElem **grids = subdiv_ccg->grids;
+    const int gridsize = subdiv_ccg->grid_size;
+    CCGKey key;
+    BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
+
+    for (int j = 0; j < unode->totgrid; j++) {
+      CCGElem *grid = grids[unode->grids[j]];
+
+      for (int i = 0; i < gridsize * gridsize; i++) {
+        uint *mesh = (unode->type == SCULPT_UNDO_COORDS) ?
+                         (uint *)CCG_elem_offset_co(&key, grid, i) :
+                         (uint *)CCG_elem_offset_mask(&key, grid, i);
+        sculpt_undo_delta_elem(delta, op, elem++, &value, mesh, r_words, NULL);
+      }
+    }
+  }
+
+  if (op == SCULPT_UNDO_DELTA_ENCODE) {
+    SCULPT_undo_delta_finish(delta);
+  }
+}
+
+/**
+ * Replace the delta of a node by a full copy of its values, for restoring it against other data
+ * than the mesh arrays the delta was made for.
+ */
+static void sculpt_undo_node_delta_expand(Object *ob, SculptUndoNode *unode)
+{
+  SculptUndoDelta *delta = unode->delta;
+  uint *words = MEM_mapallocN(sizeof(*words) * (size_t)(delta->elem_num * delta->elem_len),
+                              __func__);
+
+  sculpt_undo_node_delta(ob, unode, SCULPT_UNDO_DELTA_EXPAND, words);
+
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      unode->co = (float(*)[3])words;
+      break;
+    case SCULPT_UNDO_MASK:
+      unode->mask = (float *)words;
+      break;
+    case SCULPT_UNDO_FACE_SETS:
+      unode->face_sets = (int *)words;
+      break;
+    default:
+      BLI_assert(0);
+      MEM_freeN(words);
+      break;
+  }
+
+  SCULPT_undo_delta_free(delta);
+  unode->delta = NULL;
+}
+
+/* Node values which are replaced by a delta, NULL when the node can't be compacted. */
+static uint *sculpt_undo_node_compact_words(Object *ob, SculptUndoNode *unode, int *r_words_num)
+{
+  SculptSession *ss = ob->sculpt;
+  SubdivCCG *subdiv_ccg = ss->subdiv_ccg;
+  int elem_num;
+
+  if (unode->type == SCULPT_UNDO_FACE_SETS) {
+    Mesh *me = BKE_object_get_original_mesh(ob);
+    if (unode->face_sets == NULL || !CustomData_has_layer(&me->pdata, CD_SCULPT_FACE_SETS)) {
+      return NULL;
+    }
+    *r_words_num = me->totpoly;
+    return (uint *)unode->face_sets;
+  }
+
+  if (unode->maxvert) {
+    /* Shape keys and deform modifiers restore from other coordinates than the ones in the mesh,
+     * the mask is only compared against the mask layer. */
+    if ((ss->totvert != unode->maxvert) || ss->shapekey_active || unode->orig_co ||
+        (unode->type == SCULPT_UNDO_MASK && ss->vmask == NULL)) {
+      return NULL;
+    }
+    elem_num = unode->totvert;
+  }
+  else if (unode->maxgrid && subdiv_ccg != NULL) {
+    if ((subdiv_ccg->num_grids != unode->maxgrid) || (subdiv_ccg->grid_size != unode->gridsize)) {
+      return NULL;
+    }
+    elem_num = unode->totgrid * unode->gridsize * unode->gridsize;
+  }
+  else {
+    return NULL;
+  }
+
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      *r_words_num = elem_num * 3;
+      return (uint *)unode->co;
+    case SCULPT_UNDO_MASK:
+      *r_words_num = elem_num;
+      return (uint *)unode->mask;
+    default:
+      return NULL;
+  }
+}
+
+typedef struct SculptUndoCompactData {
+  Object *ob;
+  SculptUndoNode **nodes;
+} SculptUndoCompactData;
+
+static void sculpt_undo_compact_node_task_cb(void *__restrict userdata,
+                                             const int n,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoCompactData *data = userdata;
+  SculptUndoNode *unode = data->nodes[n];
+  int words_num;
+  uint *words = sculpt_undo_node_compact_words(data->ob, unode, &words_num);
+  const int elem_len = (unode->type == SCULPT_UNDO_COORDS) ? 3 : 1;
+
+  unode->delta = SCULPT_undo_delta_new(words, words_num / elem_len, elem_len);
+  sculpt_undo_node_delta(data->ob, unode, SCULPT_UNDO_DELTA_ENCODE, NULL);
+
+  unode->co = NULL;
+  unode->mask = NULL;
+  unode->face_sets = NULL;
+  /* Data used during the stroke is gone, make sure it isn't found anymore. */
+  unode->node = NULL;
+}
+
+static void sculpt_undo_restore_delta_task_cb(void *__restrict userdata,
+                                              const int n,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoCompactData *data = userdata;
+  sculpt_undo_node_delta(data->ob, data->nodes[n], SCULPT_UNDO_DELTA_SWAP, NULL);
+}
+
+static size_t sculpt_undo_node_size(const SculptUndoNode *unode)
+{
+  const void *arrays[] = {
+      unode->co,
+      unode->orig_co,
+      unode->no,
+      unode->mask,
+      unode->index,
+      unode->vert_hidden,
+      unode->grids,
+      unode->face_sets,
+  };
+  size_t size = sizeof(*unode);
+
+  for (int i = 0; i < ARRAY_SIZE(arrays); i++) {
+    if (arrays[i]) {
+      size += MEM_allocN_len(arrays[i]);
+    }
+  }
+  if (unode->delta) {
+    size += SCULPT_undo_delta_size(unode->delta);
+  }
+  return size;
+}
+
+static size_t sculpt_undo_nodes_size(const ListBase *lb)
+{
+  size_t size = 0;
+  LISTBASE_FOREACH (const SculptUndoNode *, unode, lb) {
+    size += sculpt_undo_node_size(unode);
+  }
+  return size;
+}
+
+/**
+ * Replace the stored arrays of the nodes by their delta against the mesh, in parallel.
+ * Has to run once the push is done, since the delta is against the state after the stroke.
+ */
+static void sculpt_undo_compact_nodes(UndoSculpt *usculpt)
+{
+  Object *ob = usculpt->ob;
+  SculptUndoNode **nodes;
+  int totnode = 0;
+
+  usculpt->ob = NULL;
+  usculpt->undo_size_uncompacted = sculpt_undo_nodes_size(&usculpt->nodes);
+  usculpt->undo_size = usculpt->undo_size_uncompacted;
+
+  if (ob == NULL || ob->sculpt == NULL || ob->sculpt->bm) {
+    return;
+  }
+
+  LISTBASE_FOREACH (SculptUndoNode *, unode, &usculpt->nodes) {
+    /* Geometry changes the mesh the other nodes are stored against. */
+    if (unode->type == SCULPT_UNDO_GEOMETRY || unode->bm_entry) {
+      return;
+    }
+  }
+
+  nodes = MEM_mallocN(sizeof(*nodes) * (size_t)BLI_listbase_count(&usculpt->nodes), __func__);
+  LISTBASE_FOREACH (SculptUndoNode *, unode, &usculpt->nodes) {
+    int words_num;
+    if (STREQ(unode->idname, ob->id.name) &&
+        sculpt_undo_node_compact_words(ob, unode, &words_num)) {
+      nodes[totnode++] = unode;
+    }
+  }
+
+  SculptUndoCompactData data = {
+      .ob = ob,
+      .nodes = nodes,
+  };
+
+  PBVHParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
+  BKE_pbvh_parallel_range(0, totnode, &data, sculpt_undo_compact_node_task_cb, &settings);
+
+  MEM_freeN(nodes);
+
+  usculpt->undo_size = sculpt_undo_nodes_size(&usculpt->nodes);
+}
+
+/** \} */
+
 static void update_cb(PBVHNode *node, void *rebuild)
 {
   BKE_pbvh_node_mark_update(node);
@@ -380,6 +687,16 @@ static bool sculpt_undo_restore_face_sets(bContext *C, SculptUndoNode *unode)
   Object *ob = OBACT(view_layer);
   Mesh *me = BKE_object_get_original_mesh(ob);
   int *face_sets = CustomData_get_layer(&me->pdata, CD_SCULPT_FACE_SETS);
+  if (unode->delta) {
+    if (face_sets && (unode->delta->elem_num == me->totpoly)) {
+      SculptUndoCompactData data = {
+          .ob = ob,
+          .nodes = &unode,
+      };
+      sculpt_undo_restore_delta_task_cb(&data, 0, NULL);
+    }
+    return false;
+  }
   for (int i = 0; i < me->totpoly; i++) {
     face_sets[i] = unode->face_sets[i];
   }
@@ -670,6 +987,10 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
   char *undo_modified_grids = NULL;
   bool use_multires_undo = false;
 
+  /* Compacted nodes are restored in parallel after the others. */
+  SculptUndoNode **delta_nodes = NULL;
+  int delta_totnode = 0;
+
   for (unode = lb->first; unode; unode = unode->next) {
 
     if (!STREQ(unode->idname, ob->id.name)) {
@@ -692,6 +1013,29 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
       use_multires_undo = true;
     }
 
+    if (unode->delta && unode->maxvert && ss->shapekey_active) {
+      /* Deltas are made against the mesh without shape keys, restore a full copy instead. */
+      sculpt_undo_node_delta_expand(ob, unode);
+    }
+
+    if (unode->delta) {
+      if ((unode->maxgrid && subdiv_ccg == NULL) ||
+          (unode->type == SCULPT_UNDO_MASK && unode->maxvert && ss->vmask == NULL)) {
+        continue;
+      }
+      if (delta_nodes == NULL) {
+        delta_nodes = MEM_mallocN(sizeof(*delta_nodes) * (size_t)BLI_listbase_count(lb),
+                                  __func__);
+      }
+      delta_nodes[delta_totnode++] = unode;
+
+      update = true;
+      if (unode->type == SCULPT_UNDO_MASK) {
+        update_mask = true;
+      }
+      continue;
+    }
+
     switch (unode->type) {
       case SCULPT_UNDO_COORDS:
         if (sculpt_undo_restore_coords(C, depsgraph, unode)) {
@@ -726,6 +1070,21 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
     }
   }
 
+  if (delta_nodes) {
+    Sculpt *sd = CTX_data_tool_settings(C)->sculpt;
+    SculptUndoCompactData data = {
+        .ob = ob,
+        .nodes = delta_nodes,
+    };
+
+    PBVHParallelSettings settings;
+    BKE_pbvh_parallel_range_settings(&settings, (sd->flags & SCULPT_USE_OPENMP), delta_totnode);
+    BKE_pbvh_parallel_range(
+        0, delta_totnode, &data, sculpt_undo_restore_delta_task_cb, &settings);
+
+    MEM_freeN(delta_nodes);
+  }
+
   if (use_multires_undo) {
     for (unode = lb->first; unode; unode = unode->next) {
       if (!STREQ(unode->idname, ob->id.name)) {
@@ -851,6 +1210,9 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->face_sets) {
       MEM_freeN(unode->face_sets);
     }
+    if (unode->delta) {
+      SCULPT_undo_delta_free(unode->delta);
+    }
 
     MEM_freeN(unode);
 
@@ -946,7 +1308,6 @@ static SculptUndoNode *sculpt_undo_find_or_alloc_node_type(Object *object, Sculp
 
 static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, SculptUndoType type)
 {
-  UndoSculpt *usculpt = sculpt_undo_get_nodes();
   SculptSession *ss = ob->sculpt;
   int totvert, allvert, totgrid, maxgrid, gridsize, *grids;
 
@@ -970,8 +1331,6 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
     case SCULPT_UNDO_COORDS:
       unode->co = MEM_mapallocN(sizeof(float[3]) * allvert, "SculptUndoNode.co");
       unode->no = MEM_mapallocN(sizeof(short[3]) * allvert, "SculptUndoNode.no");
-
-      usculpt->undo_size = (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
       break;
     case SCULPT_UNDO_HIDDEN:
       if (maxgrid) {
@@ -984,9 +1343,6 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
       break;
     case SCULPT_UNDO_MASK:
       unode->mask = MEM_mapallocN(sizeof(float) * allvert, "SculptUndoNode.mask");
-
-      usculpt->undo_size += (sizeof(float) * sizeof(int)) * allvert;
-
       break;
     case SCULPT_UNDO_DYNTOPO_BEGIN:
     case SCULPT_UNDO_DYNTOPO_END:
@@ -1209,6 +1565,7 @@ SculptUndoNode *SCULPT_undo_push_node(Object *ob, PBVHNode *node, SculptUndoType
   BLI_thread_lock(LOCK_CUSTOM1);
 
   ss->needs_flush_to_id = 1;
+  sculpt_undo_get_nodes()->ob = ob;
 
   if (ss->bm || ELEM(type, SCULPT_UNDO_DYNTOPO_BEGIN, SCULPT_UNDO_DYNTOPO_END)) {
     /* Dynamic topology stores only one undo node per stroke,
@@ -1316,6 +1673,8 @@ void SCULPT_undo_push_end_ex(const bool use_nested_undo)
     }
   }
 
+  sculpt_undo_compact_nodes(usculpt);
+
   /* We could remove this and enforce all callers run in an operator using 'OPTYPE_UNDO'. */
   wmWindowManager *wm = G_MAIN->wm.first;
   if (wm->op_undo_depth == 0 || use_nested_undo) {
@@ -1351,6 +1710,14 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
   SculptUndoStep *us = (SculptUndoStep *)us_p;
   us->step.data_size = us->data.undo_size;
 
+  CLOG_INFO(&LOG,
+            1,
+            "name='%s', nodes=%d, size=%zu KiB (%zu KiB uncompacted)",
+            us->step.name,
+            BLI_listbase_count(&us->data.nodes),
+            us->data.undo_size / 1024,
+            us->data.undo_size_uncompacted / 1024);
+
   SculptUndoNode *unode = us->data.nodes.last;
   if (unode && unode->type == SCULPT_UNDO_DYNTOPO_END) {
     us->step.use_memfile_step = true;
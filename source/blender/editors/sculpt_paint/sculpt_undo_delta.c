@@ -0,0 +1,115 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup edsculpt
+ *
+ * Once a sculpt undo push is done, the values stored in a node are compared with the matching
+ * values of the mesh. Only the values of the elements the stroke changed are kept, along with a
+ * bit per element telling which ones changed. Restoring swaps the kept values with the ones of
+ * the mesh, so the same delta is used for both undo and redo. Elements which didn't change are
+ * left as they are, so the mesh doesn't have to be bit-identical to the state after the stroke.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_bitmap.h"
+#include "BLI_utildefines.h"
+
+#include "sculpt_undo_delta.h" /* own include */
+
+/**
+ * Start a delta from the stored \a values of \a elem_num elements, the delta takes ownership
+ * of the array. Elements have to be added in order with #SCULPT_undo_delta_add.
+ */
+SculptUndoDelta *SCULPT_undo_delta_new(uint *values, int elem_num, int elem_len)
+{
+  SculptUndoDelta *delta = MEM_callocN(sizeof(*delta), __func__);
+  delta->elem_num = elem_num;
+  delta->elem_len = elem_len;
+  delta->changed = BLI_BITMAP_NEW(elem_num, "SculptUndoDelta.changed");
+  delta->values = values;
+  return delta;
+}
+
+/**
+ * Compare the stored value of \a elem with the value in the \a mesh, only keep it when it
+ * differs. Values are moved to the start of the array, which is shrunk by
+ * #SCULPT_undo_delta_finish.
+ */
+bool SCULPT_undo_delta_add(SculptUndoDelta *delta, int elem, const uint *mesh)
+{
+  const int len = delta->elem_len;
+  const uint *value = &delta->values[elem * len];
+
+  BLI_assert(elem >= delta->changed_num);
+
+  if (memcmp(value, mesh, sizeof(uint) * (size_t)len) == 0) {
+    return false;
+  }
+
+  BLI_BITMAP_ENABLE(delta->changed, elem);
+  memmove(&delta->values[delta->changed_num * len], value, sizeof(uint) * (size_t)len);
+  delta->changed_num++;
+  return true;
+}
+
+void SCULPT_undo_delta_finish(SculptUndoDelta *delta)
+{
+  if (delta->changed_num == 0) {
+    MEM_SAFE_FREE(delta->values);
+  }
+  else {
+    delta->values = MEM_reallocN(delta->values,
+                                 sizeof(uint) * (size_t)(delta->changed_num * delta->elem_len));
+  }
+}
+
+/**
+ * Swap the kept value of \a elem with the value in the \a mesh, if it changed.
+ * \param r_value: Index of the next kept value, start at zero and visit elements in order.
+ */
+bool SCULPT_undo_delta_swap(SculptUndoDelta *delta, int elem, int *r_value, uint *mesh)
+{
+  if (!BLI_BITMAP_TEST(delta->changed, elem)) {
+    return false;
+  }
+
+  const int len = delta->elem_len;
+  uint *value = &delta->values[(*r_value)++ * len];
+  for (int i = 0; i < len; i++) {
+    SWAP(uint, value[i], mesh[i]);
+  }
+  return true;
+}
+
+size_t SCULPT_undo_delta_size(const SculptUndoDelta *delta)
+{
+  return sizeof(*delta) + BLI_BITMAP_SIZE(delta->elem_num) +
+         sizeof(uint) * (size_t)(delta->changed_num * delta->elem_len);
+}
+
+void SCULPT_undo_delta_free(SculptUndoDelta *delta)
+{
+  MEM_freeN(delta->changed);
+  MEM_SAFE_FREE(delta->values);
+  MEM_freeN(delta);
+}
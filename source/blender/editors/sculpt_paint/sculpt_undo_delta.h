@@ -0,0 +1,60 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup edsculpt
+ *
+ * Values of the elements a sculpt stroke changed, see sculpt_undo_delta.c.
+ */
+
+#ifndef __SCULPT_UNDO_DELTA_H__
+#define __SCULPT_UNDO_DELTA_H__
+
+#include "BLI_bitmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SculptUndoDelta {
+  int elem_num;
+  /* Words per element. */
+  int elem_len;
+  /* Bit per element, set for the ones which changed. */
+  BLI_bitmap *changed;
+  int changed_num;
+  /* Values of the changed elements, in element order. */
+  unsigned int *values;
+} SculptUndoDelta;
+
+struct SculptUndoDelta *SCULPT_undo_delta_new(unsigned int *values, int elem_num, int elem_len);
+bool SCULPT_undo_delta_add(struct SculptUndoDelta *delta, int elem, const unsigned int *mesh);
+void SCULPT_undo_delta_finish(struct SculptUndoDelta *delta);
+bool SCULPT_undo_delta_swap(struct SculptUndoDelta *delta,
+                            int elem,
+                            int *r_value,
+                            unsigned int *mesh);
+size_t SCULPT_undo_delta_size(const struct SculptUndoDelta *delta);
+void SCULPT_undo_delta_free(struct SculptUndoDelta *delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCULPT_UNDO_DELTA_H__ */
@@ -51,6 +51,9 @@
 
 /********************** Track operator *********************/
 
+/* Number of frames tracked at once when tracking as fast as possible. */
+#define TRACK_MARKERS_FRAMES_PER_STEP 8
+
 typedef struct TrackMarkersJob {
   struct AutoTrackContext *context; /* Tracking context */
   int sfra, efra, lastfra;          /* Start, end and recently tracked frames */
@@ -220,6 +223,8 @@ static void track_markers_startjob(void *tmv, short *stop, short *do_update, flo
   int framenr = tmj->sfra;
 
   while (framenr != tmj->efra) {
+    int num_frames = 1;
+
     if (tmj->delay > 0) {
       /* Tracking should happen with fixed fps. Calculate time
        * using current timer value before tracking frame and after.
@@ -239,18 +244,24 @@ static void track_markers_startjob(void *tmv, short *stop, short *do_update, flo
         PIL_sleep_ms(tmj->delay - (float)exec_time);
       }
     }
-    else if (!BKE_autotrack_context_step(tmj->context)) {
-      break;
+    else {
+      num_frames = min_ii(TRACK_MARKERS_FRAMES_PER_STEP, abs(tmj->efra - framenr));
+      const int num_tracked_frames = BKE_autotrack_context_step_frames(tmj->context, num_frames);
+      if (num_tracked_frames != num_frames) {
+        tmj->lastfra = tmj->backwards ? framenr - num_tracked_frames :
+                                        framenr + num_tracked_frames;
+        break;
+      }
     }
 
     *do_update = true;
     *progress = (float)(framenr - tmj->sfra) / (tmj->efra - tmj->sfra);
 
     if (tmj->backwards) {
-      framenr--;
+      framenr -= num_frames;
     }
     else {
-      framenr++;
+      framenr += num_frames;
     }
 
     tmj->lastfra = framenr;
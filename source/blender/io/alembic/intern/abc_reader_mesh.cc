@@ -395,11 +395,10 @@ static void get_weight_and_index(CDStreamConfig &config,
 static void read_mesh_sample(const std::string &iobject_full_name,
                              ImportSettings *settings,
                              const IPolyMeshSchema &schema,
+                             const IPolyMeshSchema::Sample &sample,
                              const ISampleSelector &selector,
                              CDStreamConfig &config)
 {
-  const IPolyMeshSchema::Sample sample = schema.getValue(selector);
-
   AbcMeshData abc_mesh_data;
   abc_mesh_data.face_counts = sample.getFaceCounts();
   abc_mesh_data.face_indices = sample.getFaceIndices();
@@ -408,9 +407,9 @@ static void read_mesh_sample(const std::string &iobject_full_name,
   get_weight_and_index(config, schema.getTimeSampling(), schema.getNumSamples());
 
   if (config.weight != 0.0f) {
-    Alembic::AbcGeom::IPolyMeshSchema::Sample ceil_sample;
-    schema.get(ceil_sample, Alembic::Abc::ISampleSelector(config.ceil_index));
-    abc_mesh_data.ceil_positions = ceil_sample.getPositions();
+    /* Only the positions are interpolated, don't read the rest of the ceil sample. */
+    schema.getPositionsProperty().get(abc_mesh_data.ceil_positions,
+                                      Alembic::Abc::ISampleSelector(config.ceil_index));
   }
 
   if ((settings->read_flag & MOD_MESHSEQ_READ_UV) != 0) {
@@ -514,11 +513,23 @@ bool AbcMeshReader::accepts_object_type(
   return true;
 }
 
+static bool mesh_topology_changed(const Mesh *existing_mesh,
+                                  const size_t positions_num,
+                                  const size_t face_counts_num,
+                                  const size_t face_indices_num)
+{
+  return positions_num != existing_mesh->totvert || face_counts_num != existing_mesh->totpoly ||
+         face_indices_num != existing_mesh->totloop;
+}
+
 bool AbcMeshReader::topology_changed(Mesh *existing_mesh, const ISampleSelector &sample_sel)
 {
-  IPolyMeshSchema::Sample sample;
+  /* Only the array sizes are needed, these are read without reading the arrays themselves. */
+  Alembic::Util::Dimensions positions_dims, face_counts_dims, face_indices_dims;
   try {
-    sample = m_schema.getValue(sample_sel);
+    m_schema.getPositionsProperty().getDimensions(positions_dims, sample_sel);
+    m_schema.getFaceCountsProperty().getDimensions(face_counts_dims, sample_sel);
+    m_schema.getFaceIndicesProperty().getDimensions(face_indices_dims, sample_sel);
   }
   catch (Alembic::Util::Exception &ex) {
     printf("Alembic: error reading mesh sample for '%s/%s' at time %f: %s\n",
@@ -530,13 +541,10 @@ bool AbcMeshReader::topology_changed(Mesh *existing_mesh, const ISampleSelector
     return false;
   }
 
-  const P3fArraySamplePtr &positions = sample.getPositions();
-  const Alembic::Abc::Int32ArraySamplePtr &face_indices = sample.getFaceIndices();
-  const Alembic::Abc::Int32ArraySamplePtr &face_counts = sample.getFaceCounts();
-
-  return positions->size() != existing_mesh->totvert ||
-         face_counts->size() != existing_mesh->totpoly ||
-         face_indices->size() != existing_mesh->totloop;
+  return mesh_topology_changed(existing_mesh,
+                               positions_dims.numPoints(),
+                               face_counts_dims.numPoints(),
+                               face_indices_dims.numPoints());
 }
 
 Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
@@ -585,7 +593,8 @@ Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
   ImportSettings settings;
   settings.read_flag |= read_flag;
 
-  if (topology_changed(existing_mesh, sample_sel)) {
+  if (mesh_topology_changed(
+          existing_mesh, positions->size(), face_counts->size(), face_indices->size())) {
     new_mesh = BKE_mesh_new_nomain_from_template(
         existing_mesh, positions->size(), 0, 0, face_indices->size(), face_counts->size());
 
@@ -610,7 +619,7 @@ Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
   CDStreamConfig config = get_config(new_mesh ? new_mesh : existing_mesh);
   config.time = sample_sel.getRequestedTime();
 
-  read_mesh_sample(m_iobject.getFullName(), &settings, m_schema, sample_sel, config);
+  read_mesh_sample(m_iobject.getFullName(), &settings, m_schema, sample, sample_sel, config);
 
   if (new_mesh) {
     /* Here we assume that the number of materials doesn't change, i.e. that
@@ -702,11 +711,10 @@ ABC_INLINE MEdge *find_edge(MEdge *edges, int totedge, int v1, int v2)
 static void read_subd_sample(const std::string &iobject_full_name,
                              ImportSettings *settings,
                              const ISubDSchema &schema,
+                             const ISubDSchema::Sample &sample,
                              const ISampleSelector &selector,
                              CDStreamConfig &config)
 {
-  const ISubDSchema::Sample sample = schema.getValue(selector);
-
   AbcMeshData abc_mesh_data;
   abc_mesh_data.face_counts = sample.getFaceCounts();
   abc_mesh_data.face_indices = sample.getFaceIndices();
@@ -715,9 +723,9 @@ static void read_subd_sample(const std::string &iobject_full_name,
   get_weight_and_index(config, schema.getTimeSampling(), schema.getNumSamples());
 
   if (config.weight != 0.0f) {
-    Alembic::AbcGeom::ISubDSchema::Sample ceil_sample;
-    schema.get(ceil_sample, Alembic::Abc::ISampleSelector(config.ceil_index));
-    abc_mesh_data.ceil_positions = ceil_sample.getPositions();
+    /* Only the positions are interpolated, don't read the rest of the ceil sample. */
+    schema.getPositionsProperty().get(abc_mesh_data.ceil_positions,
+                                      Alembic::Abc::ISampleSelector(config.ceil_index));
   }
 
   if ((settings->read_flag & MOD_MESHSEQ_READ_UV) != 0) {
@@ -898,7 +906,7 @@ Mesh *AbcSubDReader::read_mesh(Mesh *existing_mesh,
   /* Only read point data when streaming meshes, unless we need to create new ones. */
   CDStreamConfig config = get_config(new_mesh ? new_mesh : existing_mesh);
   config.time = sample_sel.getRequestedTime();
-  read_subd_sample(m_iobject.getFullName(), &settings, m_schema, sample_sel, config);
+  read_subd_sample(m_iobject.getFullName(), &settings, m_schema, sample, sample_sel, config);
 
   return config.mesh;
 }
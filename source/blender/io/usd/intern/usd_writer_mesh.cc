@@ -26,6 +26,7 @@
 extern "C" {
 #include "BLI_assert.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
 #include "BKE_lib_id.h"
@@ -128,6 +129,35 @@ struct USDMeshData {
   pxr::VtFloatArray crease_sharpnesses;
 };
 
+/* Offset of the first face-vertex of each polygon in the face-vertex arrays, which store the
+ * face-vertices in polygon order. Returns the total number of face-vertices. */
+static int get_poly_offsets(const Mesh *mesh, std::vector<int> &r_poly_offsets)
+{
+  r_poly_offsets.resize(mesh->totpoly);
+
+  int offset = 0;
+  const MPoly *mpoly = mesh->mpoly;
+  for (int i = 0; i < mesh->totpoly; ++i, ++mpoly) {
+    r_poly_offsets[i] = offset;
+    offset += mpoly->totloop;
+  }
+  return offset;
+}
+
+static void get_face_groups(const Mesh *mesh, USDMeshData &usd_mesh_data)
+{
+  /* Only construct face groups (a.k.a. geometry subsets) when we need them for material
+   * assignments. */
+  if (mesh->totcol <= 1) {
+    return;
+  }
+
+  const MPoly *mpoly = mesh->mpoly;
+  for (int i = 0; i < mesh->totpoly; ++i, ++mpoly) {
+    usd_mesh_data.face_groups[mpoly->mat_nr].push_back(i);
+  }
+}
+
 void USDGenericMeshWriter::write_uv_maps(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
@@ -170,7 +200,6 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context, Mesh *mesh)
 
   pxr::UsdGeomMesh usd_mesh = pxr::UsdGeomMesh::Define(stage, usd_path);
   USDMeshData usd_mesh_data;
-  get_geometry_data(mesh, usd_mesh_data);
 
   if (usd_export_context_.export_params.use_instancing && context.is_instance()) {
     // This object data is instanced, just reference the original instead of writing a copy.
@@ -194,11 +223,15 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context, Mesh *mesh)
     of its own subtree. It does work when we override the material with exactly the same path,
     though.*/
     if (usd_export_context_.export_params.export_materials) {
+      /* Only the face groups are needed, the geometry itself is referenced. */
+      get_face_groups(mesh, usd_mesh_data);
       assign_materials(context, usd_mesh, usd_mesh_data.face_groups);
     }
     return;
   }
 
+  get_geometry_data(mesh, usd_mesh_data);
+
   pxr::UsdAttribute attr_points = usd_mesh.CreatePointsAttr(pxr::VtValue(), true);
   pxr::UsdAttribute attr_face_vertex_counts = usd_mesh.CreateFaceVertexCountsAttr(pxr::VtValue(),
                                                                                   true);
@@ -269,28 +302,48 @@ static void get_vertices(const Mesh *mesh, USDMeshData &usd_mesh_data)
   }
 }
 
+struct LoopsPolysData {
+  const Mesh *mesh;
+  const int *poly_offsets;
+  int *face_vertex_counts;
+  int *face_indices;
+};
+
+static void get_loops_polys_cb(void *__restrict userdata,
+                               const int poly_idx,
+                               const TaskParallelTLS *__restrict /*tls*/)
+{
+  const LoopsPolysData *data = static_cast<const LoopsPolysData *>(userdata);
+  const MPoly *mpoly = &data->mesh->mpoly[poly_idx];
+  const MLoop *loop = data->mesh->mloop + mpoly->loopstart;
+  int *face_indices = data->face_indices + data->poly_offsets[poly_idx];
+
+  data->face_vertex_counts[poly_idx] = mpoly->totloop;
+  for (int j = 0; j < mpoly->totloop; ++j, ++loop) {
+    face_indices[j] = loop->v;
+  }
+}
+
 static void get_loops_polys(const Mesh *mesh, USDMeshData &usd_mesh_data)
 {
-  /* Only construct face groups (a.k.a. geometry subsets) when we need them for material
-   * assignments. */
-  bool construct_face_groups = mesh->totcol > 1;
+  std::vector<int> poly_offsets;
+  const int face_indices_num = get_poly_offsets(mesh, poly_offsets);
 
-  usd_mesh_data.face_vertex_counts.reserve(mesh->totpoly);
-  usd_mesh_data.face_indices.reserve(mesh->totloop);
+  usd_mesh_data.face_vertex_counts.resize(mesh->totpoly);
+  usd_mesh_data.face_indices.resize(face_indices_num);
 
-  MLoop *mloop = mesh->mloop;
-  MPoly *mpoly = mesh->mpoly;
-  for (int i = 0; i < mesh->totpoly; ++i, ++mpoly) {
-    MLoop *loop = mloop + mpoly->loopstart;
-    usd_mesh_data.face_vertex_counts.push_back(mpoly->totloop);
-    for (int j = 0; j < mpoly->totloop; ++j, ++loop) {
-      usd_mesh_data.face_indices.push_back(loop->v);
-    }
+  LoopsPolysData data;
+  data.mesh = mesh;
+  data.poly_offsets = poly_offsets.data();
+  data.face_vertex_counts = usd_mesh_data.face_vertex_counts.data();
+  data.face_indices = usd_mesh_data.face_indices.data();
 
-    if (construct_face_groups) {
-      usd_mesh_data.face_groups[mpoly->mat_nr].push_back(i);
-    }
-  }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (mesh->totpoly > BKE_MESH_OMP_LIMIT);
+  BLI_task_parallel_range(0, mesh->totpoly, &data, get_loops_polys_cb, &settings);
+
+  get_face_groups(mesh, usd_mesh_data);
 }
 
 static void get_creases(const Mesh *mesh, USDMeshData &usd_mesh_data)
@@ -386,6 +439,40 @@ void USDGenericMeshWriter::assign_materials(const HierarchyContext &context,
   }
 }
 
+struct LoopNormalsData {
+  const Mesh *mesh;
+  const int *poly_offsets;
+  pxr::GfVec3f *loop_normals;
+};
+
+static void get_loop_normals_cb(void *__restrict userdata,
+                                const int poly_idx,
+                                const TaskParallelTLS *__restrict /*tls*/)
+{
+  const LoopNormalsData *data = static_cast<const LoopNormalsData *>(userdata);
+  const MPoly *mpoly = &data->mesh->mpoly[poly_idx];
+  const MLoop *mloop = data->mesh->mloop + mpoly->loopstart;
+  const MVert *mvert = data->mesh->mvert;
+  pxr::GfVec3f *loop_normals = data->loop_normals + data->poly_offsets[poly_idx];
+  float normal[3];
+
+  if ((mpoly->flag & ME_SMOOTH) == 0) {
+    /* Flat shaded, use common normal for all verts. */
+    BKE_mesh_calc_poly_normal(mpoly, mloop, mvert, normal);
+    pxr::GfVec3f pxr_normal(normal);
+    for (int loop_idx = 0; loop_idx < mpoly->totloop; ++loop_idx) {
+      loop_normals[loop_idx] = pxr_normal;
+    }
+  }
+  else {
+    /* Smooth shaded, use individual vert normals. */
+    for (int loop_idx = 0; loop_idx < mpoly->totloop; ++loop_idx, ++mloop) {
+      normal_short_to_float_v3(normal, mvert[mloop->v].no);
+      loop_normals[loop_idx] = pxr::GfVec3f(normal);
+    }
+  }
+}
+
 void USDGenericMeshWriter::write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
@@ -402,28 +489,18 @@ void USDGenericMeshWriter::write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_
   }
   else {
     /* Compute the loop normals based on the 'smooth' flag. */
-    float normal[3];
-    MPoly *mpoly = mesh->mpoly;
-    const MVert *mvert = mesh->mvert;
-    for (int poly_idx = 0, totpoly = mesh->totpoly; poly_idx < totpoly; ++poly_idx, ++mpoly) {
-      MLoop *mloop = mesh->mloop + mpoly->loopstart;
-
-      if ((mpoly->flag & ME_SMOOTH) == 0) {
-        /* Flat shaded, use common normal for all verts. */
-        BKE_mesh_calc_poly_normal(mpoly, mloop, mvert, normal);
-        pxr::GfVec3f pxr_normal(normal);
-        for (int loop_idx = 0; loop_idx < mpoly->totloop; ++loop_idx) {
-          loop_normals.push_back(pxr_normal);
-        }
-      }
-      else {
-        /* Smooth shaded, use individual vert normals. */
-        for (int loop_idx = 0; loop_idx < mpoly->totloop; ++loop_idx, ++mloop) {
-          normal_short_to_float_v3(normal, mvert[mloop->v].no);
-          loop_normals.push_back(pxr::GfVec3f(normal));
-        }
-      }
-    }
+    std::vector<int> poly_offsets;
+    loop_normals.resize(get_poly_offsets(mesh, poly_offsets));
+
+    LoopNormalsData data;
+    data.mesh = mesh;
+    data.poly_offsets = poly_offsets.data();
+    data.loop_normals = loop_normals.data();
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (mesh->totpoly > BKE_MESH_OMP_LIMIT);
+    BLI_task_parallel_range(0, mesh->totpoly, &data, get_loop_normals_cb, &settings);
   }
 
   pxr::UsdAttribute attr_normals = usd_mesh.CreateNormalsAttr(pxr::VtValue(), true);
@@ -166,7 +166,8 @@ typedef struct ClothSimSettings {
   float internal_spring_max_diversion;
   /** Vertex group for scaling structural stiffness. */
   short vgroup_intern;
-  char _pad1[2];
+  /** Preconditioner of the implicit solver. */
+  short preconditioner;
   float internal_tension;
   float internal_compression;
   float max_internal_tension;
@@ -196,7 +197,9 @@ typedef struct ClothCollSettings {
   short self_loop_count DNA_DEPRECATED;
   /** How many iterations for the collision loop. */
   short loop_count;
-  char _pad[4];
+  /** Method to find self collision candidates. */
+  short self_broadphase;
+  char _pad[2];
   /** Only use colliders from this group of objects. */
   struct Collection *group;
   /** Vgroup to paint which vertices are used for self collisions. */
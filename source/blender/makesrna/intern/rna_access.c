@@ -35,6 +35,7 @@
 #include "BLI_dynstr.h"
 #include "BLI_ghash.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLF_api.h"
@@ -4351,6 +4352,108 @@ static int rna_property_array_length_all_dimensions(PointerRNA *ptr, PropertyRNA
   return size;
 }
 
+/* Conversion between raw arrays of different types, see #rna_raw_access_convert. */
+typedef struct RawConvertData {
+  RawArray in;
+  RawArray out;
+  /** Values per item, the input array is contiguous. */
+  int itemlen;
+  PropertyType itemtype;
+  /** Clamping done by the set functions of the item property. */
+  int hardmin_i, hardmax_i;
+  float hardmin_f, hardmax_f;
+  bool set;
+} RawConvertData;
+
+static void rna_raw_access_convert_cb(void *__restrict userdata,
+                                      const int index,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const RawConvertData *data = userdata;
+  RawArray out = data->out;
+  int a = index * data->itemlen;
+  int j;
+
+  out.array = (char *)out.array + (size_t)index * out.stride;
+
+  /* Same conversions as done through the get and set functions, values are converted
+   * to the type of the item property first. */
+  if (data->itemtype == PROP_INT) {
+    for (j = 0; j < data->itemlen; j++, a++) {
+      int i;
+      if (data->set) {
+        RAW_GET(int, i, data->in, a);
+        CLAMP(i, data->hardmin_i, data->hardmax_i);
+        RAW_SET(int, out, j, i);
+      }
+      else {
+        RAW_GET(int, i, out, j);
+        RAW_SET(int, data->in, a, i);
+      }
+    }
+  }
+  else {
+    for (j = 0; j < data->itemlen; j++, a++) {
+      float f;
+      if (data->set) {
+        RAW_GET(float, f, data->in, a);
+        CLAMP(f, data->hardmin_f, data->hardmax_f);
+        RAW_SET(float, out, j, f);
+      }
+      else {
+        RAW_GET(float, f, out, j);
+        RAW_SET(float, data->in, a, f);
+      }
+    }
+  }
+}
+
+/**
+ * Copy between a contiguous array and the raw array of a collection when their types differ,
+ * without going through the RNA functions for each item.
+ *
+ * \return false when the property needs its own functions for clamping or type conversion.
+ */
+static bool rna_raw_access_convert(
+    PropertyRNA *itemprop, RawArray *in, RawArray *out, int itemlen, int set)
+{
+  RawConvertData data = {
+      .in = *in,
+      .out = *out,
+      .itemlen = itemlen,
+      .itemtype = itemprop->type,
+      .set = (set != 0),
+  };
+
+  if (itemprop->type == PROP_INT) {
+    IntPropertyRNA *iprop = (IntPropertyRNA *)itemprop;
+    if (iprop->range || iprop->range_ex) {
+      return false;
+    }
+    data.hardmin_i = iprop->hardmin;
+    data.hardmax_i = iprop->hardmax;
+  }
+  else if (itemprop->type == PROP_FLOAT) {
+    FloatPropertyRNA *fprop = (FloatPropertyRNA *)itemprop;
+    if (fprop->range || fprop->range_ex) {
+      return false;
+    }
+    data.hardmin_f = fprop->hardmin;
+    data.hardmax_f = fprop->hardmax;
+  }
+  else {
+    /* Booleans may be stored negated. */
+    return false;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, out->len, &data, rna_raw_access_convert_cb, &settings);
+
+  return true;
+}
+
 static int rna_raw_access(ReportList *reports,
                           PointerRNA *ptr,
                           PropertyRNA *prop,
@@ -4418,6 +4521,17 @@ static int rna_raw_access(ReportList *reports,
 
         size = RNA_raw_type_sizeof(out.type) * arraylen;
 
+        if (out.stride == size) {
+          /* The collection items only contain this property, copy at once. */
+          if (set) {
+            memcpy(outp, inp, (size_t)size * out.len);
+          }
+          else {
+            memcpy(inp, outp, (size_t)size * out.len);
+          }
+          return 1;
+        }
+
         for (a = 0; a < out.len; a++) {
           if (set) {
             memcpy(outp, inp, size);
@@ -4433,8 +4547,9 @@ static int rna_raw_access(ReportList *reports,
         return 1;
       }
 
-      /* could also be faster with non-matching types,
-       * for now we just do slower loop .. */
+      if (rna_raw_access_convert(itemprop, &in, &out, arraylen, set)) {
+        return 1;
+      }
     }
   }
 
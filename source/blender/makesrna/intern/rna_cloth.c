@@ -560,6 +560,26 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
       {0, NULL, 0, NULL, NULL},
   };
 
+  static const EnumPropertyItem prop_preconditioner_items[] = {
+      {CLOTH_PRECONDITIONER_NONE,
+       "NONE",
+       0,
+       "None",
+       "Solve without preconditioning, fastest for evenly weighted cloth"},
+      {CLOTH_PRECONDITIONER_JACOBI,
+       "JACOBI",
+       0,
+       "Jacobi",
+       "Scale by the inverse of the matrix diagonal"},
+      {CLOTH_PRECONDITIONER_BLOCK_JACOBI,
+       "BLOCK_JACOBI",
+       0,
+       "Block Jacobi",
+       "Scale by the inverse of the 3x3 block of each vertex, helps with strongly varying "
+       "mass or stiffness"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
   srna = RNA_def_struct(brna, "ClothSettings", NULL);
   RNA_def_struct_ui_text(srna, "Cloth Settings", "Cloth simulation settings for an object");
   RNA_def_struct_sdna(srna, "ClothSimSettings");
@@ -874,6 +894,14 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
   RNA_def_property_update(prop, 0, "rna_cloth_update");
   RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
 
+  prop = RNA_def_property(srna, "preconditioner", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "preconditioner");
+  RNA_def_property_enum_items(prop, prop_preconditioner_items);
+  RNA_def_property_ui_text(
+      prop, "Preconditioner", "Preconditioner used by the solver for the implicit integration");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+
   prop = RNA_def_property(srna, "use_internal_springs", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flags", CLOTH_SIMSETTINGS_FLAG_INTERNAL_SPRINGS);
   RNA_def_property_ui_text(prop,
@@ -1056,6 +1084,21 @@ static void rna_def_cloth_collision_settings(BlenderRNA *brna)
   StructRNA *srna;
   PropertyRNA *prop;
 
+  static const EnumPropertyItem prop_self_broadphase_items[] = {
+      {CLOTH_SELF_BROADPHASE_BVH,
+       "BVH",
+       0,
+       "BVH",
+       "Refit a bounding volume hierarchy of the faces on every step"},
+      {CLOTH_SELF_BROADPHASE_HASH,
+       "HASH",
+       0,
+       "Spatial Hash",
+       "Rebuild a grid of the faces on every step using all threads, "
+       "faster for dense cloth with many self collisions"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
   srna = RNA_def_struct(brna, "ClothCollisionSettings", NULL);
   RNA_def_struct_ui_text(
       srna,
@@ -1128,6 +1171,14 @@ static void rna_def_cloth_collision_settings(BlenderRNA *brna)
       "Minimum distance between cloth faces before collision response takes effect");
   RNA_def_property_update(prop, 0, "rna_cloth_update");
 
+  prop = RNA_def_property(srna, "self_broadphase", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "self_broadphase");
+  RNA_def_property_enum_items(prop, prop_self_broadphase_items);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+  RNA_def_property_ui_text(
+      prop, "Self Collision Method", "Method to find faces which may collide with each other");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+
   prop = RNA_def_property(srna, "self_friction", PROP_FLOAT, PROP_NONE);
   RNA_def_property_range(prop, 0.0f, 80.0f);
   RNA_def_property_ui_text(prop, "Self Friction", "Friction with self contact");
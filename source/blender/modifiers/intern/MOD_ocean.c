@@ -336,6 +336,120 @@ static Mesh *generate_ocean_geometry(OceanModifierData *omd, Mesh *mesh_orig)
   return result;
 }
 
+/* Points are sampled in blocks, so the ocean is only locked once per block. */
+#  define OCEAN_EVAL_BLOCK_SIZE 256
+
+/* use cached & inverted value for speed
+ * expanded this would read...
+ *
+ * (axis / (omd->size * omd->spatial_size)) + 0.5f) */
+#  define OCEAN_CO(_size_co_inv, _v) ((_v * _size_co_inv) + 0.5f)
+
+typedef struct OceanEvalData {
+  OceanModifierData *omd;
+  MVert *mverts;
+  const MLoop *mloops;
+  MLoopCol *mloopcols;
+  int cfra_for_cache;
+  float size_co_inv;
+  int totelem;
+} OceanEvalData;
+
+static void ocean_eval_block(const OceanEvalData *data,
+                             OceanResult *r_ocr,
+                             const float (*uv)[2],
+                             const int len)
+{
+  OceanModifierData *omd = data->omd;
+
+  if (omd->oceancache && omd->cached == true) {
+    BKE_ocean_cache_eval_uv_array(omd->oceancache, r_ocr, data->cfra_for_cache, uv, len);
+  }
+  else {
+    BKE_ocean_eval_uv_array(omd->ocean, r_ocr, uv, len);
+  }
+}
+
+static void ocean_foam_loops_block(void *__restrict userdata,
+                                   const int block,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const OceanEvalData *data = userdata;
+  OceanModifierData *omd = data->omd;
+  const int start = block * OCEAN_EVAL_BLOCK_SIZE;
+  const int len = min_ii(data->totelem - start, OCEAN_EVAL_BLOCK_SIZE);
+  float uv[OCEAN_EVAL_BLOCK_SIZE][2];
+  OceanResult ocr[OCEAN_EVAL_BLOCK_SIZE];
+
+  for (int i = 0; i < len; i++) {
+    const float *vco = data->mverts[data->mloops[start + i].v].co;
+    uv[i][0] = OCEAN_CO(data->size_co_inv, vco[0]);
+    uv[i][1] = OCEAN_CO(data->size_co_inv, vco[1]);
+  }
+
+  ocean_eval_block(data, ocr, (const float(*)[2])uv, len);
+
+  for (int i = 0; i < len; i++) {
+    MLoopCol *mlcol = &data->mloopcols[start + i];
+    float foam;
+
+    if (omd->oceancache && omd->cached == true) {
+      foam = ocr[i].foam;
+      CLAMP(foam, 0.0f, 1.0f);
+    }
+    else {
+      foam = BKE_ocean_jminus_to_foam(ocr[i].Jminus, omd->foam_coverage);
+    }
+
+    mlcol->r = mlcol->g = mlcol->b = (char)(foam * 255);
+    /* This needs to be set (render engine uses) */
+    mlcol->a = 255;
+  }
+}
+
+static void ocean_displace_verts_block(void *__restrict userdata,
+                                       const int block,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const OceanEvalData *data = userdata;
+  const int start = block * OCEAN_EVAL_BLOCK_SIZE;
+  const int len = min_ii(data->totelem - start, OCEAN_EVAL_BLOCK_SIZE);
+  const bool use_chop = (data->omd->chop_amount > 0.0f);
+  float uv[OCEAN_EVAL_BLOCK_SIZE][2];
+  OceanResult ocr[OCEAN_EVAL_BLOCK_SIZE];
+
+  for (int i = 0; i < len; i++) {
+    const float *vco = data->mverts[start + i].co;
+    uv[i][0] = OCEAN_CO(data->size_co_inv, vco[0]);
+    uv[i][1] = OCEAN_CO(data->size_co_inv, vco[1]);
+  }
+
+  ocean_eval_block(data, ocr, (const float(*)[2])uv, len);
+
+  for (int i = 0; i < len; i++) {
+    float *vco = data->mverts[start + i].co;
+
+    vco[2] += ocr[i].disp[1];
+
+    if (use_chop) {
+      vco[0] += ocr[i].disp[0];
+      vco[1] += ocr[i].disp[2];
+    }
+  }
+}
+
+/* Run \a func over \a totelem points, in blocks of #OCEAN_EVAL_BLOCK_SIZE. */
+static void ocean_eval_parallel(OceanEvalData *data, TaskParallelRangeFunc func, const int totelem)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totelem > OCEAN_EVAL_BLOCK_SIZE);
+
+  data->totelem = totelem;
+  BLI_task_parallel_range(
+      0, (totelem + OCEAN_EVAL_BLOCK_SIZE - 1) / OCEAN_EVAL_BLOCK_SIZE, data, func, &settings);
+}
+
 static Mesh *doOcean(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mesh)
 {
   OceanModifierData *omd = (OceanModifierData *)md;
@@ -344,18 +458,10 @@ static Mesh *doOcean(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mes
   bool allocated_ocean = false;
 
   Mesh *result = NULL;
-  OceanResult ocr;
 
   MVert *mverts;
 
   int cfra_for_cache;
-  int i, j;
-
-  /* use cached & inverted value for speed
-   * expanded this would read...
-   *
-   * (axis / (omd->size * omd->spatial_size)) + 0.5f) */
-#  define OCEAN_CO(_size_co_inv, _v) ((_v * _size_co_inv) + 0.5f)
 
   const float size_co_inv = 1.0f / (omd->size * omd->spatial_size);
 
@@ -395,84 +501,37 @@ static Mesh *doOcean(ModifierData *md, const ModifierEvalContext *ctx, Mesh *mes
 
   mverts = result->mvert;
 
+  OceanEvalData data = {
+      .omd = omd,
+      .mverts = mverts,
+      .cfra_for_cache = cfra_for_cache,
+      .size_co_inv = size_co_inv,
+  };
+
   /* add vcols before displacement - allows lookup based on position */
 
   if (omd->flag & MOD_OCEAN_GENERATE_FOAM) {
     if (CustomData_number_of_layers(&result->ldata, CD_MLOOPCOL) < MAX_MCOL) {
-      const int num_polys = result->totpoly;
       const int num_loops = result->totloop;
-      MLoop *mloops = result->mloop;
       MLoopCol *mloopcols = CustomData_add_layer_named(
           &result->ldata, CD_MLOOPCOL, CD_CALLOC, NULL, num_loops, omd->foamlayername);
 
       if (mloopcols) { /* unlikely to fail */
-        MPoly *mpolys = result->mpoly;
-        MPoly *mp;
-
-        for (i = 0, mp = mpolys; i < num_polys; i++, mp++) {
-          MLoop *ml = &mloops[mp->loopstart];
-          MLoopCol *mlcol = &mloopcols[mp->loopstart];
-
-          for (j = mp->totloop; j--; ml++, mlcol++) {
-            const float *vco = mverts[ml->v].co;
-            const float u = OCEAN_CO(size_co_inv, vco[0]);
-            const float v = OCEAN_CO(size_co_inv, vco[1]);
-            float foam;
-
-            if (omd->oceancache && omd->cached == true) {
-              BKE_ocean_cache_eval_uv(omd->oceancache, &ocr, cfra_for_cache, u, v);
-              foam = ocr.foam;
-              CLAMP(foam, 0.0f, 1.0f);
-            }
-            else {
-              BKE_ocean_eval_uv(omd->ocean, &ocr, u, v);
-              foam = BKE_ocean_jminus_to_foam(ocr.Jminus, omd->foam_coverage);
-            }
-
-            mlcol->r = mlcol->g = mlcol->b = (char)(foam * 255);
-            /* This needs to be set (render engine uses) */
-            mlcol->a = 255;
-          }
-        }
+        data.mloops = result->mloop;
+        data.mloopcols = mloopcols;
+        ocean_eval_parallel(&data, ocean_foam_loops_block, num_loops);
       }
     }
   }
 
   /* displace the geometry */
-
-  /* Note: tried to parallelized that one and previous foam loop,
-   * but gives 20% slower results... odd. */
-  {
-    const int num_verts = result->totvert;
-
-    for (i = 0; i < num_verts; i++) {
-      float *vco = mverts[i].co;
-      const float u = OCEAN_CO(size_co_inv, vco[0]);
-      const float v = OCEAN_CO(size_co_inv, vco[1]);
-
-      if (omd->oceancache && omd->cached == true) {
-        BKE_ocean_cache_eval_uv(omd->oceancache, &ocr, cfra_for_cache, u, v);
-      }
-      else {
-        BKE_ocean_eval_uv(omd->ocean, &ocr, u, v);
-      }
-
-      vco[2] += ocr.disp[1];
-
-      if (omd->chop_amount > 0.0f) {
-        vco[0] += ocr.disp[0];
-        vco[1] += ocr.disp[2];
-      }
-    }
-  }
+  ocean_eval_parallel(&data, ocean_displace_verts_block, result->totvert);
 
   if (allocated_ocean) {
     BKE_ocean_free(omd->ocean);
     omd->ocean = NULL;
   }
 
-#  undef OCEAN_CO
-
   return result;
 }
 #else  /* WITH_OCEANSIM */
@@ -1160,6 +1160,8 @@ int BPH_cloth_solve(
     }
   }
 
+  BPH_mass_spring_solver_set_preconditioner(id, clmd->sim_parms->preconditioner);
+
   while (step < tf) {
     ImplicitSolverResult result;
 
@@ -100,6 +100,8 @@ void BPH_mass_spring_add_constraint_ndof2(struct Implicit_Data *data,
                                           const float c1[3],
                                           const float dV[3]);
 
+/* Preconditioner of the velocity solver, one of CLOTH_PRECONDITIONER_*. */
+void BPH_mass_spring_solver_set_preconditioner(struct Implicit_Data *data, int preconditioner);
 bool BPH_mass_spring_solve_velocities(struct Implicit_Data *data,
                                       float dt,
                                       struct ImplicitSolverResult *result);
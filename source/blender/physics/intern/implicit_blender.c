@@ -34,6 +34,7 @@
 #  include "DNA_texture_types.h"
 
 #  include "BLI_math.h"
+#  include "BLI_task.h"
 #  include "BLI_utildefines.h"
 
 #  include "BKE_cloth.h"
@@ -652,6 +653,89 @@ DO_INLINE void subadd_bfmatrixS_bfmatrixS(
   }
 }
 
+///////////////////////////
+// block sparse matrix in compressed row storage
+///////////////////////////
+
+/* The big matrices above store the symmetric system as its diagonal blocks followed by one block
+ * per spring, so multiplying with a vector scatters each spring into two rows. For the solver
+ * the off-diagonal blocks are expanded into both of their rows, after which every row can be
+ * computed independently and the matrix-vector product runs in parallel. */
+typedef struct BlockCSRMatrix {
+  int num_rows;
+  int num_blocks, alloc_blocks;
+  int *row_offset; /* start of each row in col and blocks, num_rows + 1 entries */
+  int *row_fill;   /* insertion position while building */
+  int *col;
+  float (*blocks)[3][3];
+} BlockCSRMatrix;
+
+static void csr_init(BlockCSRMatrix *csr, int num_rows)
+{
+  memset(csr, 0, sizeof(*csr));
+  csr->num_rows = num_rows;
+  csr->row_offset = MEM_mallocN(sizeof(int) * (num_rows + 1), "cloth_csr_row_offset");
+  csr->row_fill = MEM_mallocN(sizeof(int) * num_rows, "cloth_csr_row_fill");
+}
+
+static void csr_free(BlockCSRMatrix *csr)
+{
+  MEM_SAFE_FREE(csr->row_offset);
+  MEM_SAFE_FREE(csr->row_fill);
+  MEM_SAFE_FREE(csr->col);
+  MEM_SAFE_FREE(csr->blocks);
+}
+
+/* Fill from a big matrix with num_springs off-diagonal blocks in use. */
+static void csr_from_bfmatrix(BlockCSRMatrix *csr, fmatrix3x3 *from, int num_springs)
+{
+  const int num_rows = csr->num_rows;
+  int *row_offset = csr->row_offset;
+  int *row_fill = csr->row_fill;
+
+  BLI_assert(num_rows == from[0].vcount);
+
+  csr->num_blocks = num_rows + 2 * num_springs;
+  if (csr->num_blocks > csr->alloc_blocks) {
+    MEM_SAFE_FREE(csr->col);
+    MEM_SAFE_FREE(csr->blocks);
+    csr->alloc_blocks = csr->num_blocks;
+    csr->col = MEM_mallocN(sizeof(int) * csr->alloc_blocks, "cloth_csr_col");
+    csr->blocks = MEM_mallocN(sizeof(float[3][3]) * csr->alloc_blocks, "cloth_csr_blocks");
+  }
+
+  /* Count blocks per row, the diagonal block comes first. */
+  row_offset[0] = 0;
+  for (int i = 0; i < num_rows; i++) {
+    row_offset[i + 1] = 1;
+  }
+  for (int i = num_rows; i < num_rows + num_springs; i++) {
+    row_offset[from[i].r + 1]++;
+    row_offset[from[i].c + 1]++;
+  }
+  for (int i = 0; i < num_rows; i++) {
+    row_offset[i + 1] += row_offset[i];
+  }
+
+  for (int i = 0; i < num_rows; i++) {
+    const int b = row_offset[i];
+    csr->col[b] = i;
+    copy_m3_m3(csr->blocks[b], from[i].m);
+    row_fill[i] = b + 1;
+  }
+  for (int i = num_rows; i < num_rows + num_springs; i++) {
+    const int r = from[i].r, c = from[i].c;
+    int b = row_fill[r]++;
+    csr->col[b] = c;
+    copy_m3_m3(csr->blocks[b], from[i].m);
+
+    /* This is the lower triangle of the matrix, so the transposed block is used. */
+    b = row_fill[c]++;
+    csr->col[b] = r;
+    transpose_m3_m3(csr->blocks[b], from[i].m);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////
 // simulator start
 ///////////////////////////////////////////////////////////////////
@@ -677,6 +761,9 @@ typedef struct Implicit_Data {
   lfVector *z;          /* target velocity in constrained directions */
   fmatrix3x3 *S;        /* filtering matrix for constraints */
   fmatrix3x3 *P, *Pinv; /* pre-conditioning matrix */
+
+  BlockCSRMatrix csr; /* A in compressed row storage, for the solver */
+  int preconditioner; /* CLOTH_PRECONDITIONER_* */
 } Implicit_Data;
 
 Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
@@ -702,6 +789,8 @@ Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
   id->dV = create_lfvector(numverts);
   id->z = create_lfvector(numverts);
 
+  csr_init(&id->csr, numverts);
+
   initdiag_bfmatrix(id->bigI, I);
 
   return id;
@@ -728,6 +817,8 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
   del_lfvector(id->dV);
   del_lfvector(id->z);
 
+  csr_free(&id->csr);
+
   MEM_freeN(id);
 }
 
@@ -838,8 +929,141 @@ static int cg_filtered(lfVector *ldV, fmatrix3x3 *lA, lfVector *lB, lfVector *z,
 }
 #  endif
 
-static int cg_filtered(lfVector *ldV,
-                       fmatrix3x3 *lA,
+/* Solver data is processed in chunks of vertices. Dot products are summed per chunk and the
+ * chunks are then added in order, so the result does not depend on the number of threads. */
+#  define CG_CHUNK_SIZE 1024
+#  define CG_PARALLEL_LIMIT 2048
+
+typedef struct CGTaskData {
+  const BlockCSRMatrix *A;
+  fmatrix3x3 *S, *Pinv;
+  int numverts;
+  bool use_block_jacobi;
+
+  lfVector *x, *r, *c, *q, *s;
+  float alpha, beta;
+
+  /* Partial sums per chunk. */
+  float *dot_a, *dot_b;
+} CGTaskData;
+
+BLI_INLINE void cg_chunk_range(const CGTaskData *data, int chunk, int *r_start, int *r_end)
+{
+  *r_start = chunk * CG_CHUNK_SIZE;
+  *r_end = min_ii(*r_start + CG_CHUNK_SIZE, data->numverts);
+}
+
+/* Inverse of the diagonal of A, or of its diagonal blocks. */
+static void cg_preconditioner_task(void *__restrict userdata,
+                                   const int chunk,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGTaskData *data = userdata;
+  const BlockCSRMatrix *A = data->A;
+  int start, end;
+  cg_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    float(*diag)[3] = A->blocks[A->row_offset[i]];
+    float(*pinv)[3] = data->Pinv[i].m;
+
+    if (data->use_block_jacobi && invert_m3_m3(pinv, diag)) {
+      continue;
+    }
+
+    zero_m3(pinv);
+    for (int k = 0; k < 3; k++) {
+      pinv[k][k] = (diag[k][k] != 0.0f) ? 1.0f / diag[k][k] : 1.0f;
+    }
+  }
+}
+
+/* q = filter(A * c), dot_a = c^T * q */
+static void cg_mul_task(void *__restrict userdata,
+                        const int chunk,
+                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGTaskData *data = userdata;
+  const BlockCSRMatrix *A = data->A;
+  lfVector *c = data->c, *q = data->q;
+  float dot = 0.0f;
+  int start, end;
+  cg_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    float sum[3] = {0.0f, 0.0f, 0.0f};
+    for (int b = A->row_offset[i]; b < A->row_offset[i + 1]; b++) {
+      muladd_fmatrix_fvector(sum, A->blocks[b], c[A->col[b]]);
+    }
+    mul_v3_m3v3(q[i], data->S[i].m, sum);
+    dot += dot_v3v3(c[i], q[i]);
+  }
+
+  data->dot_a[chunk] = dot;
+}
+
+/* x += alpha * c, r -= alpha * q, s = filter(P^-1 * r), dot_a = r^T * s, dot_b = r^T * r */
+static void cg_update_task(void *__restrict userdata,
+                           const int chunk,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGTaskData *data = userdata;
+  lfVector *x = data->x, *r = data->r, *c = data->c, *q = data->q, *s = data->s;
+  const float alpha = data->alpha;
+  float dot_rs = 0.0f, dot_rr = 0.0f;
+  int start, end;
+  cg_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    madd_v3_v3fl(x[i], c[i], alpha);
+    madd_v3_v3fl(r[i], q[i], -alpha);
+
+    if (data->Pinv) {
+      float tmp[3];
+      mul_fmatrix_fvector(tmp, data->Pinv[i].m, r[i]);
+      mul_v3_m3v3(s[i], data->S[i].m, tmp);
+    }
+    else {
+      copy_v3_v3(s[i], r[i]);
+    }
+
+    dot_rs += dot_v3v3(r[i], s[i]);
+    dot_rr += dot_v3v3(r[i], r[i]);
+  }
+
+  data->dot_a[chunk] = dot_rs;
+  data->dot_b[chunk] = dot_rr;
+}
+
+/* c = filter(s + beta * c) */
+static void cg_direction_task(void *__restrict userdata,
+                              const int chunk,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGTaskData *data = userdata;
+  lfVector *c = data->c, *s = data->s;
+  const float beta = data->beta;
+  int start, end;
+  cg_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    float tmp[3];
+    madd_v3_v3v3fl(tmp, s[i], c[i], beta);
+    mul_v3_m3v3(c[i], data->S[i].m, tmp);
+  }
+}
+
+static float cg_sum_chunks(const float *partial, int num_chunks)
+{
+  float sum = 0.0f;
+  for (int i = 0; i < num_chunks; i++) {
+    sum += partial[i];
+  }
+  return sum;
+}
+
+static int cg_filtered(Implicit_Data *data,
+                       lfVector *ldV,
                        lfVector *lB,
                        lfVector *z,
                        fmatrix3x3 *S,
@@ -849,14 +1073,43 @@ static int cg_filtered(lfVector *ldV,
   unsigned int conjgrad_loopcount = 0, conjgrad_looplimit = 100;
   float conjgrad_epsilon = 0.01f;
 
-  unsigned int numverts = lA[0].vcount;
+  unsigned int numverts = data->A[0].vcount;
+  const int num_chunks = max_ii((numverts + CG_CHUNK_SIZE - 1) / CG_CHUNK_SIZE, 1);
   lfVector *fB = create_lfvector(numverts);
   lfVector *AdV = create_lfvector(numverts);
   lfVector *r = create_lfvector(numverts);
   lfVector *c = create_lfvector(numverts);
   lfVector *q = create_lfvector(numverts);
   lfVector *s = create_lfvector(numverts);
-  float bnorm2, delta_new, delta_old, delta_target, alpha;
+  float *dot_a = MEM_mallocN(sizeof(float) * num_chunks, "cloth_cg_dot_a");
+  float *dot_b = MEM_mallocN(sizeof(float) * num_chunks, "cloth_cg_dot_b");
+  float bnorm2, rnorm2, delta_new, delta_old, delta_target, alpha;
+
+  csr_from_bfmatrix(&data->csr, data->A, data->num_blocks);
+
+  CGTaskData task_data = {
+      .A = &data->csr,
+      .S = S,
+      .Pinv = NULL,
+      .numverts = numverts,
+      .x = ldV,
+      .r = r,
+      .c = c,
+      .q = q,
+      .s = s,
+      .dot_a = dot_a,
+      .dot_b = dot_b,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numverts > CG_PARALLEL_LIMIT);
+
+  if (data->preconditioner != CLOTH_PRECONDITIONER_NONE) {
+    task_data.Pinv = data->Pinv;
+    task_data.use_block_jacobi = (data->preconditioner == CLOTH_PRECONDITIONER_BLOCK_JACOBI);
+    BLI_task_parallel_range(0, num_chunks, &task_data, cg_preconditioner_task, &settings);
+  }
 
   cp_lfvector(ldV, z, numverts);
 
@@ -866,21 +1119,38 @@ static int cg_filtered(lfVector *ldV,
   bnorm2 = dot_lfvector(fB, fB, numverts);
   delta_target = conjgrad_epsilon * conjgrad_epsilon * bnorm2;
 
-  /* r = filter(B - A * dV) */
-  mul_bfmatrix_lfvector(AdV, lA, ldV);
-  sub_lfvector_lfvector(r, lB, AdV, numverts);
-  filter(r, S);
+  if (task_data.Pinv) {
+    /* With a preconditioner the residual is measured in the norm of P^-1,
+     * so the tolerance must be as well. */
+    task_data.r = fB;
+    task_data.alpha = 0.0f;
+    BLI_task_parallel_range(0, num_chunks, &task_data, cg_update_task, &settings);
+    task_data.r = r;
+    delta_target = conjgrad_epsilon * conjgrad_epsilon * cg_sum_chunks(dot_a, num_chunks);
+  }
 
-  /* c = filter(P^-1 * r) */
-  cp_lfvector(c, r, numverts);
+  /* r = filter(B - A * dV) */
+  task_data.c = ldV;
+  task_data.q = AdV;
+  BLI_task_parallel_range(0, num_chunks, &task_data, cg_mul_task, &settings);
+  sub_lfvector_lfvector(r, fB, AdV, numverts);
+
+  /* c = filter(P^-1 * r), delta = r^T * c
+   * (the update with zero step size only applies the preconditioner) */
+  task_data.c = c;
+  task_data.q = q;
+  task_data.s = c;
+  task_data.alpha = 0.0f;
+  BLI_task_parallel_range(0, num_chunks, &task_data, cg_update_task, &settings);
+  task_data.s = s;
   filter(c, S);
 
-  /* delta = r^T * c */
-  delta_new = dot_lfvector(r, c, numverts);
+  delta_new = cg_sum_chunks(dot_a, num_chunks);
+  rnorm2 = cg_sum_chunks(dot_b, num_chunks);
 
 #  ifdef IMPLICIT_PRINT_SOLVER_INPUT_OUTPUT
   printf("==== A ====\n");
-  print_bfmatrix(lA);
+  print_bfmatrix(data->A);
   printf("==== z ====\n");
   print_lvector(z, numverts);
   printf("==== B ====\n");
@@ -889,23 +1159,24 @@ static int cg_filtered(lfVector *ldV,
   print_bfmatrix(S);
 #  endif
 
-  while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
-    mul_bfmatrix_lfvector(q, lA, c);
-    filter(q, S);
-
-    alpha = delta_new / dot_lfvector(c, q, numverts);
+  while ((task_data.Pinv ? delta_new : rnorm2) > delta_target &&
+         conjgrad_loopcount < conjgrad_looplimit) {
+    /* q = filter(A * c) */
+    BLI_task_parallel_range(0, num_chunks, &task_data, cg_mul_task, &settings);
 
-    add_lfvector_lfvectorS(ldV, ldV, c, alpha, numverts);
+    alpha = delta_new / cg_sum_chunks(dot_a, num_chunks);
 
-    add_lfvector_lfvectorS(r, r, q, -alpha, numverts);
+    /* dV += alpha * c, r -= alpha * q, s = filter(P^-1 * r) */
+    task_data.alpha = alpha;
+    BLI_task_parallel_range(0, num_chunks, &task_data, cg_update_task, &settings);
 
-    /* s = P^-1 * r */
-    cp_lfvector(s, r, numverts);
     delta_old = delta_new;
-    delta_new = dot_lfvector(r, s, numverts);
+    delta_new = cg_sum_chunks(dot_a, num_chunks);
+    rnorm2 = cg_sum_chunks(dot_b, num_chunks);
 
-    add_lfvector_lfvectorS(c, s, c, delta_new / delta_old, numverts);
-    filter(c, S);
+    /* c = filter(s + c * delta_new / delta_old) */
+    task_data.beta = delta_new / delta_old;
+    BLI_task_parallel_range(0, num_chunks, &task_data, cg_direction_task, &settings);
 
     conjgrad_loopcount++;
   }
@@ -922,12 +1193,14 @@ static int cg_filtered(lfVector *ldV,
   del_lfvector(c);
   del_lfvector(q);
   del_lfvector(s);
+  MEM_freeN(dot_a);
+  MEM_freeN(dot_b);
   // printf("W/O conjgrad_loopcount: %d\n", conjgrad_loopcount);
 
   result->status = conjgrad_loopcount < conjgrad_looplimit ? BPH_SOLVER_SUCCESS :
                                                              BPH_SOLVER_NO_CONVERGENCE;
   result->iterations = conjgrad_loopcount;
-  result->error = bnorm2 > 0.0f ? sqrtf(delta_new / bnorm2) : 0.0f;
+  result->error = bnorm2 > 0.0f ? sqrtf(rnorm2 / bnorm2) : 0.0f;
 
   return conjgrad_loopcount <
          conjgrad_looplimit;  // true means we reached desired accuracy in given time - ie stable
@@ -1139,6 +1412,11 @@ static int cg_filtered_pre(lfVector *dv,
 }
 #  endif
 
+void BPH_mass_spring_solver_set_preconditioner(Implicit_Data *data, int preconditioner)
+{
+  data->preconditioner = preconditioner;
+}
+
 bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSolverResult *result)
 {
   unsigned int numverts = data->dFdV[0].vcount;
@@ -1159,7 +1437,7 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 #  endif
 
   /* Conjugate gradient algorithm to solve Ax=b. */
-  cg_filtered(data->dV, data->A, data->B, data->z, data->S, result);
+  cg_filtered(data, data->dV, data->B, data->z, data->S, result);
 
   // cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
@@ -511,6 +511,12 @@ BLI_INLINE void root_to_world_m3(Implicit_Data *data, int index, float r[3][3],
 
 /* ================================ */
 
+void BPH_mass_spring_solver_set_preconditioner(Implicit_Data *UNUSED(data),
+                                               int UNUSED(preconditioner))
+{
+  /* The Eigen solver uses its own preconditioner. */
+}
+
 bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSolverResult *result)
 {
 #  ifdef USE_EIGEN_CORE
@@ -5243,6 +5243,55 @@ static bool foreach_compat_buffer(RawPropertyType raw_type, int attr_signed, con
   return 0;
 }
 
+/**
+ * Raw type matching the format of a buffer, for buffers which can be converted by RNA.
+ * Unsigned formats are not supported, since RNA reads and writes signed values. Neither are
+ * bytes: #PROP_RAW_CHAR is a plain `char`, which is unsigned on some platforms.
+ */
+static RawPropertyType foreach_buffer_raw_type(const char *format)
+{
+  switch (format ? *format : 'B') {
+    case 'h':
+      return PROP_RAW_SHORT;
+    case 'i':
+      return PROP_RAW_INT;
+    case '?':
+      return PROP_RAW_BOOLEAN;
+    case 'f':
+      return PROP_RAW_FLOAT;
+    case 'd':
+      return PROP_RAW_DOUBLE;
+    default:
+      return PROP_RAW_UNSET;
+  }
+}
+
+/**
+ * Whether the buffer can be passed to RNA as is, in which case \a r_raw_type is set to the type
+ * of its items. When it doesn't match the attribute type, RNA converts the values, which avoids
+ * creating a Python object for each of them.
+ */
+static bool foreach_compat_buffer_ex(RawPropertyType raw_type,
+                                     int attr_signed,
+                                     const Py_buffer *buf,
+                                     int tot,
+                                     RawPropertyType *r_raw_type)
+{
+  if (foreach_compat_buffer(raw_type, attr_signed, buf->format)) {
+    *r_raw_type = raw_type;
+    return true;
+  }
+
+  const RawPropertyType buf_raw_type = foreach_buffer_raw_type(buf->format);
+  if (buf_raw_type != PROP_RAW_UNSET &&
+      buf->len == (Py_ssize_t)tot * RNA_raw_type_sizeof(buf_raw_type)) {
+    *r_raw_type = buf_raw_type;
+    return true;
+  }
+
+  return false;
+}
+
 static PyObject *foreach_getset(BPy_PropertyRNA *self, PyObject *args, int set)
 {
   PyObject *item = NULL;
@@ -5273,12 +5322,13 @@ static PyObject *foreach_getset(BPy_PropertyRNA *self, PyObject *args, int set)
       PyObject_GetBuffer(seq, &buf, PyBUF_SIMPLE | PyBUF_FORMAT);
 
       /* Check if the buffer matches. */
+      RawPropertyType buf_raw_type;
 
-      buffer_is_compat = foreach_compat_buffer(raw_type, attr_signed, buf.format);
+      buffer_is_compat = foreach_compat_buffer_ex(raw_type, attr_signed, &buf, tot, &buf_raw_type);
 
       if (buffer_is_compat) {
         ok = RNA_property_collection_raw_set(
-            NULL, &self->ptr, self->prop, attr, buf.buf, raw_type, tot);
+            NULL, &self->ptr, self->prop, attr, buf.buf, buf_raw_type, tot);
       }
 
       PyBuffer_Release(&buf);
@@ -5329,12 +5379,13 @@ static PyObject *foreach_getset(BPy_PropertyRNA *self, PyObject *args, int set)
       PyObject_GetBuffer(seq, &buf, PyBUF_SIMPLE | PyBUF_FORMAT);
 
       /* Check if the buffer matches, TODO - signed/unsigned types. */
+      RawPropertyType buf_raw_type;
 
-      buffer_is_compat = foreach_compat_buffer(raw_type, attr_signed, buf.format);
+      buffer_is_compat = foreach_compat_buffer_ex(raw_type, attr_signed, &buf, tot, &buf_raw_type);
 
       if (buffer_is_compat) {
         ok = RNA_property_collection_raw_get(
-            NULL, &self->ptr, self->prop, attr, buf.buf, raw_type, tot);
+            NULL, &self->ptr, self->prop, attr, buf.buf, buf_raw_type, tot);
       }
 
       PyBuffer_Release(&buf);
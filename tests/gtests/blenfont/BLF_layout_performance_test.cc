@@ -0,0 +1,129 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "BLF_api.h"
+
+#include "PIL_time.h"
+}
+
+DEFINE_string(test_font, "", "Font file to lay out text with, e.g. droidsans.ttf.");
+
+/* Measure and draw many short labels to a buffer, as an interface with many buttons does on
+ * every redraw. Labels are laid out on first use and drawn again afterwards. Changing labels are
+ * different on every redraw, like values being edited, and push the others out of the cache. */
+
+#define LABEL_LEN 64
+#define BUFFER_WIDTH 512
+#define BUFFER_HEIGHT 32
+
+static void blf_layout_test_do(const char *id,
+                               const char *label_prefix,
+                               const int labels_num,
+                               const int labels_changing_num,
+                               const int redraws)
+{
+  if (FLAGS_test_font.empty()) {
+    FAIL() << "Pass the --test-font flag";
+  }
+
+  BLF_init();
+  const int fontid = BLF_load(FLAGS_test_font.c_str());
+  ASSERT_NE(fontid, -1);
+  BLF_size(fontid, 11, 72);
+  BLF_enable(fontid, BLF_KERNING_DEFAULT);
+
+  char(*labels)[LABEL_LEN] = (char(*)[LABEL_LEN])MEM_mallocN(sizeof(*labels) * labels_num,
+                                                               __func__);
+  for (int i = 0; i < labels_num; i++) {
+    BLI_snprintf(labels[i], LABEL_LEN, "%s %d.%03d", label_prefix, i, i % 7);
+  }
+
+  unsigned char *buffer = (unsigned char *)MEM_callocN(BUFFER_WIDTH * BUFFER_HEIGHT * 4,
+                                                       __func__);
+  const float color[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  BLF_buffer(fontid, NULL, buffer, BUFFER_WIDTH, BUFFER_HEIGHT, 4, NULL);
+  BLF_buffer_col(fontid, color);
+
+  char label_changing[LABEL_LEN];
+  float width_first = 0.0f, width = 0.0f;
+
+  double time = PIL_check_seconds_timer();
+  for (int i = 0; i < labels_num; i++) {
+    width_first += BLF_width(fontid, labels[i], LABEL_LEN);
+  }
+  const double time_width_first = PIL_check_seconds_timer() - time;
+
+  time = PIL_check_seconds_timer();
+  for (int redraw = 0; redraw < redraws; redraw++) {
+    width = 0.0f;
+    for (int i = 0; i < labels_num; i++) {
+      width += BLF_width(fontid, labels[i], LABEL_LEN);
+    }
+    for (int i = 0; i < labels_changing_num; i++) {
+      BLI_snprintf(label_changing, LABEL_LEN, "%d: %d", i, redraw);
+      BLF_width(fontid, label_changing, LABEL_LEN);
+    }
+  }
+  const double time_width = PIL_check_seconds_timer() - time;
+
+  time = PIL_check_seconds_timer();
+  for (int redraw = 0; redraw < redraws; redraw++) {
+    for (int i = 0; i < labels_num; i++) {
+      BLF_position(fontid, 0.0f, 8.0f, 0.0f);
+      BLF_draw_buffer(fontid, labels[i], LABEL_LEN);
+    }
+    for (int i = 0; i < labels_changing_num; i++) {
+      BLI_snprintf(label_changing, LABEL_LEN, "%d: %d", i, redraw);
+      BLF_position(fontid, 0.0f, 8.0f, 0.0f);
+      BLF_draw_buffer(fontid, label_changing, LABEL_LEN);
+    }
+  }
+  const double time_draw = PIL_check_seconds_timer() - time;
+
+  printf("%s: %d labels, %d changing labels, %d redraws\n",
+         id,
+         labels_num,
+         labels_changing_num,
+         redraws);
+  printf("\tFirst width: %fs\n", time_width_first);
+  printf("\tWidth: %fs\n", time_width);
+  printf("\tDraw to buffer: %fs\n", time_draw);
+
+  /* Cached layouts give the same result. */
+  EXPECT_EQ(width_first, width);
+
+  BLF_buffer(fontid, NULL, NULL, 0, 0, 0, NULL);
+  MEM_freeN(buffer);
+  MEM_freeN(labels);
+  BLF_unload_id(fontid);
+  BLF_exit();
+}
+
+TEST(blf_layout, Ascii_100)
+{
+  blf_layout_test_do("ASCII", "Modifier Properties", 2000, 0, 100);
+}
+
+TEST(blf_layout, Latin1_100)
+{
+  blf_layout_test_do("Latin-1", "Propriétés du modificateur à côté", 2000, 0, 100);
+}
+
+/* More labels than the glyph cache keeps layouts of. */
+TEST(blf_layout, Ascii_Many_100)
+{
+  blf_layout_test_do("ASCII many", "Modifier Properties", 10000, 0, 100);
+}
+
+/* Over 4096 different labels in total, but fewer on each redraw. */
+TEST(blf_layout, Ascii_Changing_100)
+{
+  blf_layout_test_do("ASCII changing", "Modifier Properties", 2000, 200, 100);
+}
@@ -0,0 +1,113 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_object.h"
+
+#include "DNA_object_types.h"
+
+#include "PIL_time.h"
+
+/* Creation and renaming of many IDs with the same base name, as done by scripts or when appending
+ * big libraries. Each new name has to be made unique among all the IDs of the same type. */
+
+class IDNamePerformanceTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+static double id_names_rename(Main *bmain, ID **ids, const int ids_num, const bool use_name_map)
+{
+  const char *names[2] = {"Renamed", "Object"};
+
+  const double time = PIL_check_seconds_timer();
+  for (int i = 0; i < ARRAY_SIZE(names); i++) {
+    for (int j = 0; j < ids_num; j++) {
+      /* Without Main, the name registry is not used and all objects are checked. */
+      BKE_id_new_name_validate(use_name_map ? bmain : NULL, &bmain->objects, ids[j], names[i]);
+    }
+  }
+  return PIL_check_seconds_timer() - time;
+}
+
+static void id_names_test(const int ids_num)
+{
+  Main *bmain[2];
+  double time_create[2], time_rename[2];
+
+  for (int i = 0; i < 2; i++) {
+    const bool use_name_map = (i == 1);
+    ID **ids = (ID **)MEM_mallocN(sizeof(*ids) * ids_num, __func__);
+    bmain[i] = BKE_main_new();
+
+    /* Creation always goes through the name registry. */
+    double time = PIL_check_seconds_timer();
+    for (int j = 0; j < ids_num; j++) {
+      ids[j] = &BKE_object_add_only_object(bmain[i], OB_EMPTY, "Object")->id;
+    }
+    time_create[i] = PIL_check_seconds_timer() - time;
+
+    time_rename[i] = id_names_rename(bmain[i], ids, ids_num, use_name_map);
+    MEM_freeN(ids);
+  }
+
+  printf("\t%d objects\n", ids_num);
+  printf("\t\tCreate: %fs\n", time_create[1]);
+  printf("\t\tRename, list scan: %fs\n", time_rename[0]);
+  printf("\t\tRename, name registry: %fs\n", time_rename[1]);
+
+  /* Both give the same names, in the same order. */
+  ID *id_a = (ID *)bmain[0]->objects.first;
+  ID *id_b = (ID *)bmain[1]->objects.first;
+  for (; id_a && id_b; id_a = (ID *)id_a->next, id_b = (ID *)id_b->next) {
+    EXPECT_STREQ(id_a->name, id_b->name);
+  }
+  EXPECT_EQ(id_a, id_b);
+  EXPECT_EQ(ids_num, BLI_listbase_count(&bmain[1]->objects));
+
+  BKE_main_free(bmain[0]);
+  BKE_main_free(bmain[1]);
+}
+
+TEST_F(IDNamePerformanceTest, CreateRename_10K)
+{
+  id_names_test(10000);
+}
+
+TEST_F(IDNamePerformanceTest, CreateRename_50K)
+{
+  id_names_test(50000);
+}
@@ -0,0 +1,216 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_mask.h"
+
+#include "DNA_curve_types.h"
+#include "DNA_mask_types.h"
+#include "DNA_scene_types.h"
+
+/* Rasterized masks are cached between initializations, check that editing the mask still gives
+ * a different result, and that the scanline buffer matches sampling each pixel. */
+
+#define RASTER_WIDTH 97
+#define RASTER_HEIGHT 61
+
+class MaskRasterizeTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_maskrasterize_cache_free();
+    BLI_threadapi_exit();
+  }
+};
+
+/* Add a closed spline with auto handles through the corners of a rectangle, with a feather.
+ * Corners are in clockwise order, for the feather to be outside. */
+static MaskSpline *mask_spline_add_rect(MaskLayer *masklay,
+                                        const float min[2],
+                                        const float max[2],
+                                        const float feather)
+{
+  const float corners[4][2] = {
+      {min[0], min[1]}, {min[0], max[1]}, {max[0], max[1]}, {max[0], min[1]}};
+  MaskSpline *spline = BKE_mask_spline_add(masklay);
+
+  spline->flag |= MASK_SPLINE_CYCLIC;
+  spline->tot_point = ARRAY_SIZE(corners);
+  spline->points = (MaskSplinePoint *)MEM_recallocN(spline->points,
+                                                    sizeof(*spline->points) * spline->tot_point);
+
+  for (int i = 0; i < spline->tot_point; i++) {
+    BezTriple *bezt = &spline->points[i].bezt;
+    for (int j = 0; j < 3; j++) {
+      copy_v2_v2(bezt->vec[j], corners[i]);
+    }
+    bezt->h1 = bezt->h2 = HD_AUTO;
+    bezt->weight = feather;
+  }
+
+  return spline;
+}
+
+static Mask *mask_create(void)
+{
+  Mask *mask = (Mask *)MEM_callocN(sizeof(Mask), __func__);
+
+  MaskLayer *masklay = BKE_mask_layer_new(mask, "Base");
+  const float min_a[2] = {0.2f, 0.25f}, max_a[2] = {0.7f, 0.8f};
+  MaskSpline *spline = mask_spline_add_rect(masklay, min_a, max_a, 0.05f);
+  /* Feather point along a segment. */
+  BKE_mask_point_add_uw(&spline->points[2], 0.5f, 1.0f);
+
+  masklay = BKE_mask_layer_new(mask, "Hole");
+  masklay->blend = MASK_BLEND_SUBTRACT;
+  masklay->alpha = 0.75f;
+  masklay->falloff = PROP_LIN;
+  const float min_b[2] = {0.4f, 0.1f}, max_b[2] = {0.9f, 0.5f};
+  mask_spline_add_rect(masklay, min_b, max_b, 0.1f);
+
+  masklay = BKE_mask_layer_new(mask, "Inverted");
+  masklay->blend = MASK_BLEND_LIGHTEN;
+  masklay->blend_flag = MASK_BLENDFLAG_INVERT;
+  masklay->alpha = 0.25f;
+  const float min_c[2] = {0.05f, 0.05f}, max_c[2] = {0.95f, 0.95f};
+  mask_spline_add_rect(masklay, min_c, max_c, 0.02f);
+
+  LISTBASE_FOREACH (MaskLayer *, masklay_iter, &mask->masklayers) {
+    BKE_mask_layer_calc_handles(masklay_iter);
+  }
+
+  return mask;
+}
+
+static void mask_free(Mask *mask)
+{
+  BKE_mask_layer_free_list(&mask->masklayers);
+  MEM_freeN(mask);
+}
+
+static float *mask_rasterize(Mask *mask)
+{
+  float *buffer = (float *)MEM_mallocN(sizeof(*buffer) * RASTER_WIDTH * RASTER_HEIGHT,
+                                       __func__);
+  MaskRasterHandle *mr_handle = BKE_maskrasterize_handle_new();
+  BKE_maskrasterize_handle_init(mr_handle, mask, RASTER_WIDTH, RASTER_HEIGHT, true, true, true);
+  BKE_maskrasterize_buffer(mr_handle, RASTER_WIDTH, RASTER_HEIGHT, buffer);
+  BKE_maskrasterize_handle_free(mr_handle);
+  return buffer;
+}
+
+/* Amount of pixels with a different value. */
+static int mask_buffer_diff(const float *buffer_a, const float *buffer_b)
+{
+  int diff = 0;
+  for (int i = 0; i < RASTER_WIDTH * RASTER_HEIGHT; i++) {
+    if (buffer_a[i] != buffer_b[i]) {
+      diff++;
+    }
+  }
+  return diff;
+}
+
+/* Rasterize the mask after an edit, check it changes the result, and that undoing the edit gives
+ * the initial result back. */
+template<typename T>
+static void mask_edit_test(
+    Mask *mask, const float *buffer_orig, const char *edit_name, T *value, const T edit)
+{
+  SCOPED_TRACE(edit_name);
+  const T value_orig = *value;
+
+  *value = edit;
+  float *buffer = mask_rasterize(mask);
+  EXPECT_GT(mask_buffer_diff(buffer_orig, buffer), 0);
+  MEM_freeN(buffer);
+
+  *value = value_orig;
+  buffer = mask_rasterize(mask);
+  EXPECT_EQ(mask_buffer_diff(buffer_orig, buffer), 0);
+  MEM_freeN(buffer);
+}
+
+TEST_F(MaskRasterizeTest, EditAfterCache)
+{
+  Mask *mask = mask_create();
+  MaskLayer *masklay = (MaskLayer *)mask->masklayers.first;
+  MaskSplinePoint *point = &((MaskSpline *)masklay->splines.first)->points[2];
+
+  float *buffer_orig = mask_rasterize(mask);
+  /* Initialized again from the cache. */
+  float *buffer = mask_rasterize(mask);
+  EXPECT_EQ(mask_buffer_diff(buffer_orig, buffer), 0);
+  MEM_freeN(buffer);
+
+  /* Edits of a point, its handle, its feather and the layer settings. */
+  mask_edit_test(mask, buffer_orig, "point", &point->bezt.vec[1][0], 0.6f);
+  mask_edit_test(mask, buffer_orig, "handle", &point->bezt.vec[0][1], 0.6f);
+  mask_edit_test(mask, buffer_orig, "feather", &point->bezt.weight, 0.15f);
+  mask_edit_test(mask, buffer_orig, "feather point", &point->uw[0].w, 0.2f);
+  mask_edit_test(mask, buffer_orig, "alpha", &masklay->alpha, 0.5f);
+  mask_edit_test(mask, buffer_orig, "falloff", &masklay->falloff, (char)PROP_LIN);
+  mask_edit_test(mask, buffer_orig, "invert", &masklay->blend_flag, (char)MASK_BLENDFLAG_INVERT);
+  mask_edit_test(mask, buffer_orig, "hide", &masklay->restrictflag, (char)MASK_RESTRICT_RENDER);
+
+  MEM_freeN(buffer_orig);
+  mask_free(mask);
+}
+
+TEST_F(MaskRasterizeTest, BufferMatchesSample)
+{
+  Mask *mask = mask_create();
+  float *buffer = (float *)MEM_mallocN(sizeof(*buffer) * RASTER_WIDTH * RASTER_HEIGHT,
+                                       __func__);
+
+  MaskRasterHandle *mr_handle = BKE_maskrasterize_handle_new();
+  BKE_maskrasterize_handle_init(mr_handle, mask, RASTER_WIDTH, RASTER_HEIGHT, true, true, true);
+  BKE_maskrasterize_buffer(mr_handle, RASTER_WIDTH, RASTER_HEIGHT, buffer);
+
+  /* Pixel centers, computed the same way as the buffer does. */
+  const float x_inv = 1.0f / (float)RASTER_WIDTH, y_inv = 1.0f / (float)RASTER_HEIGHT;
+  /* Not a trivial mask, feathers give some partially covered pixels. */
+  int partial = 0;
+  for (int y = 0; y < RASTER_HEIGHT; y++) {
+    for (int x = 0; x < RASTER_WIDTH; x++) {
+      const float xy[2] = {(float)x * x_inv + x_inv * 0.5f, (float)y * y_inv + y_inv * 0.5f};
+      const float value = buffer[y * RASTER_WIDTH + x];
+      EXPECT_EQ(BKE_maskrasterize_handle_sample(mr_handle, xy), value) << x << ", " << y;
+      if (value > 0.0f && value < 1.0f) {
+        partial++;
+      }
+    }
+  }
+  EXPECT_GT(partial, RASTER_WIDTH);
+
+  BKE_maskrasterize_handle_free(mr_handle);
+  MEM_freeN(buffer);
+  mask_free(mask);
+}
@@ -0,0 +1,165 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_geom.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_pbvh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "PIL_time.h"
+
+/* Build a PBVH for a grid mesh and move all vertices of every leaf, as a brush covering the
+ * whole mesh does, with the faces of the mesh in order and in random order. */
+
+class PBVHPerformanceTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+static Mesh *pbvh_test_grid_mesh(const int grid_size, const bool use_shuffle)
+{
+  const int verts_num = grid_size * grid_size;
+  const int polys_num = (grid_size - 1) * (grid_size - 1);
+  Mesh *me = BKE_mesh_new_nomain(verts_num, 0, 0, polys_num * 4, polys_num);
+
+  for (int y = 0; y < grid_size; y++) {
+    for (int x = 0; x < grid_size; x++) {
+      MVert *mv = &me->mvert[y * grid_size + x];
+      mv->co[0] = (float)x;
+      mv->co[1] = (float)y;
+      mv->co[2] = 0.0f;
+    }
+  }
+
+  MPoly *mp = me->mpoly;
+  MLoop *ml = me->mloop;
+  for (int y = 0; y < grid_size - 1; y++) {
+    for (int x = 0; x < grid_size - 1; x++, mp++) {
+      mp->loopstart = (int)(ml - me->mloop);
+      mp->totloop = 4;
+      (ml++)->v = (unsigned int)(y * grid_size + x);
+      (ml++)->v = (unsigned int)(y * grid_size + x + 1);
+      (ml++)->v = (unsigned int)((y + 1) * grid_size + x + 1);
+      (ml++)->v = (unsigned int)((y + 1) * grid_size + x);
+    }
+  }
+
+  if (use_shuffle) {
+    RNG *rng = BLI_rng_new(0);
+    BLI_rng_shuffle_array(rng, me->mpoly, sizeof(*me->mpoly), (unsigned int)polys_num);
+    BLI_rng_free(rng);
+  }
+
+  return me;
+}
+
+static void pbvh_test_do(const char *id, const int grid_size, const bool use_shuffle)
+{
+  const int iterations = 100;
+  Mesh *me = pbvh_test_grid_mesh(grid_size, use_shuffle);
+
+  const int looptri_num = poly_to_tri_count(me->totpoly, me->totloop);
+  MLoopTri *looptri = (MLoopTri *)MEM_mallocN(sizeof(*looptri) * looptri_num, __func__);
+  BKE_mesh_recalc_looptri(me->mloop, me->mpoly, me->mvert, me->totloop, me->totpoly, looptri);
+
+  double time = PIL_check_seconds_timer();
+  PBVH *pbvh = BKE_pbvh_new();
+  BKE_pbvh_build_mesh(pbvh,
+                      me,
+                      me->mpoly,
+                      me->mloop,
+                      me->mvert,
+                      me->totvert,
+                      &me->vdata,
+                      &me->ldata,
+                      &me->pdata,
+                      looptri,
+                      looptri_num);
+  const double time_build = PIL_check_seconds_timer() - time;
+
+  PBVHNode **nodes;
+  int nodes_num;
+  BKE_pbvh_search_gather(pbvh, NULL, NULL, &nodes, &nodes_num);
+
+  time = PIL_check_seconds_timer();
+  for (int iter = 0; iter < iterations; iter++) {
+    /* What #BKE_pbvh_vertex_iter_begin does for meshes, the macro is C only. */
+    for (int n = 0; n < nodes_num; n++) {
+      const int *vert_indices;
+      MVert *mverts;
+      int uniq_verts, totvert;
+      BKE_pbvh_node_num_verts(pbvh, nodes[n], &uniq_verts, &totvert);
+      BKE_pbvh_node_get_verts(pbvh, nodes[n], &vert_indices, &mverts);
+      for (int i = 0; i < uniq_verts; i++) {
+        mverts[vert_indices[i]].co[2] += 1.0f;
+      }
+    }
+  }
+  const double time_iter = PIL_check_seconds_timer() - time;
+
+  printf("%s: %d vertices, %d leaves\n", id, me->totvert, nodes_num);
+  printf("\tBuild: %fs\n", time_build);
+  printf("\tLeaf iteration, %d times: %fs\n", iterations, time_iter);
+
+  /* Every vertex is moved once per iteration. */
+  int verts_num = 0;
+  for (int n = 0; n < nodes_num; n++) {
+    int uniq_verts, totvert;
+    BKE_pbvh_node_num_verts(pbvh, nodes[n], &uniq_verts, &totvert);
+    verts_num += uniq_verts;
+  }
+  EXPECT_EQ(me->totvert, verts_num);
+  for (int i = 0; i < me->totvert; i++) {
+    EXPECT_EQ((float)iterations, me->mvert[i].co[2]);
+  }
+
+  MEM_freeN(nodes);
+  /* Also frees the looptris. */
+  BKE_pbvh_free(pbvh);
+  BKE_id_free(NULL, me);
+}
+
+TEST_F(PBVHPerformanceTest, Grid_1M)
+{
+  pbvh_test_do("Faces in order", 1000, false);
+}
+
+TEST_F(PBVHPerformanceTest, GridShuffled_1M)
+{
+  pbvh_test_do("Faces in random order", 1000, true);
+}
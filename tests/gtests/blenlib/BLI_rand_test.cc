@@ -0,0 +1,44 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+}
+
+/* Skipping gives the same values as getting them one by one. */
+static void rng_skip_test(const unsigned int seed, const int n)
+{
+  RNG *rng_step = BLI_rng_new(seed);
+  RNG *rng_skip = BLI_rng_new(seed);
+
+  unsigned int value = 0;
+  for (int i = 0; i < n; i++) {
+    value ^= BLI_rng_get_uint(rng_step);
+  }
+  UNUSED_VARS(value);
+  BLI_rng_skip(rng_skip, n);
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(BLI_rng_get_uint(rng_step), BLI_rng_get_uint(rng_skip));
+  }
+
+  BLI_rng_free(rng_step);
+  BLI_rng_free(rng_skip);
+}
+
+TEST(rand, SkipNone)
+{
+  rng_skip_test(0, 0);
+  rng_skip_test(31415926, -1);
+}
+
+TEST(rand, Skip)
+{
+  for (int n = 1; n <= 64; n++) {
+    rng_skip_test(31415926, n);
+  }
+  rng_skip_test(1, 1000);
+  rng_skip_test(31415926 + 12345, 3 * 1000003);
+}
@@ -0,0 +1,203 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdopbvh.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+#include "stubs/bf_intern_eigen_stubs.h"
+
+#define NUM_RUN_AVERAGED 10
+
+#define CLOTH_EDGE_LENGTH 0.01f
+#define CLOTH_SELF_DISTANCE 0.005f
+
+/* Self overlap of a dense, crumpled sheet of cloth: the triangles of a wrinkled grid which is
+ * squashed so that many of them come close to each other, as in a cloth self collision step. */
+
+typedef struct CrumpledCloth {
+  float (*co)[3];
+  float (*co_moving)[3];
+  int (*tris)[3];
+  int tris_len;
+} CrumpledCloth;
+
+static void crumpled_cloth_create(CrumpledCloth *cloth, const int res)
+{
+  struct RNG *rng = BLI_rng_new(1234);
+  const int verts_len = res * res;
+
+  cloth->co = (float(*)[3])MEM_mallocN(sizeof(*cloth->co) * verts_len, __func__);
+  cloth->co_moving = (float(*)[3])MEM_mallocN(sizeof(*cloth->co_moving) * verts_len, __func__);
+  cloth->tris = (int(*)[3])MEM_mallocN(sizeof(*cloth->tris) * (res - 1) * (res - 1) * 2,
+                                       __func__);
+  cloth->tris_len = 0;
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const float u = (float)x * CLOTH_EDGE_LENGTH, v = (float)y * CLOTH_EDGE_LENGTH;
+      float *co = cloth->co[y * res + x];
+      float offset[3];
+
+      /* Squash the sheet to a quarter of its size, folding it onto itself. */
+      co[0] = 0.25f * u + 0.1f * sinf(u * 8.0f);
+      co[1] = 0.25f * v + 0.1f * sinf(v * 7.0f + u * 1.5f);
+      co[2] = 0.2f * sinf(u * 5.0f) * cosf(v * 4.0f);
+
+      BLI_rng_get_float_unit_v3(rng, offset);
+      madd_v3_v3v3fl(cloth->co_moving[y * res + x], co, offset, 0.1f * CLOTH_EDGE_LENGTH);
+    }
+  }
+
+  for (int y = 0; y < res - 1; y++) {
+    for (int x = 0; x < res - 1; x++) {
+      const int i = y * res + x;
+      int *tri;
+      tri = cloth->tris[cloth->tris_len++];
+      tri[0] = i;
+      tri[1] = i + 1;
+      tri[2] = i + res + 1;
+      tri = cloth->tris[cloth->tris_len++];
+      tri[0] = i;
+      tri[1] = i + res + 1;
+      tri[2] = i + res;
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+static void crumpled_cloth_free(CrumpledCloth *cloth)
+{
+  MEM_freeN(cloth->co);
+  MEM_freeN(cloth->co_moving);
+  MEM_freeN(cloth->tris);
+}
+
+/* Ignore triangles sharing a vertex, like cloth self collision does. */
+static bool crumpled_cloth_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+  const CrumpledCloth *cloth = (const CrumpledCloth *)userdata;
+  if (index_a >= index_b) {
+    return false;
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      if (cloth->tris[index_a][i] == cloth->tris[index_b][j]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void crumpled_cloth_get_tri(const CrumpledCloth *cloth,
+                                   const float (*co)[3],
+                                   int index,
+                                   float r_co[3][3])
+{
+  for (int i = 0; i < 3; i++) {
+    copy_v3_v3(r_co[i], co[cloth->tris[index][i]]);
+  }
+}
+
+typedef struct HashUpdateData {
+  SpatialHash *hash;
+  const CrumpledCloth *cloth;
+} HashUpdateData;
+
+static void hash_update_item_cb(void *__restrict userdata,
+                                const int index,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  HashUpdateData *data = (HashUpdateData *)userdata;
+  float co[3][3], co_moving[3][3];
+  crumpled_cloth_get_tri(data->cloth, data->cloth->co, index, co);
+  crumpled_cloth_get_tri(data->cloth, data->cloth->co_moving, index, co_moving);
+  BLI_spatial_hash_update_item(data->hash, index, co[0], co_moving[0], 3);
+}
+
+static void self_overlap_test(const char *id, const int res)
+{
+  const float epsilon = CLOTH_SELF_DISTANCE;
+  CrumpledCloth cloth;
+  uint overlap_len_bvh = 0, overlap_len_hash = 0;
+
+  BLI_threadapi_init();
+  crumpled_cloth_create(&cloth, res);
+
+  /* BVH, as built and updated by the cloth modifier. */
+  BVHTree *tree = BLI_bvhtree_new(cloth.tris_len, epsilon, 4, 26);
+  for (int i = 0; i < cloth.tris_len; i++) {
+    float co[3][3];
+    crumpled_cloth_get_tri(&cloth, cloth.co, i, co);
+    BLI_bvhtree_insert(tree, i, co[0], 3);
+  }
+  BLI_bvhtree_balance(tree);
+
+  double time = PIL_check_seconds_timer();
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    for (int i = 0; i < cloth.tris_len; i++) {
+      float co[3][3], co_moving[3][3];
+      crumpled_cloth_get_tri(&cloth, cloth.co, i, co);
+      crumpled_cloth_get_tri(&cloth, cloth.co_moving, i, co_moving);
+      BLI_bvhtree_update_node(tree, i, co[0], co_moving[0], 3);
+    }
+    BLI_bvhtree_update_tree(tree);
+
+    BVHTreeOverlap *overlap = BLI_bvhtree_overlap(
+        tree, tree, &overlap_len_bvh, crumpled_cloth_overlap_cb, &cloth);
+    MEM_freeN(overlap);
+  }
+  const double time_bvh = (PIL_check_seconds_timer() - time) / NUM_RUN_AVERAGED;
+
+  /* Spatial hash. */
+  SpatialHash *hash = BLI_spatial_hash_new(cloth.tris_len, epsilon);
+  HashUpdateData data = {hash, &cloth};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  time = PIL_check_seconds_timer();
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    BLI_task_parallel_range(0, cloth.tris_len, &data, hash_update_item_cb, &settings);
+    BLI_spatial_hash_update(hash);
+
+    BVHTreeOverlap *overlap = BLI_spatial_hash_overlap_self(
+        hash, &overlap_len_hash, crumpled_cloth_overlap_cb, &cloth);
+    MEM_freeN(overlap);
+  }
+  const double time_hash = (PIL_check_seconds_timer() - time) / NUM_RUN_AVERAGED;
+
+  printf("\t%s: %d triangles\n", id, cloth.tris_len);
+  printf("\t\tBVH: %fs, %u candidate pairs\n", time_bvh, overlap_len_bvh);
+  printf("\t\tSpatial hash: %fs, %u candidate pairs\n", time_hash, overlap_len_hash);
+
+  /* Both bound the triangles with the same 26-DOP. */
+  EXPECT_EQ(overlap_len_bvh, overlap_len_hash);
+
+  BLI_spatial_hash_free(hash);
+  BLI_bvhtree_free(tree);
+  crumpled_cloth_free(&cloth);
+  BLI_threadapi_exit();
+}
+
+TEST(spatial_hash, SelfOverlapCrumpledCloth_20K)
+{
+  self_overlap_test("Crumpled cloth", 100);
+}
+
+TEST(spatial_hash, SelfOverlapCrumpledCloth_500K)
+{
+  self_overlap_test("Crumpled cloth", 500);
+}
@@ -0,0 +1,254 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <float.h>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdopbvh.h"
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_utildefines.h"
+}
+
+#include "stubs/bf_intern_eigen_stubs.h"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static bool overlap_pair_cmp(const BVHTreeOverlap &a, const BVHTreeOverlap &b)
+{
+  return (a.indexA != b.indexA) ? (a.indexA < b.indexA) : (a.indexB < b.indexB);
+}
+
+static bool overlap_pair_eq(const BVHTreeOverlap &a, const BVHTreeOverlap &b)
+{
+  return a.indexA == b.indexA && a.indexB == b.indexB;
+}
+
+#define KDOP_AXES 13
+
+static void kdop_add_point(float bounds[KDOP_AXES][2], const float co[3])
+{
+  for (int axis = 0; axis < KDOP_AXES; axis++) {
+    const float proj = dot_v3v3(co, bvhtree_kdop_axes[axis]);
+    bounds[axis][0] = min_ff(bounds[axis][0], proj);
+    bounds[axis][1] = max_ff(bounds[axis][1], proj);
+  }
+}
+
+static bool kdop_overlap(const float a[KDOP_AXES][2], const float b[KDOP_AXES][2])
+{
+  for (int axis = 0; axis < KDOP_AXES; axis++) {
+    if (a[axis][0] > b[axis][1] || b[axis][0] > a[axis][1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Check the hash finds the same pairs as testing every pair of items. */
+static void overlap_self_test(
+    int items_len, int points_len, float item_size, bool moving, float epsilon, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  SpatialHash *hash = BLI_spatial_hash_new(items_len, epsilon);
+  float(*bounds)[KDOP_AXES][2] = (float(*)[KDOP_AXES][2])MEM_mallocN(
+      sizeof(*bounds) * items_len, __func__);
+
+  for (int i = 0; i < items_len; i++) {
+    float co[3][3], co_moving[3][3], center[3];
+    BLI_rng_get_float_unit_v3(rng, center);
+
+    for (int axis = 0; axis < KDOP_AXES; axis++) {
+      bounds[i][axis][0] = FLT_MAX;
+      bounds[i][axis][1] = -FLT_MAX;
+    }
+    for (int j = 0; j < points_len; j++) {
+      BLI_rng_get_float_unit_v3(rng, co[j]);
+      madd_v3_v3v3fl(co[j], center, co[j], item_size);
+      kdop_add_point(bounds[i], co[j]);
+
+      BLI_rng_get_float_unit_v3(rng, co_moving[j]);
+      madd_v3_v3v3fl(co_moving[j], co[j], co_moving[j], item_size);
+      if (moving) {
+        kdop_add_point(bounds[i], co_moving[j]);
+      }
+    }
+    for (int axis = 0; axis < KDOP_AXES; axis++) {
+      bounds[i][axis][0] -= epsilon;
+      bounds[i][axis][1] += epsilon;
+    }
+
+    BLI_spatial_hash_update_item(hash, i, co[0], moving ? co_moving[0] : NULL, points_len);
+  }
+  BLI_spatial_hash_update(hash);
+
+  std::vector<BVHTreeOverlap> expected;
+  for (int a = 0; a < items_len; a++) {
+    for (int b = a + 1; b < items_len; b++) {
+      if (kdop_overlap(bounds[a], bounds[b])) {
+        expected.push_back({a, b});
+      }
+    }
+  }
+
+  uint overlap_len;
+  BVHTreeOverlap *overlap = BLI_spatial_hash_overlap_self(hash, &overlap_len, NULL, NULL);
+  std::vector<BVHTreeOverlap> result(overlap, overlap + overlap_len);
+  std::sort(result.begin(), result.end(), overlap_pair_cmp);
+
+  EXPECT_EQ(expected.size(), result.size());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), result.begin(), overlap_pair_eq));
+
+  MEM_freeN(overlap);
+  MEM_freeN(bounds);
+  BLI_spatial_hash_free(hash);
+  BLI_rng_free(rng);
+}
+
+static bool overlap_odd_cb(void *UNUSED(userdata), int index_a, int index_b, int UNUSED(thread))
+{
+  EXPECT_LT(index_a, index_b);
+  return (index_a + index_b) & 1;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(spatial_hash, Empty)
+{
+  SpatialHash *hash = BLI_spatial_hash_new(0, 0.0f);
+  BLI_spatial_hash_update(hash);
+
+  uint overlap_len;
+  BVHTreeOverlap *overlap = BLI_spatial_hash_overlap_self(hash, &overlap_len, NULL, NULL);
+  EXPECT_EQ(0, BLI_spatial_hash_get_len(hash));
+  EXPECT_EQ(0, overlap_len);
+
+  MEM_freeN(overlap);
+  BLI_spatial_hash_free(hash);
+}
+
+TEST(spatial_hash, SamePoint)
+{
+  const float co[3] = {1.0f, 2.0f, 3.0f};
+  SpatialHash *hash = BLI_spatial_hash_new(3, 0.0f);
+  for (int i = 0; i < 3; i++) {
+    BLI_spatial_hash_update_item(hash, i, co, NULL, 1);
+  }
+  BLI_spatial_hash_update(hash);
+
+  uint overlap_len;
+  BVHTreeOverlap *overlap = BLI_spatial_hash_overlap_self(hash, &overlap_len, NULL, NULL);
+  EXPECT_EQ(3, overlap_len);
+
+  MEM_freeN(overlap);
+  BLI_spatial_hash_free(hash);
+}
+
+TEST(spatial_hash, Callback)
+{
+  const float co[3] = {0.0f, 0.0f, 0.0f};
+  SpatialHash *hash = BLI_spatial_hash_new(4, 0.1f);
+  for (int i = 0; i < 4; i++) {
+    BLI_spatial_hash_update_item(hash, i, co, NULL, 1);
+  }
+  BLI_spatial_hash_update(hash);
+
+  uint overlap_len;
+  BVHTreeOverlap *overlap = BLI_spatial_hash_overlap_self(
+      hash, &overlap_len, overlap_odd_cb, NULL);
+  /* (0, 1), (0, 3), (1, 2), (2, 3) */
+  EXPECT_EQ(4, overlap_len);
+
+  MEM_freeN(overlap);
+  BLI_spatial_hash_free(hash);
+}
+
+TEST(spatial_hash, OverlapSelf_Points)
+{
+  overlap_self_test(1000, 1, 0.0f, false, 0.05f, 1234);
+}
+
+TEST(spatial_hash, OverlapSelf_Triangles)
+{
+  overlap_self_test(2000, 3, 0.05f, false, 0.0f, 123);
+}
+
+TEST(spatial_hash, OverlapSelf_TrianglesMoving)
+{
+  overlap_self_test(2000, 3, 0.05f, true, 0.01f, 12);
+}
+
+TEST(spatial_hash, OverlapSelf_MixedSizes)
+{
+  overlap_self_test(500, 3, 0.5f, false, 0.0f, 1);
+}
+
+/* Items are updated and the hash is rebuilt, as in a simulation. */
+TEST(spatial_hash, Rebuild)
+{
+  SpatialHash *hash = BLI_spatial_hash_new(2, 0.0f);
+  const float co_a[3] = {0.0f, 0.0f, 0.0f}, co_b[3] = {0.0f, 0.0f, 0.5f};
+  const float co_far[3] = {10.0f, 0.0f, 0.0f};
+  uint overlap_len;
+  BVHTreeOverlap *overlap;
+
+  BLI_spatial_hash_update_item(hash, 0, co_a, co_b, 1);
+  BLI_spatial_hash_update_item(hash, 1, co_b, NULL, 1);
+  BLI_spatial_hash_update(hash);
+  overlap = BLI_spatial_hash_overlap_self(hash, &overlap_len, NULL, NULL);
+  EXPECT_EQ(1, overlap_len);
+  MEM_freeN(overlap);
+
+  BLI_spatial_hash_update_item(hash, 1, co_far, NULL, 1);
+  BLI_spatial_hash_update(hash);
+  overlap = BLI_spatial_hash_overlap_self(hash, &overlap_len, NULL, NULL);
+  EXPECT_EQ(0, overlap_len);
+  MEM_freeN(overlap);
+
+  BLI_spatial_hash_free(hash);
+}
+
+/* Degenerate items spanning all others must not be put in every cell of the grid. */
+TEST(spatial_hash, HugeItems)
+{
+  const int items_len = 1000;
+  struct RNG *rng = BLI_rng_new(42);
+  SpatialHash *hash = BLI_spatial_hash_new(items_len + 2, 0.0f);
+
+  for (int i = 0; i < items_len; i++) {
+    float co[3];
+    BLI_rng_get_float_unit_v3(rng, co);
+    BLI_spatial_hash_update_item(hash, i, co, NULL, 1);
+  }
+  float co_huge[8][3];
+  for (int j = 0; j < 8; j++) {
+    for (int k = 0; k < 3; k++) {
+      co_huge[j][k] = (j & (1 << k)) ? 1e6f : -1e6f;
+    }
+  }
+  BLI_spatial_hash_update_item(hash, items_len, co_huge[0], NULL, 8);
+  BLI_spatial_hash_update_item(hash, items_len + 1, co_huge[0], NULL, 8);
+  BLI_spatial_hash_update(hash);
+
+  uint overlap_len;
+  BVHTreeOverlap *overlap = BLI_spatial_hash_overlap_self(hash, &overlap_len, NULL, NULL);
+  /* Every point with both huge items, and the huge items with each other. */
+  EXPECT_EQ(items_len * 2 + 1, overlap_len);
+  for (uint i = 0; i < overlap_len; i++) {
+    EXPECT_LT(overlap[i].indexA, overlap[i].indexB);
+    EXPECT_GE(overlap[i].indexB, items_len);
+  }
+
+  MEM_freeN(overlap);
+  BLI_spatial_hash_free(hash);
+  BLI_rng_free(rng);
+}
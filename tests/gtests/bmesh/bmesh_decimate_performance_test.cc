@@ -0,0 +1,83 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+#include "bmesh.h"
+#include "bmesh_tools.h"
+
+/* Decimate a triangulated height field with some noise, similar to a scanned surface. */
+static BMesh *scan_mesh_create(const int res)
+{
+  BMeshCreateParams bm_params = {0};
+  BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+  struct RNG *rng = BLI_rng_new(1234);
+  BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * res * res, __func__);
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const float u = (float)x / (float)res, v = (float)y / (float)res;
+      float co[3] = {u, v, 0.1f * sinf(u * 12.0f) * cosf(v * 9.0f)};
+      co[2] += 0.002f * (BLI_rng_get_float(rng) - 0.5f);
+      verts[y * res + x] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+    }
+  }
+
+  for (int y = 0; y < res - 1; y++) {
+    for (int x = 0; x < res - 1; x++) {
+      BMVert *v00 = verts[y * res + x], *v10 = verts[y * res + x + 1];
+      BMVert *v01 = verts[(y + 1) * res + x], *v11 = verts[(y + 1) * res + x + 1];
+      BMVert *tri_a[3] = {v00, v10, v11};
+      BMVert *tri_b[3] = {v00, v11, v01};
+      BM_face_create_verts(bm, tri_a, 3, NULL, BM_CREATE_NOP, true);
+      BM_face_create_verts(bm, tri_b, 3, NULL, BM_CREATE_NOP, true);
+    }
+  }
+
+  MEM_freeN(verts);
+  BLI_rng_free(rng);
+
+  BM_mesh_normals_update(bm);
+  BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+  return bm;
+}
+
+static void decimate_collapse_test(const char *id, const int res, const float factor)
+{
+  BLI_threadapi_init();
+
+  BMesh *bm = scan_mesh_create(res);
+  const int totface_orig = bm->totface;
+
+  const double time = PIL_check_seconds_timer();
+  BM_mesh_decimate_collapse(bm, factor, NULL, 1.0f, false, -1, 0.0f);
+  const double time_decimate = PIL_check_seconds_timer() - time;
+
+  printf("\t%s: %d -> %d triangles\n", id, totface_orig, bm->totface);
+  printf("\t\tCollapse: %fs\n", time_decimate);
+
+  EXPECT_LE(bm->totface, (int)((float)totface_orig * factor) + 2);
+
+  BM_mesh_free(bm);
+  BLI_threadapi_exit();
+}
+
+TEST(bmesh_decimate, CollapseScan_500K)
+{
+  decimate_collapse_test("Scan", 500, 0.1f);
+}
+
+TEST(bmesh_decimate, CollapseScan_8M)
+{
+  decimate_collapse_test("Scan", 2000, 0.1f);
+}
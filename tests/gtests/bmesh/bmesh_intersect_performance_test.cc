@@ -0,0 +1,106 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+#include "bmesh.h"
+
+extern "C" {
+#include "tools/bmesh_intersect.h"
+}
+
+/* Intersect two wavy surfaces crossing each other many times. Most triangles are close enough to
+ * triangles of the other surface for their bounds to overlap without touching them. */
+static void wave_grid_add(BMesh *bm, const int res, const float phase, const bool use_tag)
+{
+  BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * res * res, __func__);
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const float u = (float)x / (float)res, v = (float)y / (float)res;
+      const float co[3] = {u, v, 0.01f * sinf((u + v) * 40.0f + phase)};
+      verts[y * res + x] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+    }
+  }
+
+  for (int y = 0; y < res - 1; y++) {
+    for (int x = 0; x < res - 1; x++) {
+      BMVert *v00 = verts[y * res + x], *v10 = verts[y * res + x + 1];
+      BMVert *v01 = verts[(y + 1) * res + x], *v11 = verts[(y + 1) * res + x + 1];
+      BMVert *tri_a[3] = {v00, v10, v11};
+      BMVert *tri_b[3] = {v00, v11, v01};
+      BMFace *f_a = BM_face_create_verts(bm, tri_a, 3, NULL, BM_CREATE_NOP, true);
+      BMFace *f_b = BM_face_create_verts(bm, tri_b, 3, NULL, BM_CREATE_NOP, true);
+      BM_elem_flag_set(f_a, BM_ELEM_TAG, use_tag);
+      BM_elem_flag_set(f_b, BM_ELEM_TAG, use_tag);
+    }
+  }
+
+  MEM_freeN(verts);
+}
+
+static int bm_face_isect_tag(BMFace *f, void *UNUSED(user_data))
+{
+  return BM_elem_flag_test(f, BM_ELEM_TAG) ? 1 : 0;
+}
+
+static void intersect_waves_test(const char *id, const int res)
+{
+  BLI_threadapi_init();
+
+  BMeshCreateParams bm_params = {0};
+  BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+  wave_grid_add(bm, res, 0.0f, false);
+  wave_grid_add(bm, res, (float)M_PI, true);
+  BM_mesh_normals_update(bm);
+  const int totface_orig = bm->totface;
+
+  BMLoop *(*looptris)[3] = (BMLoop * (*)[3]) MEM_mallocN(sizeof(*looptris) * bm->totface,
+                                                          __func__);
+  int looptris_tot;
+  BM_mesh_calc_tessellation(bm, looptris, &looptris_tot);
+
+  const double time = PIL_check_seconds_timer();
+  const bool changed = BM_mesh_intersect(bm,
+                                         looptris,
+                                         looptris_tot,
+                                         bm_face_isect_tag,
+                                         NULL,
+                                         false,
+                                         false,
+                                         true,
+                                         true,
+                                         true,
+                                         false,
+                                         BMESH_ISECT_BOOLEAN_NONE,
+                                         0.000001f);
+  const double time_intersect = PIL_check_seconds_timer() - time;
+
+  printf("\t%s: %d -> %d faces\n", id, totface_orig, bm->totface);
+  printf("\t\tIntersect: %fs\n", time_intersect);
+
+  EXPECT_TRUE(changed);
+
+  MEM_freeN(looptris);
+  BM_mesh_free(bm);
+  BLI_threadapi_exit();
+}
+
+TEST(bmesh_intersect, Waves_100K)
+{
+  intersect_waves_test("Waves", 225);
+}
+
+TEST(bmesh_intersect, Waves_1M)
+{
+  intersect_waves_test("Waves", 710);
+}
@@ -0,0 +1,146 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+}
+
+#include "bmesh.h"
+
+extern "C" {
+#include "tools/bmesh_intersect.h"
+}
+
+/* Intersect two triangles, as the intersect (knife) tool does for a selected and an unselected
+ * face. The triangle pairs are chosen around the cases the BVH overlap callback culls: these
+ * check it never culls a pair the intersection would have cut. */
+
+/* Default threshold of the intersect tool. */
+#define ISECT_EPS 0.000001f
+
+struct IsectResult {
+  bool changed;
+  int totvert, totedge, totface;
+};
+
+static int bm_face_isect_tag(BMFace *f, void *UNUSED(user_data))
+{
+  return BM_elem_flag_test(f, BM_ELEM_TAG) ? 1 : 0;
+}
+
+static void bm_tri_create(BMesh *bm, const float cos[3][3], const bool use_tag)
+{
+  BMVert *verts[3];
+  for (int i = 0; i < 3; i++) {
+    verts[i] = BM_vert_create(bm, cos[i], NULL, BM_CREATE_NOP);
+  }
+  BMFace *f = BM_face_create_verts(bm, verts, 3, NULL, BM_CREATE_NOP, true);
+  BM_elem_flag_set(f, BM_ELEM_TAG, use_tag);
+}
+
+static IsectResult intersect_tris(const float tri_a[3][3],
+                                  const float tri_b[3][3],
+                                  const float eps)
+{
+  BLI_threadapi_init();
+
+  BMeshCreateParams bm_params = {0};
+  BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+  bm_tri_create(bm, tri_a, false);
+  bm_tri_create(bm, tri_b, true);
+  BM_mesh_normals_update(bm);
+
+  BMLoop *(*looptris)[3] = (BMLoop * (*)[3]) MEM_mallocN(sizeof(*looptris) * bm->totface,
+                                                          __func__);
+  int looptris_tot;
+  BM_mesh_calc_tessellation(bm, looptris, &looptris_tot);
+
+  IsectResult result;
+  result.changed = BM_mesh_intersect(bm,
+                                     looptris,
+                                     looptris_tot,
+                                     bm_face_isect_tag,
+                                     NULL,
+                                     false,
+                                     false,
+                                     true,
+                                     true,
+                                     true,
+                                     false,
+                                     BMESH_ISECT_BOOLEAN_NONE,
+                                     eps);
+  result.totvert = bm->totvert;
+  result.totedge = bm->totedge;
+  result.totface = bm->totface;
+
+  MEM_freeN(looptris);
+  BM_mesh_free(bm);
+  BLI_threadapi_exit();
+  return result;
+}
+
+/* The triangle of the other mesh is on either side of the overlap, check both. */
+static void intersect_tris_test(const float tri_a[3][3],
+                                const float tri_b[3][3],
+                                const bool changed,
+                                const int totvert,
+                                const int totedge,
+                                const int totface,
+                                const float eps = ISECT_EPS)
+{
+  for (int i = 0; i < 2; i++) {
+    const IsectResult result = (i == 0) ? intersect_tris(tri_a, tri_b, eps) :
+                                          intersect_tris(tri_b, tri_a, eps);
+    EXPECT_EQ(changed, result.changed);
+    EXPECT_EQ(totvert, result.totvert);
+    EXPECT_EQ(totedge, result.totedge);
+    EXPECT_EQ(totface, result.totface);
+  }
+}
+
+static const float tri_ground[3][3] = {{0.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 0.0f}, {0.0f, 2.0f, 0.0f}};
+
+TEST(bmesh_intersect, TriTriCrossing)
+{
+  const float tri[3][3] = {{0.5f, 0.5f, -1.0f}, {0.5f, 0.5f, 1.0f}, {1.0f, -0.5f, 0.0f}};
+  intersect_tris_test(tri_ground, tri, true, 8, 11, 4);
+}
+
+TEST(bmesh_intersect, TriTriCoplanar)
+{
+  const float tri[3][3] = {{1.0f, -1.0f, 0.0f}, {1.0f, 3.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}};
+  intersect_tris_test(tri_ground, tri, true, 9, 13, 3);
+}
+
+TEST(bmesh_intersect, TriTriEdgeInFace)
+{
+  const float tri[3][3] = {{0.2f, 0.5f, 0.0f}, {1.2f, 0.5f, 0.0f}, {0.7f, 0.5f, 1.0f}};
+  intersect_tris_test(tri_ground, tri, true, 6, 8, 3);
+}
+
+TEST(bmesh_intersect, TriTriEdgeOnEdge)
+{
+  const float tri[3][3] = {{0.5f, 0.0f, 0.0f}, {1.5f, 0.0f, 0.0f}, {1.0f, -1.0f, 1.0f}};
+  intersect_tris_test(tri_ground, tri, true, 7, 9, 3);
+}
+
+/* Not touching, but closer than the threshold: cut as if it was touching. Uses a larger threshold
+ * than the default one, which is below float precision at this scale. */
+TEST(bmesh_intersect, TriTriEdgeInEpsilon)
+{
+  const float eps = 0.001f;
+  const float tri[3][3] = {
+      {0.2f, 0.5f, eps * 0.5f}, {1.2f, 0.5f, eps * 0.5f}, {0.7f, 0.5f, 1.0f}};
+  intersect_tris_test(tri_ground, tri, true, 6, 8, 3, eps);
+}
+
+TEST(bmesh_intersect, TriTriSeparated)
+{
+  const float tri[3][3] = {{0.5f, 0.5f, 0.01f}, {1.5f, 0.5f, 1.0f}, {0.5f, 1.5f, 1.0f}};
+  intersect_tris_test(tri_ground, tri, false, 6, 6, 2);
+}
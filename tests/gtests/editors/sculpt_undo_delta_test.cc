@@ -0,0 +1,130 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+
+#include "sculpt_undo_delta.h"
+}
+
+/* Sculpt undo nodes only keep the values of the elements a stroke changed, restoring swaps them
+ * with the mesh. */
+
+#define ELEM_NUM 100
+#define ELEM_LEN 3
+
+static float *undo_values_new(const float *values)
+{
+  float *copy = (float *)MEM_mallocN(sizeof(float) * ELEM_NUM * ELEM_LEN, __func__);
+  memcpy(copy, values, sizeof(float) * ELEM_NUM * ELEM_LEN);
+  return copy;
+}
+
+static SculptUndoDelta *undo_delta_encode(const float *before, float *after)
+{
+  SculptUndoDelta *delta = SCULPT_undo_delta_new(
+      (uint *)undo_values_new(before), ELEM_NUM, ELEM_LEN);
+  for (int i = 0; i < ELEM_NUM; i++) {
+    SCULPT_undo_delta_add(delta, i, (const uint *)&after[i * ELEM_LEN]);
+  }
+  SCULPT_undo_delta_finish(delta);
+  return delta;
+}
+
+static int undo_delta_swap(SculptUndoDelta *delta, float *mesh)
+{
+  int changed_num = 0, value = 0;
+  for (int i = 0; i < ELEM_NUM; i++) {
+    changed_num += SCULPT_undo_delta_swap(delta, i, &value, (uint *)&mesh[i * ELEM_LEN]);
+  }
+  return changed_num;
+}
+
+/* A stroke changing every tenth element. */
+static void undo_stroke(float before[ELEM_NUM * ELEM_LEN], float after[ELEM_NUM * ELEM_LEN])
+{
+  for (int i = 0; i < ELEM_NUM * ELEM_LEN; i++) {
+    before[i] = after[i] = (float)i * 0.1f;
+  }
+  for (int i = 0; i < ELEM_NUM; i += 10) {
+    after[i * ELEM_LEN + 1] += 1.0f;
+  }
+}
+
+TEST(sculpt_undo_delta, UndoRedo)
+{
+  float before[ELEM_NUM * ELEM_LEN], after[ELEM_NUM * ELEM_LEN], mesh[ELEM_NUM * ELEM_LEN];
+  undo_stroke(before, after);
+
+  SculptUndoDelta *delta = undo_delta_encode(before, after);
+  EXPECT_LT(SCULPT_undo_delta_size(delta), sizeof(before));
+
+  memcpy(mesh, after, sizeof(mesh));
+  EXPECT_EQ(undo_delta_swap(delta, mesh), ELEM_NUM / 10);
+  EXPECT_EQ(memcmp(mesh, before, sizeof(mesh)), 0);
+
+  EXPECT_EQ(undo_delta_swap(delta, mesh), ELEM_NUM / 10);
+  EXPECT_EQ(memcmp(mesh, after, sizeof(mesh)), 0);
+
+  SCULPT_undo_delta_free(delta);
+}
+
+/* The mesh differs slightly from the state after the stroke, as when multires grids are
+ * evaluated again. Changed elements still get their exact values back. */
+TEST(sculpt_undo_delta, UndoChangedMesh)
+{
+  float before[ELEM_NUM * ELEM_LEN], after[ELEM_NUM * ELEM_LEN], mesh[ELEM_NUM * ELEM_LEN];
+  undo_stroke(before, after);
+
+  SculptUndoDelta *delta = undo_delta_encode(before, after);
+
+  memcpy(mesh, after, sizeof(mesh));
+  for (int i = 0; i < ELEM_NUM * ELEM_LEN; i++) {
+    mesh[i] += 1e-6f;
+  }
+  undo_delta_swap(delta, mesh);
+
+  for (int i = 0; i < ELEM_NUM; i++) {
+    for (int j = 0; j < ELEM_LEN; j++) {
+      const int k = i * ELEM_LEN + j;
+      if (i % 10 == 0) {
+        EXPECT_EQ(mesh[k], before[k]);
+      }
+      else {
+        EXPECT_EQ(mesh[k], after[k] + 1e-6f);
+      }
+    }
+  }
+
+  SCULPT_undo_delta_free(delta);
+}
+
+TEST(sculpt_undo_delta, Unchanged)
+{
+  float before[ELEM_NUM * ELEM_LEN], after[ELEM_NUM * ELEM_LEN];
+  undo_stroke(before, after);
+
+  SculptUndoDelta *delta = undo_delta_encode(before, before);
+  EXPECT_EQ(undo_delta_swap(delta, after), 0);
+  SCULPT_undo_delta_free(delta);
+}
@@ -0,0 +1,139 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+extern "C" {
+#include "DNA_genfile.h" /* for DNA_sdna_current_init() */
+}
+
+#include "RNA_access.h"
+#include "RNA_define.h"
+
+#include "PIL_time.h"
+
+/* Bulk access to mesh data through RNA, as done by `foreach_get` and `foreach_set` in Python.
+ * Values are either copied as is, or converted when the array type differs from the one of the
+ * property (e.g. double precision arrays for vertex coordinates). */
+
+class RNARawAccessPerformanceTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_idtype_init();
+    RNA_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    RNA_exit();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+  }
+};
+
+static double raw_access(PointerRNA *ptr,
+                         PropertyRNA *prop,
+                         const char *propname,
+                         void *array,
+                         RawPropertyType type,
+                         int len,
+                         bool set)
+{
+  const double time = PIL_check_seconds_timer();
+  const int ok = set ? RNA_property_collection_raw_set(
+                           NULL, ptr, prop, propname, array, type, len) :
+                       RNA_property_collection_raw_get(
+                           NULL, ptr, prop, propname, array, type, len);
+  EXPECT_TRUE(ok);
+  return PIL_check_seconds_timer() - time;
+}
+
+static void raw_access_test(const int verts_num)
+{
+  Main *bmain = BKE_main_new();
+  Mesh *mesh = BKE_mesh_add(bmain, "Mesh");
+  mesh->mvert = (MVert *)CustomData_add_layer(
+      &mesh->vdata, CD_MVERT, CD_CALLOC, NULL, verts_num);
+  mesh->totvert = verts_num;
+
+  PointerRNA ptr;
+  RNA_id_pointer_create(&mesh->id, &ptr);
+  PropertyRNA *prop = RNA_struct_find_property(&ptr, "vertices");
+
+  const int len = verts_num * 3;
+  float *co_f = (float *)MEM_mallocN(sizeof(*co_f) * len, __func__);
+  double *co_d = (double *)MEM_mallocN(sizeof(*co_d) * len, __func__);
+  for (int i = 0; i < len; i++) {
+    co_d[i] = (double)i * 0.5;
+  }
+
+  printf("\t%d vertices\n", verts_num);
+  printf("\t\tSet double: %fs\n", raw_access(&ptr, prop, "co", co_d, PROP_RAW_DOUBLE, len, true));
+  printf("\t\tGet float: %fs\n", raw_access(&ptr, prop, "co", co_f, PROP_RAW_FLOAT, len, false));
+  for (int i = 0; i < len; i++) {
+    EXPECT_EQ(co_f[i], (float)co_d[i]);
+  }
+
+  for (int i = 0; i < len; i++) {
+    co_f[i] = -(float)i;
+  }
+  printf("\t\tSet float: %fs\n", raw_access(&ptr, prop, "co", co_f, PROP_RAW_FLOAT, len, true));
+  printf("\t\tGet double: %fs\n", raw_access(&ptr, prop, "co", co_d, PROP_RAW_DOUBLE, len, false));
+  for (int i = 0; i < len; i++) {
+    EXPECT_EQ(co_d[i], (double)co_f[i]);
+  }
+
+  /* Per item access, as done for properties without raw access. */
+  double time = PIL_check_seconds_timer();
+  int index = 0;
+  RNA_PROP_BEGIN (&ptr, itemptr, prop) {
+    RNA_float_get_array(&itemptr, "co", &co_f[index]);
+    index += 3;
+  }
+  RNA_PROP_END;
+  printf("\t\tGet float, per item: %fs\n", PIL_check_seconds_timer() - time);
+
+  MEM_freeN(co_f);
+  MEM_freeN(co_d);
+  BKE_main_free(bmain);
+}
+
+TEST_F(RNARawAccessPerformanceTest, MeshVertices_100K)
+{
+  raw_access_test(100000);
+}
+
+TEST_F(RNARawAccessPerformanceTest, MeshVertices_1M)
+{
+  raw_access_test(1000000);
+}
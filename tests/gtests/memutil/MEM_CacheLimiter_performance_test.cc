@@ -0,0 +1,195 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_CacheLimiterC-Api.h"
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+/* Stress the cache limiter the way the movie cache does: every insertion is followed by
+ * enforcing the limits, lookups touch random items, and the item priority depends on the
+ * distance to the current frame. */
+
+typedef struct CacheItem {
+  int frame;
+  size_t size;
+} CacheItem;
+
+static int current_frame = 0;
+static int items_freed = 0;
+/* Handles of the items by frame, NULL once freed by the limiter. */
+static MEM_CacheLimiterHandleC **handles = NULL;
+
+static void cache_item_destruct(void *data)
+{
+  handles[((CacheItem *)data)->frame] = NULL;
+  items_freed++;
+  MEM_freeN(data);
+}
+
+static size_t cache_item_size(void *data)
+{
+  return ((CacheItem *)data)->size;
+}
+
+static int cache_item_priority(void *data, int UNUSED(default_priority))
+{
+  return -abs(((CacheItem *)data)->frame - current_frame);
+}
+
+static void cache_insert(MEM_CacheLimiterC *cache, const int frame)
+{
+  CacheItem *item = (CacheItem *)MEM_mallocN(sizeof(*item), __func__);
+  item->frame = frame;
+  item->size = 1;
+
+  MEM_CacheLimiterHandleC *handle = MEM_CacheLimiter_insert(cache, item);
+  handles[frame] = handle;
+  MEM_CacheLimiter_ref(handle);
+  MEM_CacheLimiter_enforce_limits(cache);
+  MEM_CacheLimiter_unref(handle);
+}
+
+static MEM_CacheLimiterC *cache_new(const int items_num)
+{
+  handles = (MEM_CacheLimiterHandleC **)MEM_callocN(sizeof(*handles) * items_num, __func__);
+  items_freed = 0;
+  return new_MEM_CacheLimiter(cache_item_destruct, cache_item_size);
+}
+
+static void cache_free(MEM_CacheLimiterC *cache, const int items_num)
+{
+  /* The limiter does not free the items it still manages. */
+  for (int i = 0; i < items_num; i++) {
+    if (handles[i]) {
+      void *data = MEM_CacheLimiter_get(handles[i]);
+      MEM_CacheLimiter_unmanage(handles[i]);
+      MEM_freeN(data);
+    }
+  }
+  delete_MEM_CacheLimiter(cache);
+  MEM_freeN(handles);
+  handles = NULL;
+}
+
+static void cache_limiter_insert_test(const int items_num, const bool use_priority)
+{
+  const size_t max_prev = MEM_CacheLimiter_get_maximum();
+  MEM_CacheLimiter_set_maximum((size_t)items_num / 2);
+
+  MEM_CacheLimiterC *cache = cache_new(items_num);
+  if (use_priority) {
+    MEM_CacheLimiter_ItemPriority_Func_set(cache, cache_item_priority);
+  }
+  RNG *rng = BLI_rng_new(0);
+
+  const double time = PIL_check_seconds_timer();
+  for (int i = 0; i < items_num; i++) {
+    current_frame = i;
+    cache_insert(cache, i);
+
+    /* Look up some recent frames, like playback going back and forth. */
+    const int frame = i - (int)(BLI_rng_get_uint(rng) % 8);
+    if (frame >= 0 && handles[frame]) {
+      MEM_CacheLimiter_touch(handles[frame]);
+    }
+  }
+  printf("\t%d items, %s: %fs\n",
+         items_num,
+         use_priority ? "priority function" : "least recently used",
+         PIL_check_seconds_timer() - time);
+
+  EXPECT_EQ(MEM_CacheLimiter_get_memory_in_use(cache), (size_t)items_num / 2);
+  EXPECT_EQ(items_freed, items_num - items_num / 2);
+
+  BLI_rng_free(rng);
+  cache_free(cache, items_num);
+  MEM_CacheLimiter_set_maximum(max_prev);
+}
+
+/* Lowering the limit of a full cache, many items are freed at once. */
+static void cache_limiter_shrink_test(const int items_num)
+{
+  const size_t max_prev = MEM_CacheLimiter_get_maximum();
+  /* No limit while filling the cache. */
+  MEM_CacheLimiter_set_maximum(0);
+
+  MEM_CacheLimiterC *cache = cache_new(items_num);
+  MEM_CacheLimiter_ItemPriority_Func_set(cache, cache_item_priority);
+
+  for (int i = 0; i < items_num; i++) {
+    cache_insert(cache, i);
+  }
+  EXPECT_EQ(items_freed, 0);
+
+  current_frame = items_num / 2;
+  MEM_CacheLimiter_set_maximum((size_t)items_num / 10);
+
+  const double time = PIL_check_seconds_timer();
+  MEM_CacheLimiter_enforce_limits(cache);
+  printf("\t%d items, shrink to %d: %fs\n",
+         items_num,
+         items_num / 10,
+         PIL_check_seconds_timer() - time);
+
+  /* Only the frames closest to the current one are kept. */
+  EXPECT_EQ(items_freed, items_num - items_num / 10);
+  EXPECT_TRUE(handles[current_frame] != NULL);
+  EXPECT_TRUE(handles[current_frame - items_num / 25] != NULL);
+  EXPECT_TRUE(handles[current_frame + items_num / 25] != NULL);
+  EXPECT_TRUE(handles[0] == NULL);
+  EXPECT_TRUE(handles[items_num - 1] == NULL);
+
+  cache_free(cache, items_num);
+  MEM_CacheLimiter_set_maximum(max_prev);
+}
+
+TEST(cache_limiter, LeastRecentlyUsed)
+{
+  const size_t max_prev = MEM_CacheLimiter_get_maximum();
+  MEM_CacheLimiter_set_maximum(3);
+
+  MEM_CacheLimiterC *cache = cache_new(4);
+
+  for (int i = 0; i < 3; i++) {
+    cache_insert(cache, i);
+  }
+  MEM_CacheLimiter_touch(handles[0]);
+  cache_insert(cache, 3);
+
+  /* Item 1 is the least recently used one. */
+  EXPECT_EQ(items_freed, 1);
+  EXPECT_TRUE(handles[0] != NULL);
+  EXPECT_TRUE(handles[1] == NULL);
+  EXPECT_TRUE(handles[2] != NULL);
+  EXPECT_TRUE(handles[3] != NULL);
+
+  cache_free(cache, 4);
+  MEM_CacheLimiter_set_maximum(max_prev);
+}
+
+TEST(cache_limiter, Insert_Priority_10K)
+{
+  cache_limiter_insert_test(10000, true);
+}
+
+TEST(cache_limiter, Insert_Priority_50K)
+{
+  cache_limiter_insert_test(50000, true);
+}
+
+TEST(cache_limiter, Insert_LeastRecentlyUsed_50K)
+{
+  cache_limiter_insert_test(50000, false);
+}
+
+TEST(cache_limiter, Shrink_Priority_100K)
+{
+  cache_limiter_shrink_test(100000);
+}
@@ -0,0 +1,155 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_cloth.h"
+
+#include "BPH_mass_spring.h"
+#include "implicit.h"
+
+#include "PIL_time.h"
+}
+
+/* Drape a square sheet of cloth pinned at two corners, using the implicit mass-spring solver the
+ * same way the cloth modifier does. The sheet starts out wrinkled so that the springs are not at
+ * rest and the solver has some work to do. */
+
+#define NUM_STEPS 10
+
+typedef struct DrapeSpring {
+  int i, j;
+  float restlen;
+} DrapeSpring;
+
+static void cloth_drape_test_do(const char *id, const int res, const int preconditioner)
+{
+  const int numverts = res * res;
+  const float spacing = 2.0f / (res - 1);
+  const float mass = 0.3f;
+  const float gravity[3] = {0.0f, 0.0f, -9.81f};
+  const float dt = 1.0f / 25.0f / 5.0f;
+  const float zero[3] = {0.0f, 0.0f, 0.0f};
+  float unit[3][3];
+  unit_m3(unit);
+
+  /* Structural and shear springs. */
+  DrapeSpring *springs = (DrapeSpring *)MEM_mallocN(sizeof(DrapeSpring) * numverts * 4, __func__);
+  int numsprings = 0;
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const int i = y * res + x;
+      if (x + 1 < res) {
+        springs[numsprings++] = {i, i + 1, spacing};
+      }
+      if (y + 1 < res) {
+        springs[numsprings++] = {i, i + res, spacing};
+      }
+      if (x + 1 < res && y + 1 < res) {
+        springs[numsprings++] = {i, i + res + 1, spacing * (float)M_SQRT2};
+        springs[numsprings++] = {i + 1, i + res, spacing * (float)M_SQRT2};
+      }
+    }
+  }
+
+  Implicit_Data *data = BPH_mass_spring_solver_create(numverts, numsprings);
+  BPH_mass_spring_solver_set_preconditioner(data, preconditioner);
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const int i = y * res + x;
+      const float co[3] = {
+          x * spacing - 1.0f, y * spacing - 1.0f, 0.05f * sinf(x * 0.7f) * cosf(y * 0.9f)};
+      BPH_mass_spring_set_vertex_mass(data, i, mass);
+      BPH_mass_spring_set_rest_transform(data, i, unit);
+      BPH_mass_spring_set_motion_state(data, i, co, zero);
+    }
+  }
+
+  int iterations = 0;
+  const double init_time = PIL_check_seconds_timer();
+
+  for (int step = 0; step < NUM_STEPS; step++) {
+    ImplicitSolverResult result;
+
+    BPH_mass_spring_clear_constraints(data);
+    BPH_mass_spring_add_constraint_ndof0(data, numverts - res, zero);
+    BPH_mass_spring_add_constraint_ndof0(data, numverts - 1, zero);
+
+    BPH_mass_spring_clear_forces(data);
+    for (int i = 0; i < numverts; i++) {
+      BPH_mass_spring_force_gravity(data, i, mass, gravity);
+    }
+    for (int s = 0; s < numsprings; s++) {
+      BPH_mass_spring_force_spring_linear(data,
+                                          springs[s].i,
+                                          springs[s].j,
+                                          springs[s].restlen,
+                                          15.0f,
+                                          5.0f,
+                                          15.0f,
+                                          5.0f,
+                                          false,
+                                          false,
+                                          0.0f);
+    }
+
+    BPH_mass_spring_solve_velocities(data, dt, &result);
+    BPH_mass_spring_solve_positions(data, dt);
+    BPH_mass_spring_apply_result(data);
+
+    EXPECT_NE(result.status & BPH_SOLVER_SUCCESS, 0);
+    iterations += result.iterations;
+  }
+
+  const double time = PIL_check_seconds_timer() - init_time;
+  printf("\t%s: %d steps in %fs, %.1f solver iterations per step\n",
+         id,
+         NUM_STEPS,
+         time,
+         (float)iterations / NUM_STEPS);
+
+  BPH_mass_spring_solver_free(data);
+  MEM_freeN(springs);
+}
+
+static void cloth_drape_test(const char *id, const int res, const int preconditioner)
+{
+  BLI_threadapi_init();
+  cloth_drape_test_do(id, res, preconditioner);
+  BLI_threadapi_exit();
+}
+
+TEST(cloth, Drape16KNone)
+{
+  cloth_drape_test("Drape - 16K vertices - No preconditioner", 128, CLOTH_PRECONDITIONER_NONE);
+}
+
+TEST(cloth, Drape16KJacobi)
+{
+  cloth_drape_test("Drape - 16K vertices - Jacobi", 128, CLOTH_PRECONDITIONER_JACOBI);
+}
+
+TEST(cloth, Drape16KBlockJacobi)
+{
+  cloth_drape_test(
+      "Drape - 16K vertices - Block Jacobi", 128, CLOTH_PRECONDITIONER_BLOCK_JACOBI);
+}
+
+TEST(cloth, Drape250KNone)
+{
+  cloth_drape_test("Drape - 250K vertices - No preconditioner", 500, CLOTH_PRECONDITIONER_NONE);
+}
+
+TEST(cloth, Drape250KBlockJacobi)
+{
+  cloth_drape_test(
+      "Drape - 250K vertices - Block Jacobi", 500, CLOTH_PRECONDITIONER_BLOCK_JACOBI);
+}